@@ -0,0 +1,309 @@
+// bench.cpp - micro benchmarks for the binding layer
+// built and run by `rocket build.lua bench`
+//
+// usage: bin/bench [--out file.json] [--baseline file.json] [--threshold 0.1]
+//                  [--filter name] [--no-gfx]
+//
+// Every benchmark calls the binding the same way Lua would (through
+// lua_call on the C function), so the numbers include argument checking and
+// result tables. Allocations are counted both in the Lua allocator and in
+// operator new, which catches std::string/std::vector temporaries.
+#include "../funcs.cpp"
+#include "../libs/raylib/raylib.cpp"
+#include "../libs/fs/fs.cpp"
+#include <lua.hpp>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <new>
+#include <string>
+#include <vector>
+
+static uint64_t allocCount = 0;
+static uint64_t allocBytes = 0;
+
+void *operator new(size_t size) {
+    allocCount++;
+    allocBytes += size;
+    void *p = malloc(size);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+void operator delete(void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+void *operator new[](size_t size) { return operator new(size); }
+void operator delete[](void *p) noexcept { free(p); }
+void operator delete[](void *p, size_t) noexcept { free(p); }
+
+static void *countingAlloc(void *ud, void *ptr, size_t osize, size_t nsize) {
+    if (nsize == 0) {
+        free(ptr);
+        return NULL;
+    }
+    // lua passes the type tag in osize when ptr is NULL, only count real growth
+    if (!ptr || nsize > osize) {
+        allocCount++;
+        allocBytes += ptr ? nsize - osize : nsize;
+    }
+    return realloc(ptr, nsize);
+}
+
+struct BenchResult {
+    std::string name;
+    double opsPerSec;
+    double allocsPerOp;
+    double bytesPerOp;
+    uint64_t iterations;
+};
+
+static std::vector<BenchResult> results;
+static const char *filter = NULL;
+
+static double nowSec() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+// Runs `op` in growing batches until at least `minTime` seconds were measured
+static void bench(const std::string &name, const std::function<void(uint64_t)> &op,
+                  double minTime = 0.25) {
+    if (filter && name.find(filter) == std::string::npos) return;
+
+    op(16); // warm up caches and lazily created state
+
+    uint64_t iterations = 64;
+    for (;;) {
+        uint64_t allocs0 = allocCount, bytes0 = allocBytes;
+        double start = nowSec();
+        op(iterations);
+        double elapsed = nowSec() - start;
+        if (elapsed >= minTime || iterations >= (1ull << 32)) {
+            BenchResult r = {name, iterations / elapsed,
+                             (double)(allocCount - allocs0) / iterations,
+                             (double)(allocBytes - bytes0) / iterations, iterations};
+            results.push_back(r);
+            printf("%-32s %14.0f ops/s %8.2f allocs/op %10.1f B/op\n", name.c_str(),
+                   r.opsPerSec, r.allocsPerOp, r.bytesPerOp);
+            return;
+        }
+        iterations *= elapsed > 0.01 ? (uint64_t)(minTime / elapsed) + 1 : 16;
+    }
+}
+
+// Calls `fn` with the values in the registry references `args`
+static void benchCall(lua_State *L, const std::string &name, lua_CFunction fn,
+                      std::vector<int> args, double minTime = 0.25) {
+    bench(name, [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++) {
+            lua_pushcfunction(L, fn);
+            for (int ref : args) lua_rawgeti(L, LUA_REGISTRYINDEX, ref);
+            lua_call(L, (int)args.size(), LUA_MULTRET);
+            lua_settop(L, 0);
+        }
+    }, minTime);
+}
+
+static int refNumber(lua_State *L, double n) {
+    lua_pushnumber(L, n);
+    return luaL_ref(L, LUA_REGISTRYINDEX);
+}
+
+static int refString(lua_State *L, const std::string &s) {
+    lua_pushlstring(L, s.data(), s.size());
+    return luaL_ref(L, LUA_REGISTRYINDEX);
+}
+
+static int refEval(lua_State *L, const char *expr) {
+    std::string chunk = std::string("return ") + expr;
+    if (luaL_dostring(L, chunk.c_str()) != LUA_OK) {
+        fprintf(stderr, "bench: %s\n", lua_tostring(L, -1));
+        exit(1);
+    }
+    return luaL_ref(L, LUA_REGISTRYINDEX);
+}
+
+static void benchVectors(lua_State *L) {
+    int x = refNumber(L, 1.5), y = refNumber(L, -2.5), z = refNumber(L, 3.0);
+    int a2 = refEval(L, "{x = 1, y = 2}"), b2 = refEval(L, "{x = 3, y = 4}");
+    int a3 = refEval(L, "{x = 1, y = 2, z = 3}"), b3 = refEval(L, "{x = 4, y = 5, z = 6}");
+
+    benchCall(L, "Vec2.new", newVec2, {x, y});
+    benchCall(L, "Vec2.add", addVec2, {a2, b2});
+    benchCall(L, "Vec2.sub", subVec2, {a2, b2});
+    benchCall(L, "Vec2.fromVec2ToRadians", fromVec2ToRadians, {a2});
+    benchCall(L, "Vec3.new", newVec3, {x, y, z});
+    benchCall(L, "Vec3.add", addVec3, {a3, b3});
+    benchCall(L, "Vec3.length", vec3Length, {a3});
+}
+
+static void benchColor(lua_State *L) {
+    luaL_dostring(L, "return {r = 10, g = 20, b = 30, a = 255}");
+    volatile unsigned char sink = 0;
+    bench("lua_getColor", [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++) sink = sink + lua_getColor(L, 1).g;
+    });
+    lua_settop(L, 0);
+}
+
+static void benchDraw(lua_State *L) {
+    int x = refNumber(L, 10), y = refNumber(L, 20), w = refNumber(L, 30), h = refNumber(L, 40);
+    int color = refEval(L, "{r = 200, g = 100, b = 50, a = 255}");
+    int rect = refEval(L, "{x = 10, y = 20, width = 30, height = 40}");
+    int text = refString(L, "rocket");
+
+    BeginDrawing();
+    benchCall(L, "DrawRectangle", lua_draw_rectangle, {x, y, w, h, color});
+    benchCall(L, "DrawRectangleRec", lua_draw_rectangle_rect, {rect, color});
+    benchCall(L, "DrawCircle", lua_draw_circle, {x, y, w, color});
+    benchCall(L, "DrawText", lua_draw_text, {text, x, y, h, color});
+    benchCall(L, "MeasureText", lua_measure_text, {text, h});
+    EndDrawing();
+}
+
+static void benchFiles(lua_State *L, bool withGfx) {
+    namespace fs = std::filesystem;
+    fs::path dir = fs::temp_directory_path() / "rocket-bench";
+    fs::create_directories(dir);
+
+    size_t sizes[] = {1 << 10, 64 << 10, 1 << 20, 16 << 20};
+    for (size_t size : sizes) {
+        std::string path = (dir / ("file-" + std::to_string(size))).string();
+        std::string content(size, 'r');
+        std::string label = std::to_string(size >> 10) + "KB";
+
+        int pathRef = refString(L, path), contentRef = refString(L, content);
+        benchCall(L, "fs.writeFile " + label, writeFile, {pathRef, contentRef}, 0.5);
+        benchCall(L, "fs.readFile " + label, readFile, {pathRef}, 0.5);
+    }
+
+    if (withGfx) {
+        std::string png = (dir / "image.png").string();
+        Image img = GenImageColor(256, 256, RED);
+        ExportImage(img, png.c_str());
+        UnloadImage(img);
+
+        int pathRef = refString(L, png);
+        bench("Image.load+unload 256x256", [&](uint64_t n) {
+            for (uint64_t i = 0; i < n; i++) {
+                lua_pushcfunction(L, l_UnloadImage);
+                lua_pushcfunction(L, l_LoadImage);
+                lua_rawgeti(L, LUA_REGISTRYINDEX, pathRef);
+                lua_call(L, 1, 1);
+                lua_call(L, 1, 0);
+            }
+        }, 0.5);
+    }
+
+    fs::remove_all(dir);
+}
+
+static void writeResults(const char *path) {
+    FILE *file = fopen(path, "w");
+    if (!file) {
+        fprintf(stderr, "bench: cannot open '%s' for writing\n", path);
+        return;
+    }
+    // one result per line so compareBaseline can read it back without a JSON parser
+    fprintf(file, "{\n  \"results\": [\n");
+    for (size_t i = 0; i < results.size(); i++) {
+        const BenchResult &r = results[i];
+        fprintf(file,
+                "    {\"name\": \"%s\", \"ops_per_sec\": %.2f, \"allocs_per_op\": %.4f, "
+                "\"bytes_per_op\": %.2f, \"iterations\": %llu}%s\n",
+                r.name.c_str(), r.opsPerSec, r.allocsPerOp, r.bytesPerOp,
+                (unsigned long long)r.iterations, i + 1 < results.size() ? "," : "");
+    }
+    fprintf(file, "  ]\n}\n");
+    fclose(file);
+    printf("results written to %s\n", path);
+}
+
+// returns the number of regressions
+static int compareBaseline(const char *path, double threshold) {
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        printf("no baseline at %s, skipping comparison\n", path);
+        return 0;
+    }
+
+    std::map<std::string, BenchResult> baseline;
+    char line[1024];
+    while (fgets(line, sizeof(line), file)) {
+        char name[256];
+        BenchResult r;
+        if (sscanf(line, " {\"name\": \"%255[^\"]\", \"ops_per_sec\": %lf, \"allocs_per_op\": %lf",
+                   name, &r.opsPerSec, &r.allocsPerOp) == 3) {
+            r.name = name;
+            baseline[name] = r;
+        }
+    }
+    fclose(file);
+
+    int regressions = 0;
+    printf("\ncomparison against %s (threshold %.0f%%)\n", path, threshold * 100);
+    for (const BenchResult &r : results) {
+        auto it = baseline.find(r.name);
+        if (it == baseline.end()) continue;
+        double change = r.opsPerSec / it->second.opsPerSec - 1.0;
+        bool slower = change < -threshold;
+        bool moreAllocs = r.allocsPerOp > it->second.allocsPerOp + 0.01;
+        printf("%-32s %+7.1f%%%s%s\n", r.name.c_str(), change * 100,
+               slower ? "  REGRESSION" : "", moreAllocs ? "  MORE ALLOCATIONS" : "");
+        regressions += slower || moreAllocs;
+    }
+    return regressions;
+}
+
+int main(int argc, char const *argv[]) {
+    const char *out = "bin/bench.json";
+    const char *baseline = NULL;
+    double threshold = 0.10;
+    bool withGfx = true;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) out = argv[++i];
+        else if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc) baseline = argv[++i];
+        else if (strcmp(argv[i], "--threshold") == 0 && i + 1 < argc) threshold = atof(argv[++i]);
+        else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) filter = argv[++i];
+        else if (strcmp(argv[i], "--no-gfx") == 0) withGfx = false;
+        else {
+            printf("Usage: %s [--out file.json] [--baseline file.json] [--threshold 0.1] "
+                   "[--filter name] [--no-gfx]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    lua_State *L = lua_newstate(countingAlloc, NULL);
+    luaL_openlibs(L);
+    luaopen_raylib(L);
+    initFuncs(L);
+
+    if (withGfx) {
+        SetTraceLogLevel(LOG_WARNING);
+        SetConfigFlags(FLAG_WINDOW_HIDDEN);
+        InitWindow(640, 480, "rocket bench");
+        if (!IsWindowReady()) { // no display: rlgl has no context to draw with
+            fprintf(stderr, "bench: no window could be created, running with --no-gfx\n");
+            withGfx = false;
+        }
+    }
+
+    benchVectors(L);
+    benchColor(L);
+    if (withGfx) benchDraw(L);
+    benchFiles(L, withGfx);
+
+    if (withGfx) {
+        l_UnloadAll(L);
+        CloseWindow();
+    }
+    lua_close(L);
+
+    writeResults(out);
+    if (baseline && compareBaseline(baseline, threshold) > 0) return 1;
+    return 0;
+}
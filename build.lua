@@ -88,6 +88,28 @@ local function directoryNeedsRebuild(sourceDir, target)
     return false
 end
 
+-- Headers shared between modules, a change must rebuild every module that
+-- includes them or the .so files disagree on the layouts
+local sharedHeaders = {
+    buffer = "libs/buffer.hpp",
+    lz4 = "libs/lz4.hpp",
+    rtex = "libs/rtex.hpp",
+    pack = "libs/pack/pack.hpp",
+}
+
+local function headersNeedRebuild(target, ...)
+    for _, name in ipairs({...}) do
+        if needsRebuild(sharedHeaders[name], target) then
+            return true
+        end
+    end
+    return false
+end
+
+-- Flags of everything compiling raylib.cpp: rocket, raylib.so and bench, so
+-- the benchmarks measure the code that ships
+local raylibFlags = "-O2"
+
 -- Array to hold targets
 local targets = {}
 
@@ -131,30 +153,65 @@ local function Target(name, dependsOn, fn, description)
 end
 
 -- Define targets
-Target("rocket executable", {"fs.so", "raylib.so","curses.so"}, function()
-    if needsRebuild("main.cpp", "bin/rocket") then
+Target("rocket executable", {"fs.so", "raylib.so","curses.so", "spatial.so", "jobs.so"}, function()
+    if needsRebuild("main.cpp", "bin/rocket") or needsRebuild("funcs.cpp", "bin/rocket")
+        or directoryNeedsRebuild("libs/profiler", "bin/rocket")
+        or directoryNeedsRebuild("libs/raylib/", "bin/rocket") or directoryNeedsRebuild("libs/raygui/", "bin/rocket")
+        or headersNeedRebuild("bin/rocket", "buffer", "lz4", "rtex", "pack") then
         print("Compiling rocket...")
-        runCmd("clang++ main.cpp -o bin/rocket -llua -llua++ -lraylib")
+        runCmd("clang++ " .. raylibFlags .. " main.cpp -o bin/rocket -llua -llua++ -lraylib")
     end
 end, "rocket, or rocket, is a C++ executable that wraps functionality on top of Lua")
 
 -- raylib.cpp includes libs/raygui/raygui.cpp
 -- so you can use it with default Lua
 Target("raylib.so", {}, function()
-    if directoryNeedsRebuild("libs/raylib/", "bin/raylib.so") or directoryNeedsRebuild("libs/raygui/","bin/raylib.so") then
+    if directoryNeedsRebuild("libs/raylib/", "bin/raylib.so") or directoryNeedsRebuild("libs/raygui/","bin/raylib.so")
+        or headersNeedRebuild("bin/raylib.so", "buffer", "lz4", "rtex", "pack") then
         print("Compiling raylib.so...")
-        runCmd("clang++ libs/raylib/raylib.cpp -o bin/raylib.so -shared -fPIC -llua -llua++ -lraylib")
+        runCmd("clang++ " .. raylibFlags .. " libs/raylib/raylib.cpp -o bin/raylib.so -shared -fPIC -llua -llua++ -lraylib")
     end
 end, "Compiles the raylib.so (with raygui) that you can use with default Lua")
 
 
 Target("fs.so", {}, function()
-    if needsRebuild("libs/fs/fs.cpp", "bin/fs.so") then
+    if needsRebuild("libs/fs/fs.cpp", "bin/fs.so") or headersNeedRebuild("bin/fs.so", "buffer", "lz4", "pack") then
         print("Compiling fs.so...")
         runCmd("clang++ libs/fs/fs.cpp -o bin/fs.so -shared -fPIC -llua -llua++")
     end
 end, "Compiles the fs.so that you can use with default Lua")
 
+Target("spatial.so", {}, function()
+    if directoryNeedsRebuild("libs/spatial", "bin/spatial.so") or headersNeedRebuild("bin/spatial.so", "buffer") then
+        print("Compiling spatial.so...")
+        runCmd("clang++ -O2 libs/spatial/spatial.cpp -o bin/spatial.so -shared -fPIC -llua -llua++")
+    end
+end, "Spatial indexes (AABB tree, loose grid) for culling and collision")
+
+Target("jobs.so", {}, function()
+    if directoryNeedsRebuild("libs/jobs", "bin/jobs.so") then
+        print("Compiling jobs.so...")
+        runCmd("clang++ -O2 libs/jobs/jobs.cpp -o bin/jobs.so -shared -fPIC -pthread -llua -llua++")
+    end
+end, "Work-stealing job pool, jobs run in worker Lua states")
+
+Target("texconv", {}, function()
+    if needsRebuild("tools/texconv.cpp", "bin/texconv") or headersNeedRebuild("bin/texconv", "rtex", "lz4") then
+        print("Compiling texconv...")
+        runCmd("clang++ -O2 tools/texconv.cpp -o bin/texconv -lraylib")
+    end
+end, "Offline converter from images to .rtex textures (premultiplied, mipmapped, LZ4), run bin/texconv for usage")
+
+Target("pack", {}, function()
+    if needsRebuild("tools/pack.cpp", "bin/pack") or headersNeedRebuild("bin/pack", "pack", "lz4") then
+        print("Compiling pack...")
+        runCmd("clang++ -O2 tools/pack.cpp -o bin/pack")
+    end
+    if isDirectory("assets") and directoryNeedsRebuild("assets", "bin/assets.pak") then
+        runCmd("bin/pack bin/assets.pak assets")
+    end
+end, "Builds the pack tool and packs assets/ into bin/assets.pak, mount it with Pack.mount")
+
 Target("all", {"rocket executable"}, function()
     -- Placeholder function, as per the original code
 end, "Builds everything")
@@ -168,10 +225,24 @@ end, "Installs rocket")
 
 Target("curses.so", {},function()
     if directoryNeedsRebuild("libs/ncurses","bin/curses.so") then
-        runCmd("clang++ libs/ncurses/curses.cpp -o bin/curses.so -shared -llua -llua++ -lncurses")
+        runCmd("clang++ libs/ncurses/curses.cpp -o bin/curses.so -shared -llua -llua++ -lncursesw")
     end
 end, "ncurses module")
 
+Target("bench", {}, function()
+    if needsRebuild("bench/bench.cpp", "bin/bench") or directoryNeedsRebuild("libs/raylib/", "bin/bench")
+        or directoryNeedsRebuild("libs/raygui/", "bin/bench") or needsRebuild("funcs.cpp", "bin/bench")
+        or needsRebuild("libs/fs/fs.cpp", "bin/bench") or headersNeedRebuild("bin/bench", "buffer", "lz4", "rtex", "pack") then
+        print("Compiling bench...")
+        runCmd("clang++ " .. raylibFlags .. " bench/bench.cpp -o bin/bench -llua -llua++ -lraylib")
+    end
+    local baseline = ""
+    if fileModified("bench/baseline.json") then
+        baseline = " --baseline bench/baseline.json"
+    end
+    runCmd("bin/bench --out bin/bench.json" .. baseline)
+end, "Builds and runs the binding benchmarks, copy bin/bench.json to bench/baseline.json to update the baseline")
+
 Target("clean", {}, function()
     print("Cleaning build artifacts...")
     runCmd("rm -rf bin/*")
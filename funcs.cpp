@@ -1,6 +1,7 @@
 // funcs.cpp - functions that are useful in game development
 #include <cmath>
 #include <lua.hpp>
+#include "libs/buffer.hpp"
 
 // Function to create a new 2D vector in Lua
 int newVec2(lua_State* ctx) {
@@ -239,6 +240,76 @@ int vec3Length(lua_State* ctx) {
     return 1;
 }
 
+// Batch ops over packed vectors in f32 or f64 buffers ({x1, y1, x2, y2, ...}
+// for Vec2, xyz for Vec3). out is an optional buffer of the same type to write
+// into (may be one of the inputs); a new one is made when it's missing.
+enum BatchOp { BATCH_ADD, BATCH_SUB, BATCH_SCALE, BATCH_LENGTH };
+
+template <typename T>
+static void runBatch(BatchOp op, int dims, const T* a, const T* b, T s, T* out, size_t n) {
+    switch (op) {
+    case BATCH_ADD:
+        for (size_t i = 0; i < n * dims; i++) out[i] = a[i] + b[i];
+        break;
+    case BATCH_SUB:
+        for (size_t i = 0; i < n * dims; i++) out[i] = a[i] - b[i];
+        break;
+    case BATCH_SCALE:
+        for (size_t i = 0; i < n * dims; i++) out[i] = a[i] * s;
+        break;
+    case BATCH_LENGTH:
+        for (size_t i = 0; i < n; i++) {
+            T sum = 0;
+            for (int k = 0; k < dims; k++) sum += a[i * dims + k] * a[i * dims + k];
+            out[i] = std::sqrt(sum);
+        }
+        break;
+    }
+}
+
+// Vec.xBatch(a, b|scale[, out]) or Vec.lengthBatch(a[, out]) -> out
+static int vecBatch(lua_State* ctx, BatchOp op, int dims) {
+    Buffer* a = checkBuffer(ctx, 1);
+    luaL_argcheck(ctx, a->type == BUFFER_F32 || a->type == BUFFER_F64, 1, "f32 or f64 buffer expected");
+    luaL_argcheck(ctx, a->count % dims == 0, 1, "size is not a multiple of the vector size");
+    size_t n = a->count / dims;
+
+    Buffer* b = nullptr;
+    double scale = 0;
+    int outArg = op == BATCH_LENGTH ? 2 : 3;
+    if (op == BATCH_ADD || op == BATCH_SUB) {
+        b = checkBufferType(ctx, 2, a->type);
+        luaL_argcheck(ctx, b->count == a->count, 2, "buffers differ in size");
+    } else if (op == BATCH_SCALE) {
+        scale = luaL_checknumber(ctx, 2);
+    }
+
+    size_t outCount = op == BATCH_LENGTH ? n : a->count;
+    Buffer* out;
+    if (lua_isnoneornil(ctx, outArg)) {
+        out = pushNewBuffer(ctx, a->type, outCount);
+    } else {
+        out = checkBufferType(ctx, outArg, a->type);
+        luaL_argcheck(ctx, out->count == outCount, outArg, "output buffer has the wrong size");
+        lua_pushvalue(ctx, outArg);
+    }
+
+    if (a->type == BUFFER_F32)
+        runBatch<float>(op, dims, a->as<float>(), b ? b->as<float>() : nullptr, (float)scale, out->as<float>(), n);
+    else
+        runBatch<double>(op, dims, a->as<double>(), b ? b->as<double>() : nullptr, scale, out->as<double>(), n);
+    return 1;
+}
+
+int vec2AddBatch(lua_State* ctx) { return vecBatch(ctx, BATCH_ADD, 2); }
+int vec2SubBatch(lua_State* ctx) { return vecBatch(ctx, BATCH_SUB, 2); }
+int vec2ScaleBatch(lua_State* ctx) { return vecBatch(ctx, BATCH_SCALE, 2); }
+int vec2LengthBatch(lua_State* ctx) { return vecBatch(ctx, BATCH_LENGTH, 2); }
+int vec3AddBatch(lua_State* ctx) { return vecBatch(ctx, BATCH_ADD, 3); }
+int vec3SubBatch(lua_State* ctx) { return vecBatch(ctx, BATCH_SUB, 3); }
+int vec3ScaleBatch(lua_State* ctx) { return vecBatch(ctx, BATCH_SCALE, 3); }
+int vec3LengthBatch(lua_State* ctx) { return vecBatch(ctx, BATCH_LENGTH, 3); }
+
 void initVec3(lua_State* L) {
     lua_newtable(L);
     lua_pushcfunction(L, newVec3);
@@ -249,6 +320,14 @@ void initVec3(lua_State* L) {
     lua_setfield(L, -2, "sub");
     lua_pushcfunction(L, vec3Length);
     lua_setfield(L, -2, "length");
+    lua_pushcfunction(L, vec3AddBatch);
+    lua_setfield(L, -2, "addBatch");
+    lua_pushcfunction(L, vec3SubBatch);
+    lua_setfield(L, -2, "subBatch");
+    lua_pushcfunction(L, vec3ScaleBatch);
+    lua_setfield(L, -2, "scaleBatch");
+    lua_pushcfunction(L, vec3LengthBatch);
+    lua_setfield(L, -2, "lengthBatch");
     lua_setglobal(L, "Vec3");
 }
 
@@ -265,11 +344,20 @@ void initVec2(lua_State* L) {
     lua_setfield(L, -2, "fromVec2ToRadians");
     lua_pushcfunction(L, fromRadiansToVec2);
     lua_setfield(L, -2, "fromRadiansToVec2");
+    lua_pushcfunction(L, vec2AddBatch);
+    lua_setfield(L, -2, "addBatch");
+    lua_pushcfunction(L, vec2SubBatch);
+    lua_setfield(L, -2, "subBatch");
+    lua_pushcfunction(L, vec2ScaleBatch);
+    lua_setfield(L, -2, "scaleBatch");
+    lua_pushcfunction(L, vec2LengthBatch);
+    lua_setfield(L, -2, "lengthBatch");
 
     lua_setglobal(L, "Vec2");
 }
 
 void initFuncs(lua_State* L) {
+    registerBufferClass(L);
     initVec2(L);
     initVec3(L);
 }
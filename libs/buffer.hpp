@@ -0,0 +1,351 @@
+// buffer.hpp - Buffer: typed binary data shared by every native module
+// A Buffer is a typed view (u8, i32, f32, f64) over refcounted storage.
+// Slices and views share that storage, nothing is copied. fs reads files into
+// buffers, Image makes textures from them, and the Vec batch ops and Spatial
+// queries read and write them. Header only: each module that uses buffers
+// includes it and calls registerBufferClass; the metatable is looked up by
+// name, so a buffer made by one .so works in all the others.
+//
+//   local b = Buffer.new("f32", 1024)
+//   b[1] = 0.5
+//   local xy = b:slice(1, 512)      -- same memory
+//   local bytes = b:view("u8")      -- same memory, 4096 bytes
+#pragma once
+#include <lua.hpp>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#define BUFFER_METATABLE "rocket.Buffer"
+
+enum BufferType { BUFFER_U8, BUFFER_I32, BUFFER_F32, BUFFER_F64 };
+
+static const char* const bufferTypeNames[] = { "u8", "i32", "f32", "f64", NULL };
+static const size_t bufferTypeSizes[] = { 1, 4, 4, 8 };
+
+// malloc/free on purpose: storage made by one module may be released by another
+struct BufferStorage {
+    std::atomic<int> refs;
+    size_t size;
+    unsigned char* data;
+};
+
+// Lives directly in the userdata
+struct Buffer {
+    BufferStorage* storage;
+    size_t offset; // in bytes
+    size_t count;  // in elements
+    int type;
+
+    unsigned char* bytes() const { return storage->data + offset; }
+    size_t byteSize() const { return count * bufferTypeSizes[type]; }
+    template <typename T> T* as() const { return (T*)bytes(); }
+};
+
+inline BufferStorage* newBufferStorage(size_t size) {
+    BufferStorage* s = (BufferStorage*)malloc(sizeof(BufferStorage));
+    if (!s) return nullptr;
+    s->data = (unsigned char*)calloc(size ? size : 1, 1);
+    if (!s->data) {
+        free(s);
+        return nullptr;
+    }
+    new (&s->refs) std::atomic<int>(1);
+    s->size = size;
+    return s;
+}
+
+inline void releaseBufferStorage(BufferStorage* s) {
+    if (s && --s->refs == 0) {
+        free(s->data);
+        free(s);
+    }
+}
+
+// Pushes a view over s, taking a new reference to it
+inline Buffer* pushBufferView(lua_State* L, BufferStorage* s, size_t offset, size_t count, int type) {
+    Buffer* b = (Buffer*)lua_newuserdatauv(L, sizeof(Buffer), 0);
+    s->refs++;
+    *b = Buffer{ s, offset, count, type };
+    luaL_setmetatable(L, BUFFER_METATABLE);
+    return b;
+}
+
+// Largest element count of a buffer of the given type, so its byte size fits a size_t
+inline size_t bufferMaxCount(int type) {
+    return SIZE_MAX / bufferTypeSizes[type];
+}
+
+// Pushes a new zeroed buffer of count elements, errors when out of memory
+inline Buffer* pushNewBuffer(lua_State* L, int type, size_t count) {
+    if (count > bufferMaxCount(type))
+        luaL_error(L, "buffer of %I elements is too large", (lua_Integer)count);
+    BufferStorage* s = newBufferStorage(count * bufferTypeSizes[type]);
+    if (!s) luaL_error(L, "not enough memory for a buffer of %I elements", (lua_Integer)count);
+    Buffer* b = pushBufferView(L, s, 0, count, type);
+    releaseBufferStorage(s); // the view holds the only reference
+    return b;
+}
+
+inline Buffer* testBuffer(lua_State* L, int idx) {
+    return (Buffer*)luaL_testudata(L, idx, BUFFER_METATABLE);
+}
+
+inline Buffer* checkBuffer(lua_State* L, int idx) {
+    return (Buffer*)luaL_checkudata(L, idx, BUFFER_METATABLE);
+}
+
+// Like checkBuffer, but also requires the given element type
+inline Buffer* checkBufferType(lua_State* L, int idx, int type) {
+    Buffer* b = checkBuffer(L, idx);
+    if (b->type != type)
+        luaL_error(L, "bad argument #%d (%s buffer expected, got %s)", idx, bufferTypeNames[type], bufferTypeNames[b->type]);
+    return b;
+}
+
+inline lua_Number bufferGet(const Buffer* b, size_t i) {
+    switch (b->type) {
+    case BUFFER_U8: return b->as<uint8_t>()[i];
+    case BUFFER_I32: return b->as<int32_t>()[i];
+    case BUFFER_F32: return b->as<float>()[i];
+    default: return b->as<double>()[i];
+    }
+}
+
+inline void bufferSet(Buffer* b, size_t i, lua_Number v) {
+    switch (b->type) {
+    case BUFFER_U8: b->as<uint8_t>()[i] = (uint8_t)(int64_t)v; break;
+    case BUFFER_I32: b->as<int32_t>()[i] = (int32_t)(int64_t)v; break;
+    case BUFFER_F32: b->as<float>()[i] = (float)v; break;
+    default: b->as<double>()[i] = v; break;
+    }
+}
+
+inline void bufferPushValue(lua_State* L, const Buffer* b, size_t i) {
+    if (b->type == BUFFER_U8 || b->type == BUFFER_I32) lua_pushinteger(L, (lua_Integer)bufferGet(b, i));
+    else lua_pushnumber(L, bufferGet(b, i));
+}
+
+// buffer:slice(first[, last]) -> view of elements first..last, shares memory
+inline int l_BufferSlice(lua_State* L) {
+    Buffer* b = checkBuffer(L, 1);
+    lua_Integer n = (lua_Integer)b->count;
+    lua_Integer first = luaL_checkinteger(L, 2);
+    lua_Integer last = luaL_optinteger(L, 3, n);
+    luaL_argcheck(L, first >= 1, 2, "out of range");
+    luaL_argcheck(L, last <= n, 3, "out of range");
+    size_t count = last >= first ? (size_t)(last - first + 1) : 0;
+    pushBufferView(L, b->storage, b->offset + (first - 1) * bufferTypeSizes[b->type], count, b->type);
+    return 1;
+}
+
+// buffer:view(type[, byteOffset, count]) -> the same bytes as another type
+inline int l_BufferView(lua_State* L) {
+    Buffer* b = checkBuffer(L, 1);
+    int type = luaL_checkoption(L, 2, NULL, bufferTypeNames);
+    size_t size = bufferTypeSizes[type];
+    lua_Integer byteOffset = luaL_optinteger(L, 3, 0);
+    luaL_argcheck(L, byteOffset >= 0 && (size_t)byteOffset <= b->byteSize(), 3, "out of range");
+    size_t offset = b->offset + byteOffset;
+    luaL_argcheck(L, offset % size == 0, 3, "misaligned for this type");
+    size_t fits = (b->byteSize() - byteOffset) / size;
+    lua_Integer count = luaL_optinteger(L, 4, (lua_Integer)fits);
+    luaL_argcheck(L, count >= 0 && (size_t)count <= fits, 4, "out of range");
+    pushBufferView(L, b->storage, offset, count, type);
+    return 1;
+}
+
+// buffer:copy() -> new buffer with its own storage
+inline int l_BufferCopy(lua_State* L) {
+    Buffer* b = checkBuffer(L, 1);
+    Buffer* c = pushNewBuffer(L, b->type, b->count);
+    memcpy(c->bytes(), b->bytes(), b->byteSize());
+    return 1;
+}
+
+// buffer:fill(value[, first, last])
+inline int l_BufferFill(lua_State* L) {
+    Buffer* b = checkBuffer(L, 1);
+    lua_Number v = luaL_checknumber(L, 2);
+    lua_Integer first = luaL_optinteger(L, 3, 1);
+    lua_Integer last = luaL_optinteger(L, 4, (lua_Integer)b->count);
+    first = first < 1 ? 1 : first;
+    last = last > (lua_Integer)b->count ? (lua_Integer)b->count : last;
+    for (lua_Integer i = first; i <= last; i++) bufferSet(b, i - 1, v);
+    return 0;
+}
+
+// buffer:set(source[, at]) - copies a table of numbers or a buffer of the same type in at `at`
+inline int l_BufferSet(lua_State* L) {
+    Buffer* b = checkBuffer(L, 1);
+    lua_Integer at = luaL_optinteger(L, 3, 1);
+    luaL_argcheck(L, at >= 1 && (size_t)at <= b->count + 1, 3, "out of range");
+    size_t room = b->count - (at - 1);
+    if (Buffer* src = testBuffer(L, 2)) {
+        luaL_argcheck(L, src->type == b->type, 2, "buffer types differ, use view()");
+        size_t n = src->count < room ? src->count : room;
+        memmove(b->bytes() + (at - 1) * bufferTypeSizes[b->type], src->bytes(), n * bufferTypeSizes[b->type]);
+        return 0;
+    }
+    luaL_checktype(L, 2, LUA_TTABLE);
+    size_t n = lua_rawlen(L, 2);
+    if (n > room) n = room;
+    for (size_t i = 0; i < n; i++) {
+        lua_rawgeti(L, 2, i + 1);
+        bufferSet(b, at - 1 + i, lua_tonumber(L, -1));
+        lua_pop(L, 1);
+    }
+    return 0;
+}
+
+// buffer:toTable() -> { ... }
+inline int l_BufferToTable(lua_State* L) {
+    Buffer* b = checkBuffer(L, 1);
+    lua_createtable(L, (int)b->count, 0);
+    for (size_t i = 0; i < b->count; i++) {
+        bufferPushValue(L, b, i);
+        lua_rawseti(L, -2, i + 1);
+    }
+    return 1;
+}
+
+// buffer:toString() -> the raw bytes
+inline int l_BufferToString(lua_State* L) {
+    Buffer* b = checkBuffer(L, 1);
+    lua_pushlstring(L, (const char*)b->bytes(), b->byteSize());
+    return 1;
+}
+
+inline int l_BufferType(lua_State* L) {
+    lua_pushstring(L, bufferTypeNames[checkBuffer(L, 1)->type]);
+    return 1;
+}
+
+inline int l_BufferByteSize(lua_State* L) {
+    lua_pushinteger(L, checkBuffer(L, 1)->byteSize());
+    return 1;
+}
+
+inline int l_BufferLen(lua_State* L) {
+    lua_pushinteger(L, checkBuffer(L, 1)->count);
+    return 1;
+}
+
+// b[i] reads element i (1 based), names look up methods
+inline int l_BufferIndex(lua_State* L) {
+    Buffer* b = checkBuffer(L, 1);
+    if (lua_type(L, 2) == LUA_TNUMBER) {
+        lua_Integer i = lua_tointeger(L, 2);
+        if (i < 1 || (size_t)i > b->count) return 0;
+        bufferPushValue(L, b, i - 1);
+        return 1;
+    }
+    lua_getmetatable(L, 1);
+    lua_getfield(L, -1, "methods");
+    lua_pushvalue(L, 2);
+    lua_rawget(L, -2);
+    return 1;
+}
+
+inline int l_BufferNewIndex(lua_State* L) {
+    Buffer* b = checkBuffer(L, 1);
+    lua_Integer i = luaL_checkinteger(L, 2);
+    luaL_argcheck(L, i >= 1 && (size_t)i <= b->count, 2, "index out of range");
+    bufferSet(b, i - 1, luaL_checknumber(L, 3));
+    return 0;
+}
+
+inline int l_BufferGC(lua_State* L) {
+    Buffer* b = checkBuffer(L, 1);
+    releaseBufferStorage(b->storage);
+    b->storage = nullptr;
+    return 0;
+}
+
+inline int l_BufferToStringMeta(lua_State* L) {
+    Buffer* b = checkBuffer(L, 1);
+    lua_pushfstring(L, "Buffer(%s, %d)", bufferTypeNames[b->type], (int)b->count);
+    return 1;
+}
+
+// Safe to call from every module, only the first call creates the metatable
+inline void registerBufferClass(lua_State* L) {
+    if (luaL_newmetatable(L, BUFFER_METATABLE)) {
+        static luaL_Reg methods[] = {
+            { "slice", l_BufferSlice },
+            { "view", l_BufferView },
+            { "copy", l_BufferCopy },
+            { "fill", l_BufferFill },
+            { "set", l_BufferSet },
+            { "toTable", l_BufferToTable },
+            { "toString", l_BufferToString },
+            { "type", l_BufferType },
+            { "byteSize", l_BufferByteSize },
+            { NULL, NULL }
+        };
+        lua_newtable(L);
+        luaL_setfuncs(L, methods, 0);
+        lua_setfield(L, -2, "methods");
+
+        static luaL_Reg meta[] = {
+            { "__index", l_BufferIndex },
+            { "__newindex", l_BufferNewIndex },
+            { "__len", l_BufferLen },
+            { "__gc", l_BufferGC },
+            { "__tostring", l_BufferToStringMeta },
+            { NULL, NULL }
+        };
+        luaL_setfuncs(L, meta, 0);
+    }
+    lua_pop(L, 1);
+}
+
+// Buffer.new(type, count)
+inline int l_BufferNew(lua_State* L) {
+    int type = luaL_checkoption(L, 1, NULL, bufferTypeNames);
+    lua_Integer count = luaL_checkinteger(L, 2);
+    luaL_argcheck(L, count >= 0, 2, "count must not be negative");
+    luaL_argcheck(L, (lua_Unsigned)count <= bufferMaxCount(type), 2, "count is too large");
+    pushNewBuffer(L, type, (size_t)count);
+    return 1;
+}
+
+// Buffer.fromString(bytes[, type]) - copies the bytes, the length must fit the type
+inline int l_BufferFromString(lua_State* L) {
+    size_t len;
+    const char* s = luaL_checklstring(L, 1, &len);
+    int type = luaL_checkoption(L, 2, "u8", bufferTypeNames);
+    luaL_argcheck(L, len % bufferTypeSizes[type] == 0, 1, "length is not a multiple of the element size");
+    Buffer* b = pushNewBuffer(L, type, len / bufferTypeSizes[type]);
+    memcpy(b->bytes(), s, len);
+    return 1;
+}
+
+// Buffer.fromTable(type, { ... })
+inline int l_BufferFromTable(lua_State* L) {
+    int type = luaL_checkoption(L, 1, NULL, bufferTypeNames);
+    luaL_checktype(L, 2, LUA_TTABLE);
+    size_t n = lua_rawlen(L, 2);
+    Buffer* b = pushNewBuffer(L, type, n);
+    for (size_t i = 0; i < n; i++) {
+        lua_rawgeti(L, 2, i + 1);
+        bufferSet(b, i, lua_tonumber(L, -1));
+        lua_pop(L, 1);
+    }
+    return 1;
+}
+
+// Pushes the Buffer module table
+inline void pushBufferModule(lua_State* L) {
+    registerBufferClass(L);
+    static luaL_Reg funcs[] = {
+        { "new", l_BufferNew },
+        { "fromString", l_BufferFromString },
+        { "fromTable", l_BufferFromTable },
+        { NULL, NULL }
+    };
+    lua_newtable(L);
+    luaL_setfuncs(L, funcs, 0);
+}
@@ -4,19 +4,23 @@
 #include <cstdio>
 #include <cstring>
 #include <filesystem>
+#include "../buffer.hpp"
+#include "../pack/pack.hpp"
 
+// fs.writeFile(path, content), content is a string or a Buffer (written as raw bytes)
 static int writeFile(lua_State* L) {
     const char* filename = lua_tostring(L, 1);
-    const char* content = lua_tostring(L, 2);
+    Buffer* buf = testBuffer(L, 2);
+    const char* content = buf ? (const char*)buf->bytes() : lua_tostring(L, 2);
+    size_t len = buf ? buf->byteSize() : strlen(content);
 
-    FILE* file = fopen(filename, "w");
+    FILE* file = fopen(filename, buf ? "wb" : "w");
     if (!file) {
         lua_pushboolean(L, 0);
         lua_pushfstring(L, "Cannot open file '%s' for writing", filename);
         return 2;
     }
 
-    size_t len = strlen(content);
     size_t written = fwrite(content, sizeof(char), len, file);
     fclose(file);
 
@@ -29,9 +33,16 @@ static int writeFile(lua_State* L) {
         return 2;
     }
 }
+// fs.readFile(path) reads from the mounted packs first, see Pack.mount
 static int readFile(lua_State* L) {
     const char* filename = lua_tostring(L, 1);
 
+    PackData packed;
+    if (filename && packRead(filename, &packed)) {
+        lua_pushlstring(L, (const char*)packed.data, packed.size);
+        return 1;
+    }
+
     std::ifstream file(filename);
     if (!file.is_open()) {
         lua_pushnil(L);
@@ -47,6 +58,53 @@ static int readFile(lua_State* L) {
     return 1;
 }
 
+// fs.readBuffer(path[, type]) -> Buffer holding the file's bytes, read straight
+// into the buffer's memory (type defaults to "u8", the size must fit it).
+// Mounted packs are searched first, like readFile.
+static int readBuffer(lua_State* L) {
+    const char* filename = luaL_checkstring(L, 1);
+    int type = luaL_checkoption(L, 2, "u8", bufferTypeNames);
+
+    PackData packed;
+    if (packRead(filename, &packed)) {
+        if (packed.size % bufferTypeSizes[type] != 0) {
+            lua_pushnil(L);
+            lua_pushfstring(L, "Size of '%s' is not a multiple of %s", filename, bufferTypeNames[type]);
+            return 2;
+        }
+        Buffer* buf = pushNewBuffer(L, type, packed.size / bufferTypeSizes[type]);
+        memcpy(buf->bytes(), packed.data, packed.size);
+        return 1;
+    }
+
+    FILE* file = fopen(filename, "rb");
+    if (!file) {
+        lua_pushnil(L);
+        lua_pushfstring(L, "Cannot open file '%s'", filename);
+        return 2;
+    }
+
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    if (size < 0 || size % bufferTypeSizes[type] != 0) {
+        fclose(file);
+        lua_pushnil(L);
+        lua_pushfstring(L, "Size of '%s' is not a multiple of %s", filename, bufferTypeNames[type]);
+        return 2;
+    }
+
+    Buffer* buf = pushNewBuffer(L, type, size / bufferTypeSizes[type]);
+    size_t got = fread(buf->bytes(), 1, size, file);
+    fclose(file);
+    if (got != (size_t)size) {
+        lua_pushnil(L);
+        lua_pushfstring(L, "Error reading file '%s'", filename);
+        return 2;
+    }
+    return 1;
+}
+
 static int readDir(lua_State* L) {
     const char* path = lua_tostring(L, 1);
     lua_newtable(L);
@@ -67,11 +125,13 @@ static int removeFile(lua_State* L) {
 
 static int fileExists(lua_State* L) {
     const char* filename = luaL_checkstring(L, 1);
-    lua_pushboolean(L, std::filesystem::exists(filename));
+    lua_pushboolean(L, packExists(filename) || std::filesystem::exists(filename));
     return 1;
 }
 
 extern "C" int luaopen_fs(lua_State* L) {
+    registerBufferClass(L);
+    packInit(L);
     lua_newtable(L);
 
     lua_pushcfunction(L, readFile);
@@ -80,6 +140,9 @@ extern "C" int luaopen_fs(lua_State* L) {
     lua_pushcfunction(L, writeFile);
     lua_setfield(L, -2, "writeFile");
 
+    lua_pushcfunction(L, readBuffer);
+    lua_setfield(L, -2, "readBuffer");
+
     lua_pushcfunction(L, readDir);
     lua_setfield(L, -2, "readDir");
 
@@ -89,5 +152,11 @@ extern "C" int luaopen_fs(lua_State* L) {
     lua_pushcfunction(L, fileExists);
     lua_setfield(L, -2, "fileExists");
 
+    lua_pushcfunction(L, l_PackMount);
+    lua_setfield(L, -2, "mount");
+
+    lua_pushcfunction(L, l_PackUnmount);
+    lua_setfield(L, -2, "unmount");
+
     return 1;
 }
@@ -0,0 +1,574 @@
+// jobs.cpp - work-stealing job pool, every worker thread runs its own lua_State
+// The main state keeps rendering while pathfinding, generation or parsing
+// runs on the other cores.
+//
+//   local jobs = require("jobs")
+//   local job = jobs.spawn(function(grid, from, to) ... return path end, grid, a, b)
+//   ...
+//   if job:done() then path = job:wait() end -- or jobs.wait(list) to block for several
+//
+// Functions are sent as bytecode (string.dump), so they can not capture
+// upvalues; pass what they need as arguments. Arguments and results are copied
+// (nil, booleans, numbers, strings, tables), except shared buffers from
+// jobs.share(str), which every state reads in place without a copy.
+#include <lua.hpp>
+#include "../../../libs/lua_ffi.hpp" // pushPtr, getPtr, push_funcs
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#define JOBS_MAX_DEPTH 64     // nested tables deeper than this are rejected (and cycles with them)
+#define JOBS_CHUNK_CACHE 256  // compiled job functions kept per worker
+
+// Immutable bytes shared between states, freed with the last reference
+struct SharedBlob {
+    std::shared_ptr<const std::string> data;
+};
+
+// Values copied between states
+struct JobMessage {
+    std::string data;
+    std::vector<std::shared_ptr<const std::string>> shared; // referenced by index from data
+    int count = 0;
+};
+
+struct Job {
+    std::string code; // bytecode or Lua source
+    JobMessage args;
+    JobMessage results;
+    std::string error;
+    bool done = false; // guarded by JobPool::mutex
+};
+
+// What the Lua userdata holds, the pool keeps its own reference while the job runs
+struct JobHandle {
+    std::shared_ptr<Job> job;
+};
+
+struct Worker {
+    std::thread thread;
+    std::mutex mutex; // guards queue, taken by the owner and by thieves
+    std::deque<std::shared_ptr<Job>> queue;
+    lua_State* L = nullptr;
+    std::unordered_map<std::string, int> chunks; // code -> registry ref of the loaded function
+};
+
+struct JobPool {
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::mutex mutex;
+    std::condition_variable wake;     // idle workers sleep here
+    std::condition_variable finished; // jobs.wait sleeps here
+    std::atomic<int> queued{0};
+    unsigned next = 0; // round robin target for new jobs
+    bool stopping = false;
+
+    ~JobPool();
+};
+
+static JobPool jobPool;
+
+// ─── Serialization ──────────────────────────────────────────────────────────
+
+enum : uint8_t { TAG_NIL, TAG_FALSE, TAG_TRUE, TAG_INT, TAG_NUM, TAG_STR, TAG_TABLE, TAG_END, TAG_SHARED };
+
+template <typename T>
+static void putRaw(std::string& out, T v) {
+    out.append((const char*)&v, sizeof(v));
+}
+
+// Appends the value at idx, returns an error message or nullptr
+static const char* serializeValue(lua_State* L, int idx, JobMessage& msg, int depth) {
+    idx = lua_absindex(L, idx);
+    switch (lua_type(L, idx)) {
+    case LUA_TNIL:
+        msg.data.push_back(TAG_NIL);
+        return nullptr;
+    case LUA_TBOOLEAN:
+        msg.data.push_back(lua_toboolean(L, idx) ? TAG_TRUE : TAG_FALSE);
+        return nullptr;
+    case LUA_TNUMBER:
+        if (lua_isinteger(L, idx)) {
+            msg.data.push_back(TAG_INT);
+            putRaw<int64_t>(msg.data, lua_tointeger(L, idx));
+        } else {
+            msg.data.push_back(TAG_NUM);
+            putRaw<double>(msg.data, lua_tonumber(L, idx));
+        }
+        return nullptr;
+    case LUA_TSTRING: {
+        size_t len;
+        const char* s = lua_tolstring(L, idx, &len);
+        msg.data.push_back(TAG_STR);
+        putRaw<uint64_t>(msg.data, len);
+        msg.data.append(s, len);
+        return nullptr;
+    }
+    case LUA_TTABLE: {
+        if (depth >= JOBS_MAX_DEPTH) return "table nested too deep (or cyclic)";
+        if (!lua_checkstack(L, 3)) return "stack overflow";
+        msg.data.push_back(TAG_TABLE);
+        lua_pushnil(L);
+        while (lua_next(L, idx)) {
+            const char* err = serializeValue(L, -2, msg, depth + 1);
+            if (!err) err = serializeValue(L, -1, msg, depth + 1);
+            if (err) {
+                lua_pop(L, 2);
+                return err;
+            }
+            lua_pop(L, 1);
+        }
+        msg.data.push_back(TAG_END);
+        return nullptr;
+    }
+    case LUA_TUSERDATA: {
+        void* ud = luaL_testudata(L, idx, typeid(SharedBlob).name());
+        if (!ud) break;
+        SharedBlob* b = *(SharedBlob**)ud; // pushPtr stores the pointer
+        msg.data.push_back(TAG_SHARED);
+        putRaw<uint32_t>(msg.data, (uint32_t)msg.shared.size());
+        msg.shared.push_back(b->data);
+        return nullptr;
+    }
+    }
+    return "only nil, booleans, numbers, strings, tables and shared buffers can be passed";
+}
+
+// Serializes count values starting at first
+static const char* serializeValues(lua_State* L, int first, int count, JobMessage& msg) {
+    msg.data.clear();
+    msg.shared.clear();
+    msg.count = count;
+    for (int i = 0; i < count; i++) {
+        const char* err = serializeValue(L, first + i, msg, 0);
+        if (err) return err;
+    }
+    return nullptr;
+}
+
+static void pushSharedBlob(lua_State* L, std::shared_ptr<const std::string> data);
+
+template <typename T>
+static T getRaw(const char*& p) {
+    T v;
+    memcpy(&v, p, sizeof(v));
+    p += sizeof(v);
+    return v;
+}
+
+// Pushes one value; the data was written by serializeValue, so it is trusted
+static void deserializeValue(lua_State* L, const char*& p, const JobMessage& msg) {
+    luaL_checkstack(L, 3, "nested too deep");
+    switch ((uint8_t)*p++) {
+    case TAG_NIL: lua_pushnil(L); break;
+    case TAG_FALSE: lua_pushboolean(L, 0); break;
+    case TAG_TRUE: lua_pushboolean(L, 1); break;
+    case TAG_INT: lua_pushinteger(L, getRaw<int64_t>(p)); break;
+    case TAG_NUM: lua_pushnumber(L, getRaw<double>(p)); break;
+    case TAG_STR: {
+        uint64_t len = getRaw<uint64_t>(p);
+        lua_pushlstring(L, p, len);
+        p += len;
+        break;
+    }
+    case TAG_TABLE:
+        lua_newtable(L);
+        while ((uint8_t)*p != TAG_END) {
+            deserializeValue(L, p, msg);
+            deserializeValue(L, p, msg);
+            lua_rawset(L, -3);
+        }
+        p++;
+        break;
+    case TAG_SHARED:
+        pushSharedBlob(L, msg.shared[getRaw<uint32_t>(p)]);
+        break;
+    }
+}
+
+static void deserializeValues(lua_State* L, const JobMessage& msg) {
+    const char* p = msg.data.data();
+    for (int i = 0; i < msg.count; i++) deserializeValue(L, p, msg);
+}
+
+// ─── Shared buffers ─────────────────────────────────────────────────────────
+
+static void pushSharedBlob(lua_State* L, std::shared_ptr<const std::string> data) {
+    pushPtr(L, new SharedBlob{ std::move(data) });
+}
+
+// jobs.share(str) -> shared buffer, passed to jobs by reference
+static int l_JobsShare(lua_State* L) {
+    size_t len;
+    const char* s = luaL_checklstring(L, 1, &len);
+    pushSharedBlob(L, std::make_shared<const std::string>(s, len));
+    return 1;
+}
+
+static int l_SharedSize(lua_State* L) {
+    lua_pushinteger(L, getPtr<SharedBlob>(L, 1)->data->size());
+    return 1;
+}
+
+// shared:sub(i[, j]) - same indices as string.sub
+static int l_SharedSub(lua_State* L) {
+    const std::string& s = *getPtr<SharedBlob>(L, 1)->data;
+    lua_Integer len = (lua_Integer)s.size();
+    lua_Integer i = luaL_checkinteger(L, 2);
+    lua_Integer j = luaL_optinteger(L, 3, -1);
+    if (i < 0) i = std::max<lua_Integer>(len + i + 1, 1);
+    else if (i == 0) i = 1;
+    if (j < 0) j = len + j + 1;
+    else if (j > len) j = len;
+    if (i > j) lua_pushliteral(L, "");
+    else lua_pushlstring(L, s.data() + i - 1, (size_t)(j - i + 1));
+    return 1;
+}
+
+// shared:byte(i) -> byte at i (1 based), nil past the end
+static int l_SharedByte(lua_State* L) {
+    const std::string& s = *getPtr<SharedBlob>(L, 1)->data;
+    lua_Integer i = luaL_checkinteger(L, 2);
+    if (i < 1 || i > (lua_Integer)s.size()) return 0;
+    lua_pushinteger(L, (unsigned char)s[i - 1]);
+    return 1;
+}
+
+static int l_SharedToString(lua_State* L) {
+    const std::string& s = *getPtr<SharedBlob>(L, 1)->data;
+    lua_pushlstring(L, s.data(), s.size());
+    return 1;
+}
+
+static int l_SharedGC(lua_State* L) {
+    delete getPtr<SharedBlob>(L, 1);
+    return 0;
+}
+
+// used by the main state and every worker state
+static void registerSharedBlobClass(lua_State* L) {
+    const char* type = typeid(SharedBlob).name();
+    if (luaL_newmetatable(L, type)) {
+        lua_pushstring(L, "__index");
+        lua_newtable(L);
+
+        static luaL_Reg methods[] = {
+            { "size", l_SharedSize },
+            { "sub", l_SharedSub },
+            { "byte", l_SharedByte },
+            { "tostring", l_SharedToString },
+            { NULL, NULL }
+        };
+        push_funcs(L, methods);
+        lua_settable(L, -3); // metatable.__index = table
+
+        lua_pushcfunction(L, l_SharedSize);
+        lua_setfield(L, -2, "__len");
+        lua_pushcfunction(L, l_SharedGC);
+        lua_setfield(L, -2, "__gc");
+    }
+    lua_pop(L, 1);
+}
+
+// ─── Workers ────────────────────────────────────────────────────────────────
+
+// Pushes the job function, loading it once per worker
+static bool workerLoadChunk(Worker& w, const std::string& code, std::string& error) {
+    auto it = w.chunks.find(code);
+    if (it != w.chunks.end()) {
+        lua_rawgeti(w.L, LUA_REGISTRYINDEX, it->second);
+        return true;
+    }
+    if (luaL_loadbuffer(w.L, code.data(), code.size(), "=job") != LUA_OK) {
+        error = lua_tostring(w.L, -1);
+        lua_pop(w.L, 1);
+        return false;
+    }
+    if (w.chunks.size() >= JOBS_CHUNK_CACHE) {
+        for (auto& chunk : w.chunks) luaL_unref(w.L, LUA_REGISTRYINDEX, chunk.second);
+        w.chunks.clear();
+    }
+    lua_pushvalue(w.L, -1);
+    w.chunks.emplace(code, luaL_ref(w.L, LUA_REGISTRYINDEX));
+    return true;
+}
+
+static void workerRun(Worker& w, Job& job) {
+    lua_State* L = w.L;
+    int top = lua_gettop(L);
+    if (workerLoadChunk(w, job.code, job.error)) {
+        deserializeValues(L, job.args);
+        if (lua_pcall(L, job.args.count, LUA_MULTRET, 0) != LUA_OK) {
+            const char* msg = lua_tostring(L, -1);
+            job.error = msg ? msg : "job failed";
+        } else {
+            const char* err = serializeValues(L, top + 1, lua_gettop(L) - top, job.results);
+            if (err) job.error = std::string("bad job result: ") + err;
+        }
+    }
+    lua_settop(L, top);
+    job.args = JobMessage(); // the arguments are not needed any more
+}
+
+// own queue first (oldest job), then the newest job of another worker
+static std::shared_ptr<Job> workerTakeJob(size_t self) {
+    std::shared_ptr<Job> job;
+    size_t n = jobPool.workers.size();
+    for (size_t i = 0; i < n && !job; i++) {
+        Worker& w = *jobPool.workers[(self + i) % n];
+        std::lock_guard<std::mutex> lock(w.mutex);
+        if (w.queue.empty()) continue;
+        if (i == 0) {
+            job = std::move(w.queue.front());
+            w.queue.pop_front();
+        } else {
+            job = std::move(w.queue.back());
+            w.queue.pop_back();
+        }
+    }
+    if (job) jobPool.queued--;
+    return job;
+}
+
+static void workerLoop(size_t self) {
+    Worker& w = *jobPool.workers[self];
+    for (;;) {
+        std::shared_ptr<Job> job = workerTakeJob(self);
+        if (!job) {
+            std::unique_lock<std::mutex> lock(jobPool.mutex);
+            jobPool.wake.wait(lock, [] { return jobPool.stopping || jobPool.queued > 0; });
+            if (jobPool.stopping) return;
+            continue;
+        }
+
+        workerRun(w, *job);
+        {
+            std::lock_guard<std::mutex> lock(jobPool.mutex);
+            job->done = true;
+        }
+        jobPool.finished.notify_all();
+    }
+}
+
+static lua_State* newWorkerState() {
+    lua_State* L = luaL_newstate();
+    luaL_openlibs(L);
+    registerSharedBlobClass(L);
+
+    // workers can share what they produce, but not spawn or wait
+    lua_newtable(L);
+    lua_pushcfunction(L, l_JobsShare);
+    lua_setfield(L, -2, "share");
+    lua_setglobal(L, "jobs");
+    return L;
+}
+
+static void jobsStop() {
+    {
+        std::lock_guard<std::mutex> lock(jobPool.mutex);
+        jobPool.stopping = true;
+    }
+    jobPool.wake.notify_all();
+    for (auto& w : jobPool.workers) {
+        if (w->thread.joinable()) w->thread.join();
+        lua_close(w->L);
+    }
+    {
+        // jobs nobody ran are finished with an error, so waiting on them returns
+        std::lock_guard<std::mutex> lock(jobPool.mutex);
+        for (auto& w : jobPool.workers) {
+            for (auto& job : w->queue) {
+                job->error = "job pool was stopped";
+                job->done = true;
+            }
+        }
+    }
+    jobPool.finished.notify_all();
+    jobPool.workers.clear();
+    jobPool.queued = 0;
+    jobPool.stopping = false;
+}
+
+JobPool::~JobPool() {
+    jobsStop();
+}
+
+static void jobsStart(int count) {
+    if (count <= 0) count = std::max(1, (int)std::thread::hardware_concurrency() - 1); // the main thread is busy too
+    for (int i = 0; i < count; i++) {
+        jobPool.workers.emplace_back(new Worker());
+        jobPool.workers.back()->L = newWorkerState();
+    }
+    for (int i = 0; i < count; i++) jobPool.workers[i]->thread = std::thread(workerLoop, (size_t)i);
+}
+
+// ─── Lua API ────────────────────────────────────────────────────────────────
+
+static int dumpWriter(lua_State* L, const void* p, size_t size, void* ud) {
+    ((std::string*)ud)->append((const char*)p, size);
+    return 0;
+}
+
+// jobs.spawn(fn or source, ...) -> job
+static int l_JobsSpawn(lua_State* L) {
+    std::shared_ptr<Job> job = std::make_shared<Job>();
+    if (lua_isfunction(L, 1)) {
+        luaL_argcheck(L, !lua_iscfunction(L, 1), 1, "C functions can not be sent to a job");
+        const char* name;
+        for (int i = 1; (name = lua_getupvalue(L, 1, i)); i++) {
+            lua_pop(L, 1);
+            if (strcmp(name, "_ENV") != 0)
+                return luaL_error(L, "job function captures '%s', pass it as an argument instead", name);
+        }
+        lua_pushvalue(L, 1);
+        lua_dump(L, dumpWriter, &job->code, 0);
+        lua_pop(L, 1);
+    } else {
+        size_t len;
+        const char* source = luaL_checklstring(L, 1, &len);
+        job->code.assign(source, len);
+    }
+
+    const char* err = serializeValues(L, 2, lua_gettop(L) - 1, job->args);
+    if (err) return luaL_error(L, "bad job argument: %s", err);
+
+    if (jobPool.workers.empty()) jobsStart(0);
+    Worker* target;
+    {
+        std::lock_guard<std::mutex> lock(jobPool.mutex);
+        target = jobPool.workers[jobPool.next++ % jobPool.workers.size()].get();
+    }
+    {
+        std::lock_guard<std::mutex> lock(target->mutex);
+        target->queue.push_back(job);
+    }
+    {
+        std::lock_guard<std::mutex> lock(jobPool.mutex);
+        jobPool.queued++;
+    }
+    jobPool.wake.notify_one();
+
+    pushPtr(L, new JobHandle{ job });
+    return 1;
+}
+
+static bool jobDone(const Job& job) {
+    std::lock_guard<std::mutex> lock(jobPool.mutex);
+    return job.done;
+}
+
+static void jobWait(const Job& job) {
+    std::unique_lock<std::mutex> lock(jobPool.mutex);
+    jobPool.finished.wait(lock, [&] { return job.done; });
+}
+
+// job:done() -> true once the results are ready
+static int l_JobDone(lua_State* L) {
+    lua_pushboolean(L, jobDone(*getPtr<JobHandle>(L, 1)->job));
+    return 1;
+}
+
+// job:wait() -> the job's return values, or nil and the error
+static int l_JobWait(lua_State* L) {
+    Job& job = *getPtr<JobHandle>(L, 1)->job;
+    jobWait(job);
+    if (!job.error.empty()) {
+        lua_pushnil(L);
+        lua_pushlstring(L, job.error.data(), job.error.size());
+        return 2;
+    }
+    luaL_checkstack(L, job.results.count, "too many job results");
+    deserializeValues(L, job.results);
+    return job.results.count;
+}
+
+static int l_JobGC(lua_State* L) {
+    delete getPtr<JobHandle>(L, 1);
+    return 0;
+}
+
+// jobs.wait(job, ...) or jobs.wait({ job, ... }) - blocks until all of them are done
+static int l_JobsWait(lua_State* L) {
+    int n = lua_gettop(L);
+    for (int i = 1; i <= n; i++) {
+        if (lua_istable(L, i)) {
+            lua_Integer len = luaL_len(L, i);
+            for (lua_Integer j = 1; j <= len; j++) {
+                lua_rawgeti(L, i, j);
+                jobWait(*getPtr<JobHandle>(L, -1)->job);
+                lua_pop(L, 1);
+            }
+        } else {
+            jobWait(*getPtr<JobHandle>(L, i)->job);
+        }
+    }
+    return 0;
+}
+
+// jobs.start([workers]) - (re)starts the pool, by default with one worker per core
+// minus the main thread; jobs.spawn starts it on demand
+static int l_JobsStart(lua_State* L) {
+    int count = luaL_optinteger(L, 1, 0);
+    jobsStop(); // running jobs finish first, queued ones fail
+    jobsStart(count);
+    return 0;
+}
+
+static int l_JobsWorkers(lua_State* L) {
+    lua_pushinteger(L, jobPool.workers.size());
+    return 1;
+}
+
+// jobs.pending() -> jobs waiting for a worker
+static int l_JobsPending(lua_State* L) {
+    lua_pushinteger(L, std::max(0, jobPool.queued.load())); // briefly -1 while a spawn is in flight
+    return 1;
+}
+
+static void registerJobClass(lua_State* L) {
+    const char* type = typeid(JobHandle).name();
+    if (luaL_newmetatable(L, type)) {
+        lua_pushstring(L, "__index");
+        lua_newtable(L);
+
+        static luaL_Reg methods[] = {
+            { "done", l_JobDone },
+            { "wait", l_JobWait },
+            { NULL, NULL }
+        };
+        push_funcs(L, methods);
+        lua_settable(L, -3); // metatable.__index = table
+
+        // the pool holds its own reference, a collected handle never frees a running job
+        lua_pushcfunction(L, l_JobGC);
+        lua_setfield(L, -2, "__gc");
+    }
+    lua_pop(L, 1);
+}
+
+static luaL_Reg jobsFuncs[] = {
+    { "spawn", l_JobsSpawn },
+    { "wait", l_JobsWait },
+    { "share", l_JobsShare },
+    { "start", l_JobsStart },
+    { "workers", l_JobsWorkers },
+    { "pending", l_JobsPending },
+    { NULL, NULL }
+};
+
+extern "C" int luaopen_jobs(lua_State* L) {
+    registerJobClass(L);
+    registerSharedBlobClass(L);
+
+    lua_newtable(L);
+    push_funcs(L, jobsFuncs);
+    return 1;
+}
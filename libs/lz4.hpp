@@ -0,0 +1,137 @@
+// lz4.hpp - LZ4 block format compression, compatible with liblz4's
+// LZ4_compress_default / LZ4_decompress_safe output, without the dependency.
+// The compressor is the simple greedy single hash table variant: a bit worse
+// ratio than liblz4, same decode speed. Used by the .rtex texture container.
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#define LZ4_MIN_MATCH 4
+#define LZ4_LAST_LITERALS 5 // the block always ends with this many literals
+#define LZ4_MF_LIMIT 12     // no match may start in the last 12 bytes
+#define LZ4_HASH_BITS 16
+
+// Worst case compressed size of n bytes
+inline size_t lz4Bound(size_t n) {
+    return n + n / 255 + 16;
+}
+
+inline uint32_t lz4Read32(const uint8_t* p) {
+    uint32_t v;
+    memcpy(&v, p, 4);
+    return v;
+}
+
+inline uint8_t* lz4WriteLength(uint8_t* op, size_t len) {
+    while (len >= 255) {
+        *op++ = 255;
+        len -= 255;
+    }
+    *op++ = (uint8_t)len;
+    return op;
+}
+
+// One sequence: literals, then (unless last) a match of matchLen bytes at offset
+inline uint8_t* lz4WriteSequence(uint8_t* op, const uint8_t* literals, size_t litLen, size_t offset, size_t matchLen) {
+    uint8_t* token = op++;
+    *token = (uint8_t)((litLen >= 15 ? 15 : litLen) << 4);
+    if (litLen >= 15) op = lz4WriteLength(op, litLen - 15);
+    memcpy(op, literals, litLen);
+    op += litLen;
+    if (!matchLen) return op;
+
+    *op++ = (uint8_t)offset;
+    *op++ = (uint8_t)(offset >> 8);
+    size_t ml = matchLen - LZ4_MIN_MATCH;
+    *token |= (uint8_t)(ml >= 15 ? 15 : ml);
+    if (ml >= 15) op = lz4WriteLength(op, ml - 15);
+    return op;
+}
+
+// Compresses n bytes of src into dst, which must hold lz4Bound(n) bytes.
+// Returns the compressed size.
+inline size_t lz4Compress(const uint8_t* src, size_t n, uint8_t* dst) {
+    const uint8_t* ip = src;
+    const uint8_t* anchor = src;
+    const uint8_t* end = src + n;
+    uint8_t* op = dst;
+
+    if (n > LZ4_MF_LIMIT) {
+        std::vector<uint32_t> table((size_t)1 << LZ4_HASH_BITS, 0); // positions in src
+        const uint8_t* mfLimit = end - LZ4_MF_LIMIT;
+        const uint8_t* matchLimit = end - LZ4_LAST_LITERALS;
+        while (ip < mfLimit) {
+            uint32_t seq = lz4Read32(ip);
+            uint32_t h = (seq * 2654435761u) >> (32 - LZ4_HASH_BITS);
+            const uint8_t* ref = src + table[h];
+            table[h] = (uint32_t)(ip - src);
+            if (ref >= ip || ip - ref > 65535 || lz4Read32(ref) != seq) {
+                ip++;
+                continue;
+            }
+
+            const uint8_t* mp = ip + LZ4_MIN_MATCH;
+            const uint8_t* rp = ref + LZ4_MIN_MATCH;
+            while (mp < matchLimit && *mp == *rp) {
+                mp++;
+                rp++;
+            }
+            op = lz4WriteSequence(op, anchor, ip - anchor, ip - ref, mp - ip);
+            ip = anchor = mp;
+        }
+    }
+    op = lz4WriteSequence(op, anchor, end - anchor, 0, 0);
+    return op - dst;
+}
+
+// Decompresses a block into dst (capacity bytes). Returns the decompressed
+// size, or -1 when the input is malformed or would overflow dst.
+inline long long lz4Decompress(const uint8_t* src, size_t n, uint8_t* dst, size_t capacity) {
+    const uint8_t* ip = src;
+    const uint8_t* iend = src + n;
+    uint8_t* op = dst;
+    uint8_t* oend = dst + capacity;
+
+    while (ip < iend) {
+        unsigned token = *ip++;
+        size_t litLen = token >> 4;
+        if (litLen == 15) {
+            unsigned b;
+            do {
+                if (ip >= iend) return -1;
+                b = *ip++;
+                litLen += b;
+            } while (b == 255);
+        }
+        if ((size_t)(iend - ip) < litLen || (size_t)(oend - op) < litLen) return -1;
+        memcpy(op, ip, litLen);
+        ip += litLen;
+        op += litLen;
+        if (ip == iend) break; // the last sequence has no match
+
+        if (iend - ip < 2) return -1;
+        size_t offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > (size_t)(op - dst)) return -1;
+
+        size_t matchLen = token & 15;
+        if (matchLen == 15) {
+            unsigned b;
+            do {
+                if (ip >= iend) return -1;
+                b = *ip++;
+                matchLen += b;
+            } while (b == 255);
+        }
+        matchLen += LZ4_MIN_MATCH;
+        if ((size_t)(oend - op) < matchLen) return -1;
+
+        // byte by byte: the match may overlap what it writes (runs)
+        const uint8_t* match = op - offset;
+        for (size_t i = 0; i < matchLen; i++) op[i] = match[i];
+        op += matchLen;
+    }
+    return op - dst;
+}
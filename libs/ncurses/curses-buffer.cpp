@@ -0,0 +1,347 @@
+// curses-buffer.cpp - cell buffers: draw into a native char + attribute grid
+// and present() it; only the cells that differ from the last presented frame
+// are sent to ncurses, so redrawing the whole dashboard every tick costs the
+// terminal nothing for the parts that did not change.
+// Text is UTF-8, one cell per code point (box drawing and accented letters
+// work; double width characters like CJK are not handled).
+// included by curses.cpp
+//
+//   local screen = curses.newBuffer(80, 24)
+//   screen:clear()
+//   screen:put(0, 0, "cpu " .. cpu, attr)
+//   screen:present()
+#pragma once
+#include <lua.hpp>
+#include "../../../libs/lua_ffi.hpp" // pushPtr, getPtr
+#include "curses-window.cpp"         // CursesWindow, cursesNoutRefresh
+#include <algorithm>                 // std::remove
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+struct Cell {
+  uint32_t ch; // Unicode code point
+  uint32_t attr;
+  bool operator!=(const Cell &o) const { return ch != o.ch || attr != o.attr; }
+};
+
+// never drawn, forces a cell to be sent on the next present
+static const Cell staleCell = {0xFFFFFFFFu, 0xFFFFFFFFu};
+
+struct CellBuffer {
+  int width, height;
+  std::vector<Cell> cells;        // what the script drew
+  std::vector<Cell> front;        // what the terminal shows, as of the last present
+  std::vector<uint8_t> rowDirty;  // rows touched since the last present
+  unsigned generation;            // screenGeneration (curses.cpp) the front copy belongs to
+  // window, its generation and the offset of the last present, front is only valid for those
+  CursesWindow *presentedTo;
+  unsigned presentedGeneration;
+  int presentX, presentY;
+};
+
+static std::vector<CellBuffer *> cellBufferPool;
+
+// Decodes the UTF-8 character at s[*i] and moves *i past it. Malformed bytes
+// decode one at a time as U+FFFD.
+static uint32_t utf8Next(const char *s, size_t len, size_t *i) {
+  const unsigned char *p = (const unsigned char *)s + *i;
+  size_t left = len - *i;
+  uint32_t cp;
+  size_t n;
+  if (p[0] < 0x80) { *i += 1; return p[0]; }
+  else if ((p[0] & 0xE0) == 0xC0) { cp = p[0] & 0x1F; n = 2; }
+  else if ((p[0] & 0xF0) == 0xE0) { cp = p[0] & 0x0F; n = 3; }
+  else if ((p[0] & 0xF8) == 0xF0) { cp = p[0] & 0x07; n = 4; }
+  else { *i += 1; return 0xFFFD; }
+  if (n > left) { *i += 1; return 0xFFFD; }
+  for (size_t k = 1; k < n; k++) {
+    if ((p[k] & 0xC0) != 0x80) { *i += 1; return 0xFFFD; }
+    cp = (cp << 6) | (p[k] & 0x3F);
+  }
+  static const uint32_t minForLength[5] = {0, 0, 0x80, 0x800, 0x10000};
+  if (cp < minForLength[n] || cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF)) { *i += 1; return 0xFFFD; }
+  *i += n;
+  return cp;
+}
+
+// Code point stored in a cell: control characters would move the ncurses
+// cursor or blank neighbouring cells ('\n', '\t'), leaving the terminal out of
+// step with `front`, so they are shown as a space
+static uint32_t cellChar(uint32_t cp) {
+  return cp < 0x20 || cp == 0x7F || (cp >= 0x80 && cp < 0xA0) ? ' ' : cp;
+}
+
+// Writes cp as UTF-8 to out, returns the byte count
+static int utf8Encode(uint32_t cp, char out[4]) {
+  if (cp < 0x80) { out[0] = (char)cp; return 1; }
+  if (cp < 0x800) {
+    out[0] = (char)(0xC0 | (cp >> 6));
+    out[1] = (char)(0x80 | (cp & 0x3F));
+    return 2;
+  }
+  if (cp < 0x10000) {
+    out[0] = (char)(0xE0 | (cp >> 12));
+    out[1] = (char)(0x80 | ((cp >> 6) & 0x3F));
+    out[2] = (char)(0x80 | (cp & 0x3F));
+    return 3;
+  }
+  out[0] = (char)(0xF0 | (cp >> 18));
+  out[1] = (char)(0x80 | ((cp >> 12) & 0x3F));
+  out[2] = (char)(0x80 | ((cp >> 6) & 0x3F));
+  out[3] = (char)(0x80 | (cp & 0x3F));
+  return 4;
+}
+
+// Writes one cell at the cursor: ASCII as a chtype, anything else through the
+// wide character API
+static void cellWrite(curses::WINDOW *target, const Cell &c) {
+  using namespace curses;
+  if (c.ch < 0x80) {
+    waddch(target, (chtype)c.ch | c.attr);
+    return;
+  }
+  wchar_t text[2] = {(wchar_t)c.ch, 0};
+  cchar_t wide;
+  setcchar(&wide, text, (attr_t)(c.attr & ~A_COLOR), (short)PAIR_NUMBER(c.attr), nullptr);
+  wadd_wch(target, &wide);
+}
+
+static void cellBufferInvalidate(CellBuffer *b) {
+  std::fill(b->front.begin(), b->front.end(), staleCell);
+  std::fill(b->rowDirty.begin(), b->rowDirty.end(), 1);
+}
+
+static void cellBufferResize(CellBuffer *b, int width, int height) {
+  b->width = std::max(width, 1);
+  b->height = std::max(height, 1);
+  b->cells.assign((size_t)b->width * b->height, Cell{' ', 0});
+  b->front.assign(b->cells.size(), staleCell);
+  b->rowDirty.assign(b->height, 1);
+}
+
+static void cellBufferFill(CellBuffer *b, int x, int y, int w, int h, Cell c) {
+  int x0 = std::max(x, 0), y0 = std::max(y, 0);
+  int x1 = std::min(x + w, b->width), y1 = std::min(y + h, b->height);
+  for (int row = y0; row < y1; row++) {
+    std::fill(&b->cells[(size_t)row * b->width + x0], &b->cells[(size_t)row * b->width + x1], c);
+    b->rowDirty[row] = 1;
+  }
+}
+
+// Sends the changed cells of every dirty row to the window at (ox, oy), in
+// runs so the cursor is only moved where a run starts. Everything is sent again
+// when the screen was cleared, the window was drawn into by other means, or the
+// buffer goes to a different window or offset than last time.
+static void cellBufferPresent(CellBuffer *b, CursesWindow *cw, int ox, int oy) {
+  if (b->generation != screenGeneration || b->presentedTo != cw || b->presentedGeneration != cw->generation
+      || b->presentX != ox || b->presentY != oy) {
+    cellBufferInvalidate(b);
+    b->generation = screenGeneration;
+    b->presentedTo = cw;
+    b->presentedGeneration = cw->generation;
+    b->presentX = ox;
+    b->presentY = oy;
+  }
+  curses::WINDOW *target = cw->w;
+
+  for (int y = 0; y < b->height; y++) {
+    if (!b->rowDirty[y]) continue;
+    b->rowDirty[y] = 0;
+
+    Cell *back = &b->cells[(size_t)y * b->width];
+    Cell *front = &b->front[(size_t)y * b->width];
+    int cursor = -1; // column the ncurses cursor is at, -1 when unknown
+    for (int x = 0; x < b->width; x++) {
+      if (!(back[x] != front[x])) continue;
+      if (cursor != x) curses::wmove(target, oy + y, ox + x);
+      cellWrite(target, back[x]);
+      front[x] = back[x];
+      cursor = x + 1;
+    }
+  }
+}
+
+// curses.newBuffer(width, height) -> buffer
+static int lua_new_buffer(lua_State *L) {
+  int width = luaL_checkinteger(L, 1);
+  int height = luaL_checkinteger(L, 2);
+
+  CellBuffer *b = new CellBuffer();
+  cellBufferResize(b, width, height);
+  b->generation = screenGeneration;
+  cellBufferPool.push_back(b);
+  pushPtr(L, b); // Pushed as userdata, no __gc
+  return 1;
+}
+
+// buffer:put(x, y, text[, attr]) - UTF-8 text, clipped to the buffer, no wrapping
+static int lua_buffer_put(lua_State *L) {
+  CellBuffer *b = getPtr<CellBuffer>(L, 1);
+  int x = luaL_checkinteger(L, 2);
+  int y = luaL_checkinteger(L, 3);
+  size_t len;
+  const char *text = luaL_checklstring(L, 4, &len);
+  uint32_t attr = luaL_optinteger(L, 5, 0);
+  if (y < 0 || y >= b->height) return 0;
+
+  Cell *row = &b->cells[(size_t)y * b->width];
+  bool touched = false;
+  size_t i = 0;
+  for (long long col = x; i < len && col < b->width; col++) {
+    uint32_t ch = cellChar(utf8Next(text, len, &i));
+    if (col < 0) continue;
+    row[col] = Cell{ch, attr};
+    touched = true;
+  }
+  if (touched) b->rowDirty[y] = 1;
+  return 0;
+}
+
+// buffer:fill(x, y, w, h[, char, attr]) - char is the first UTF-8 character of a string
+static int lua_buffer_fill(lua_State *L) {
+  CellBuffer *b = getPtr<CellBuffer>(L, 1);
+  int x = luaL_checkinteger(L, 2);
+  int y = luaL_checkinteger(L, 3);
+  int w = luaL_checkinteger(L, 4);
+  int h = luaL_checkinteger(L, 5);
+  size_t len;
+  const char *ch = luaL_optlstring(L, 6, " ", &len);
+  uint32_t attr = luaL_optinteger(L, 7, 0);
+  size_t i = 0;
+  cellBufferFill(b, x, y, w, h, Cell{len ? cellChar(utf8Next(ch, len, &i)) : ' ', attr});
+  return 0;
+}
+
+// buffer:clear([attr])
+static int lua_buffer_clear(lua_State *L) {
+  CellBuffer *b = getPtr<CellBuffer>(L, 1);
+  cellBufferFill(b, 0, 0, b->width, b->height, Cell{' ', (uint32_t)luaL_optinteger(L, 2, 0)});
+  return 0;
+}
+
+// buffer:blit(src, x, y[, sx, sy, w, h]) - copies a region of another buffer
+static int lua_buffer_blit(lua_State *L) {
+  CellBuffer *dst = getPtr<CellBuffer>(L, 1);
+  CellBuffer *src = getPtr<CellBuffer>(L, 2);
+  int x = luaL_checkinteger(L, 3);
+  int y = luaL_checkinteger(L, 4);
+  int sx = luaL_optinteger(L, 5, 0);
+  int sy = luaL_optinteger(L, 6, 0);
+  int w = luaL_optinteger(L, 7, src->width);
+  int h = luaL_optinteger(L, 8, src->height);
+
+  // clip against both buffers
+  if (sx < 0) { w += sx; x -= sx; sx = 0; }
+  if (sy < 0) { h += sy; y -= sy; sy = 0; }
+  if (x < 0) { w += x; sx -= x; x = 0; }
+  if (y < 0) { h += y; sy -= y; y = 0; }
+  w = std::min({w, src->width - sx, dst->width - x});
+  h = std::min({h, src->height - sy, dst->height - y});
+  if (w <= 0 || h <= 0) return 0;
+
+  // a buffer may be blitted onto itself: memmove handles overlap within a row,
+  // and copying downwards goes bottom-up so no source row is overwritten first
+  bool bottomUp = dst == src && y > sy;
+  for (int i = 0; i < h; i++) {
+    int row = bottomUp ? h - 1 - i : i;
+    memmove(&dst->cells[(size_t)(y + row) * dst->width + x],
+            &src->cells[(size_t)(sy + row) * src->width + sx], w * sizeof(Cell));
+    dst->rowDirty[y + row] = 1;
+  }
+  return 0;
+}
+
+// buffer:get(x, y) -> char, attr
+static int lua_buffer_get(lua_State *L) {
+  CellBuffer *b = getPtr<CellBuffer>(L, 1);
+  int x = luaL_checkinteger(L, 2);
+  int y = luaL_checkinteger(L, 3);
+  if (x < 0 || y < 0 || x >= b->width || y >= b->height) return 0;
+  const Cell &c = b->cells[(size_t)y * b->width + x];
+  char ch[4];
+  lua_pushlstring(L, ch, utf8Encode(c.ch, ch));
+  lua_pushinteger(L, c.attr);
+  return 2;
+}
+
+static int lua_buffer_get_size(lua_State *L) {
+  CellBuffer *b = getPtr<CellBuffer>(L, 1);
+  lua_pushinteger(L, b->width);
+  lua_pushinteger(L, b->height);
+  return 2;
+}
+
+// buffer:resize(width, height) - clears the contents
+static int lua_buffer_resize(lua_State *L) {
+  CellBuffer *b = getPtr<CellBuffer>(L, 1);
+  cellBufferResize(b, luaL_checkinteger(L, 2), luaL_checkinteger(L, 3));
+  return 0;
+}
+
+// buffer:present([x, y, window]) - sends the changes to window (the screen by
+// default) and updates the terminal
+static int lua_buffer_present(lua_State *L) {
+  CellBuffer *b = getPtr<CellBuffer>(L, 1);
+  if (!win) {
+    lua_pushstring(L, "Ncurses not initialized");
+    lua_error(L);
+  }
+  CursesWindow *target = &stdscrWindow;
+  stdscrWindow.w = win;
+  if (!lua_isnoneornil(L, 4)) {
+    checkWindow(L, 4);
+    target = getPtr<CursesWindow>(L, 4);
+  }
+  cellBufferPresent(b, target, luaL_optinteger(L, 2, 0), luaL_optinteger(L, 3, 0));
+  cursesNoutRefresh(target);
+  curses::doupdate();
+  return 0;
+}
+
+// buffer:invalidate() - repaint every cell on the next present
+static int lua_buffer_invalidate(lua_State *L) {
+  cellBufferInvalidate(getPtr<CellBuffer>(L, 1));
+  return 0;
+}
+
+static int lua_buffer_unload(lua_State *L) {
+  CellBuffer *b = getPtr<CellBuffer>(L, 1);
+  if (!b) return 0;
+  cellBufferPool.erase(std::remove(cellBufferPool.begin(), cellBufferPool.end(), b), cellBufferPool.end());
+  delete b;
+  return 0;
+}
+
+static int lua_buffer_unload_all(lua_State *L) {
+  for (CellBuffer *b : cellBufferPool) delete b;
+  cellBufferPool.clear();
+  return 0;
+}
+
+// Register buffer methods (no __gc)
+static void registerCellBufferClass(lua_State *L) {
+  const char *type = typeid(CellBuffer).name();
+  if (luaL_newmetatable(L, type)) {
+    lua_pushstring(L, "__index");
+    lua_newtable(L);
+
+    static luaL_Reg methods[] = {
+      {"put", lua_buffer_put},
+      {"fill", lua_buffer_fill},
+      {"clear", lua_buffer_clear},
+      {"blit", lua_buffer_blit},
+      {"get", lua_buffer_get},
+      {"getSize", lua_buffer_get_size},
+      {"resize", lua_buffer_resize},
+      {"present", lua_buffer_present},
+      {"invalidate", lua_buffer_invalidate},
+      {"unload", lua_buffer_unload},
+      {NULL, NULL}
+    };
+    push_funcs(L, methods);
+
+    lua_settable(L, -3); // metatable.__index = table
+  }
+  lua_pop(L, 1);
+}
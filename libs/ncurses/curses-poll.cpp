@@ -0,0 +1,194 @@
+// curses-poll.cpp - non-blocking input and an epoll based event loop
+// curses.poll(timeoutMs) waits on stdin, terminal resizes (SIGWINCH through a
+// signalfd) and any descriptors registered with curses.watchFd(), then returns
+// everything that happened as one batch, so a monitor can redraw at a fixed
+// rate without blocking in getch or spinning.
+// included by curses.cpp
+//
+//   while running do
+//     for _, e in ipairs(curses.poll(250)) do
+//       if e.type == "key" then handle(e.key)
+//       elseif e.type == "resize" then screen:resize(e.width, e.height)
+//       elseif e.type == "fd" then readSocket(e.fd) end
+//     end
+//     draw()
+//   end
+#pragma once
+#include <lua.hpp>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <sys/epoll.h>
+#include <sys/ioctl.h>
+#include <sys/signalfd.h>
+#include <unistd.h>
+
+#define POLL_MAX_EVENTS 32
+
+static int epollFd = -1;
+static int winchFd = -1;
+static int inputTimeout = -1; // what getch waits for, -1 blocks (the curses default)
+
+// Creates the epoll set on first use. SIGWINCH is blocked and read through a
+// signalfd, so ncurses' own handler no longer runs and resizes are applied here
+static bool pollInit() {
+  if (epollFd >= 0) return true;
+  epollFd = epoll_create1(EPOLL_CLOEXEC);
+  if (epollFd < 0) return false;
+
+  epoll_event ev = {};
+  ev.events = EPOLLIN;
+  ev.data.fd = STDIN_FILENO;
+  epoll_ctl(epollFd, EPOLL_CTL_ADD, STDIN_FILENO, &ev);
+
+  sigset_t mask;
+  sigemptyset(&mask);
+  sigaddset(&mask, SIGWINCH);
+  sigprocmask(SIG_BLOCK, &mask, nullptr);
+  winchFd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+  if (winchFd >= 0) {
+    ev.data.fd = winchFd;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, winchFd, &ev);
+  }
+  return true;
+}
+
+// appends {type = type} to the events table below it and leaves it on top for its fields
+static void pollPushEvent(lua_State *L, int &count, const char *type) {
+  lua_newtable(L);
+  lua_pushstring(L, type);
+  lua_setfield(L, -2, "type");
+  lua_pushvalue(L, -1);
+  lua_rawseti(L, -3, ++count);
+}
+
+// Reads every key ncurses has, including ones it buffered on an earlier read
+static void pollDrainKeys(lua_State *L, int &count) {
+  curses::wtimeout(win, 0);
+  int ch;
+  while ((ch = curses::wgetch(win)) != ERR) {
+    pollPushEvent(L, count, "key");
+    lua_pushinteger(L, ch);
+    lua_setfield(L, -2, "key");
+    lua_pop(L, 1);
+  }
+  curses::wtimeout(win, inputTimeout);
+}
+
+static void pollHandleResize(lua_State *L, int &count) {
+  signalfd_siginfo info;
+  while (read(winchFd, &info, sizeof(info)) == sizeof(info)) {}
+
+  winsize ws;
+  if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) < 0) return;
+  curses::resizeterm(ws.ws_row, ws.ws_col);
+  screenGeneration++; // the terminal was repainted, buffers send everything again
+
+  pollPushEvent(L, count, "resize");
+  lua_pushinteger(L, ws.ws_col);
+  lua_setfield(L, -2, "width");
+  lua_pushinteger(L, ws.ws_row);
+  lua_setfield(L, -2, "height");
+  lua_pop(L, 1);
+}
+
+// curses.poll([timeoutMs]) -> events - waits up to timeoutMs (nil or -1 blocks) for input,
+// a resize or a watched fd and returns all pending events, an empty table on timeout
+static int lua_poll(lua_State *L) {
+  if (!win) {
+    lua_pushstring(L, "Ncurses not initialized");
+    lua_error(L);
+  }
+  int timeout = luaL_optinteger(L, 1, -1);
+  if (!pollInit()) {
+    lua_pushnil(L);
+    lua_pushstring(L, strerror(errno));
+    return 2;
+  }
+
+  lua_newtable(L);
+  int count = 0;
+  pollDrainKeys(L, count); // typeahead ncurses already read is not visible to epoll
+  if (count) timeout = 0;
+
+  epoll_event events[POLL_MAX_EVENTS];
+  int n = epoll_wait(epollFd, events, POLL_MAX_EVENTS, timeout);
+  bool keys = false;
+  for (int i = 0; i < n; i++) {
+    int fd = events[i].data.fd;
+    if (fd == STDIN_FILENO) {
+      keys = true;
+    } else if (fd == winchFd) {
+      pollHandleResize(L, count);
+    } else {
+      pollPushEvent(L, count, "fd");
+      lua_pushinteger(L, fd);
+      lua_setfield(L, -2, "fd");
+      lua_pushboolean(L, (events[i].events & EPOLLIN) != 0);
+      lua_setfield(L, -2, "readable");
+      lua_pushboolean(L, (events[i].events & (EPOLLHUP | EPOLLERR)) != 0);
+      lua_setfield(L, -2, "hangup");
+      lua_pop(L, 1);
+    }
+  }
+  if (keys) pollDrainKeys(L, count);
+  return 1;
+}
+
+// curses.watchFd(fd) - poll() reports an "fd" event while fd is readable
+static int lua_watch_fd(lua_State *L) {
+  int fd = luaL_checkinteger(L, 1);
+  if (!pollInit()) {
+    lua_pushboolean(L, false);
+    lua_pushstring(L, strerror(errno));
+    return 2;
+  }
+  epoll_event ev = {};
+  ev.events = EPOLLIN;
+  ev.data.fd = fd;
+  if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev) < 0 && errno != EEXIST) {
+    lua_pushboolean(L, false);
+    lua_pushstring(L, strerror(errno));
+    return 2;
+  }
+  lua_pushboolean(L, true);
+  return 1;
+}
+
+static int lua_unwatch_fd(lua_State *L) {
+  int fd = luaL_checkinteger(L, 1);
+  if (epollFd >= 0 && fd != STDIN_FILENO && fd != winchFd)
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+  return 0;
+}
+
+// curses-window.cpp, applies inputTimeout to the windows and pads
+static void cursesWindowsSetTimeout(int ms);
+
+// curses.nodelay(enabled) - getch returns -1 right away when no key is waiting,
+// on the screen and every window
+static int lua_nodelay(lua_State *L) {
+  inputTimeout = lua_toboolean(L, 1) ? 0 : -1;
+  if (win) curses::wtimeout(win, inputTimeout);
+  cursesWindowsSetTimeout(inputTimeout);
+  return 0;
+}
+
+// curses.timeout(ms) - getch waits at most ms, -1 blocks; on the screen and every window
+static int lua_timeout(lua_State *L) {
+  inputTimeout = luaL_checkinteger(L, 1);
+  if (win) curses::wtimeout(win, inputTimeout);
+  cursesWindowsSetTimeout(inputTimeout);
+  return 0;
+}
+
+static void pollShutdown() {
+  if (winchFd >= 0) close(winchFd);
+  if (epollFd >= 0) close(epollFd);
+  winchFd = epollFd = -1;
+
+  sigset_t mask;
+  sigemptyset(&mask);
+  sigaddset(&mask, SIGWINCH);
+  sigprocmask(SIG_UNBLOCK, &mask, nullptr);
+}
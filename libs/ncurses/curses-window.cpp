@@ -0,0 +1,358 @@
+// curses-window.cpp - window and pad userdata, attributes and color pairs
+// Every window refreshes on its own (noutRefresh + curses.update() batches
+// them), and a pad is a large off-screen window of which a part is shown, so
+// a long log scrolls with scroll()/setView() instead of being redrawn.
+// included by curses.cpp
+//
+//   local log = curses.newWindow(0, 2, 80, 20)
+//   log:setScrolling(true)
+//   log:scroll(1); log:print(0, 19, line, curses.colorPair(1) | curses.A_BOLD)
+//   log:noutRefresh(); status:noutRefresh(); curses.update()
+#pragma once
+#include <lua.hpp>
+#include "../../../libs/lua_ffi.hpp" // pushPtr, getPtr
+#include <algorithm>                 // std::remove
+#include <vector>
+
+struct CursesWindow {
+  curses::WINDOW *w;
+  bool pad;
+  // pads only: top left of the shown part and where it goes on screen
+  int viewX, viewY;
+  int screenX, screenY, screenW, screenH;
+  unsigned generation; // changes whenever something other than a cell buffer draws into w
+};
+
+static std::vector<CursesWindow *> cursesWindowPool;
+static CursesWindow stdscrWindow = {};
+
+static curses::WINDOW *checkWindow(lua_State *L, int idx) {
+  CursesWindow *cw = getPtr<CursesWindow>(L, idx);
+  if (!cw || !cw->w) {
+    lua_pushstring(L, "Invalid window");
+    lua_error(L);
+  }
+  return cw->w;
+}
+
+// source of CursesWindow::generation, unique across windows so a new window
+// at a freed one's address doesn't look unchanged to cell buffers
+static unsigned cursesWindowGeneration = 0;
+
+// checkWindow for calls that draw into the window: cell buffers presented to
+// it repaint fully next time, as their view of its contents is gone
+static curses::WINDOW *checkDrawWindow(lua_State *L, int idx) {
+  curses::WINDOW *w = checkWindow(L, idx);
+  getPtr<CursesWindow>(L, idx)->generation = ++cursesWindowGeneration;
+  return w;
+}
+
+// wnoutrefresh for windows, pnoutrefresh of the shown part for pads
+static void cursesNoutRefresh(CursesWindow *cw) {
+  if (!cw->pad) {
+    curses::wnoutrefresh(cw->w);
+    return;
+  }
+  curses::pnoutrefresh(cw->w, cw->viewY, cw->viewX, cw->screenY, cw->screenX,
+                       cw->screenY + cw->screenH - 1, cw->screenX + cw->screenW - 1);
+}
+
+static int pushCursesWindow(lua_State *L, curses::WINDOW *w, bool pad) {
+  using namespace curses; // getmaxx and friends are macros, they need the names unqualified
+  if (!w) {
+    lua_pushnil(L);
+    lua_pushstring(L, pad ? "Failed to create pad" : "Failed to create window");
+    return 2;
+  }
+  CursesWindow *cw = new CursesWindow();
+  cw->w = w;
+  cw->pad = pad;
+  cw->generation = ++cursesWindowGeneration;
+  if (pad) {
+    cw->screenW = std::min(getmaxx(w), getmaxx(win));
+    cw->screenH = std::min(getmaxy(w), getmaxy(win));
+  }
+  curses::keypad(w, TRUE); // arrow and function keys as KEY_* codes
+  curses::wtimeout(w, inputTimeout);
+  cursesWindowPool.push_back(cw);
+  pushPtr(L, cw); // Pushed as userdata, no __gc
+  return 1;
+}
+
+// curses.newWindow(x, y, width, height) -> window
+static int lua_new_window(lua_State *L) {
+  int x = luaL_checkinteger(L, 1);
+  int y = luaL_checkinteger(L, 2);
+  int w = luaL_checkinteger(L, 3);
+  int h = luaL_checkinteger(L, 4);
+  if (!win) {
+    lua_pushstring(L, "Ncurses not initialized");
+    lua_error(L);
+  }
+  return pushCursesWindow(L, curses::newwin(h, w, y, x), false);
+}
+
+// curses.newPad(width, height) -> pad, shown with setView()
+static int lua_new_pad(lua_State *L) {
+  int w = luaL_checkinteger(L, 1);
+  int h = luaL_checkinteger(L, 2);
+  if (!win) {
+    lua_pushstring(L, "Ncurses not initialized");
+    lua_error(L);
+  }
+  return pushCursesWindow(L, curses::newpad(h, w), true);
+}
+
+// curses.stdscr() -> the whole screen as a window
+static int lua_stdscr(lua_State *L) {
+  if (!win) {
+    lua_pushstring(L, "Ncurses not initialized");
+    lua_error(L);
+  }
+  stdscrWindow.w = win;
+  pushPtr(L, &stdscrWindow);
+  return 1;
+}
+
+// window:print(x, y, text[, attr])
+static int lua_window_print(lua_State *L) {
+  using namespace curses;
+  curses::WINDOW *w = checkDrawWindow(L, 1);
+  int x = luaL_checkinteger(L, 2);
+  int y = luaL_checkinteger(L, 3);
+  size_t len;
+  const char *text = luaL_checklstring(L, 4, &len);
+  if (lua_isnoneornil(L, 5)) {
+    mvwaddnstr(w, y, x, text, (int)len);
+    return 0;
+  }
+  attr_t old;
+  short pair;
+  curses::wattr_get(w, &old, &pair, nullptr);
+  wattrset(w, (int)luaL_checkinteger(L, 5));
+  mvwaddnstr(w, y, x, text, (int)len);
+  curses::wattr_set(w, old, pair, nullptr);
+  return 0;
+}
+
+static int lua_window_attr_on(lua_State *L) {
+  using namespace curses;
+  wattron(checkWindow(L, 1), (int)luaL_checkinteger(L, 2));
+  return 0;
+}
+
+static int lua_window_attr_off(lua_State *L) {
+  using namespace curses;
+  wattroff(checkWindow(L, 1), (int)luaL_checkinteger(L, 2));
+  return 0;
+}
+
+static int lua_window_set_attr(lua_State *L) {
+  using namespace curses;
+  wattrset(checkWindow(L, 1), (int)luaL_checkinteger(L, 2));
+  return 0;
+}
+
+// window:setBackground(attr[, char]) - applied to blank cells and everything drawn after
+static int lua_window_set_background(lua_State *L) {
+  curses::WINDOW *w = checkDrawWindow(L, 1);
+  const char *ch = luaL_optstring(L, 3, " ");
+  curses::wbkgd(w, (curses::chtype)(unsigned char)(ch[0] ? ch[0] : ' ') | (curses::chtype)luaL_checkinteger(L, 2));
+  return 0;
+}
+
+// window:erase() - blanks the window without forcing a full repaint like clear()
+static int lua_window_erase(lua_State *L) {
+  curses::werase(checkDrawWindow(L, 1));
+  return 0;
+}
+
+static int lua_window_clear(lua_State *L) {
+  curses::wclear(checkDrawWindow(L, 1));
+  screenGeneration++; // clearok repaints the terminal
+  return 0;
+}
+
+static int lua_window_box(lua_State *L) {
+  curses::box(checkDrawWindow(L, 1), 0, 0);
+  return 0;
+}
+
+static int lua_window_move(lua_State *L) {
+  curses::wmove(checkWindow(L, 1), luaL_checkinteger(L, 3), luaL_checkinteger(L, 2));
+  return 0;
+}
+
+// window:setScrolling(enabled) - text past the bottom line scrolls the window
+static int lua_window_set_scrolling(lua_State *L) {
+  curses::scrollok(checkWindow(L, 1), lua_toboolean(L, 2));
+  return 0;
+}
+
+// window:setScrollRegion(top, bottom) - lines (0 based, inclusive) scroll() moves
+static int lua_window_set_scroll_region(lua_State *L) {
+  curses::WINDOW *w = checkWindow(L, 1);
+  lua_pushboolean(L, curses::wsetscrreg(w, luaL_checkinteger(L, 2), luaL_checkinteger(L, 3)) != ERR);
+  return 1;
+}
+
+// window:scroll([lines]) - positive moves the contents up; the terminal
+// scrolls too (when it can), so only the new lines are sent
+static int lua_window_scroll(lua_State *L) {
+  curses::WINDOW *w = checkDrawWindow(L, 1);
+  curses::scrollok(w, TRUE); // wscrl does nothing otherwise
+  lua_pushboolean(L, curses::wscrl(w, luaL_optinteger(L, 2, 1)) != ERR);
+  return 1;
+}
+
+// pad:setView(viewX, viewY[, x, y, width, height]) - which part of the pad is
+// shown, and where on screen
+static int lua_window_set_view(lua_State *L) {
+  CursesWindow *cw = getPtr<CursesWindow>(L, 1);
+  luaL_argcheck(L, cw && cw->pad, 1, "setView needs a pad");
+  cw->viewX = luaL_checkinteger(L, 2);
+  cw->viewY = luaL_checkinteger(L, 3);
+  cw->screenX = luaL_optinteger(L, 4, cw->screenX);
+  cw->screenY = luaL_optinteger(L, 5, cw->screenY);
+  cw->screenW = luaL_optinteger(L, 6, cw->screenW);
+  cw->screenH = luaL_optinteger(L, 7, cw->screenH);
+  return 0;
+}
+
+// window:noutRefresh() - stages the window, curses.update() sends all staged windows at once
+static int lua_window_nout_refresh(lua_State *L) {
+  checkWindow(L, 1);
+  cursesNoutRefresh(getPtr<CursesWindow>(L, 1));
+  return 0;
+}
+
+static int lua_window_refresh(lua_State *L) {
+  checkWindow(L, 1);
+  cursesNoutRefresh(getPtr<CursesWindow>(L, 1));
+  curses::doupdate();
+  return 0;
+}
+
+static int lua_window_get_size(lua_State *L) {
+  using namespace curses;
+  curses::WINDOW *w = checkWindow(L, 1);
+  lua_pushinteger(L, getmaxx(w));
+  lua_pushinteger(L, getmaxy(w));
+  return 2;
+}
+
+// window:getch() -> key, -1 when nodelay/timeout ran out
+static int lua_window_getch(lua_State *L) {
+  lua_pushinteger(L, curses::wgetch(checkWindow(L, 1)));
+  return 1;
+}
+
+static int lua_window_unload(lua_State *L) {
+  CursesWindow *cw = getPtr<CursesWindow>(L, 1);
+  if (!cw || cw == &stdscrWindow) return 0;
+  cursesWindowPool.erase(std::remove(cursesWindowPool.begin(), cursesWindowPool.end(), cw), cursesWindowPool.end());
+  curses::delwin(cw->w);
+  delete cw;
+  return 0;
+}
+
+static void cursesWindowsSetTimeout(int ms) {
+  for (CursesWindow *cw : cursesWindowPool) curses::wtimeout(cw->w, ms);
+}
+
+// also called by endwin, windows do not survive the session
+static void cursesUnloadWindows() {
+  for (CursesWindow *cw : cursesWindowPool) {
+    curses::delwin(cw->w);
+    cw->w = nullptr; // the userdata may still be around, checkWindow errors on it
+  }
+  cursesWindowPool.clear();
+  stdscrWindow.w = nullptr;
+}
+
+// curses.startColor() -> true if the terminal has colors
+static int lua_start_color(lua_State *L) {
+  if (!curses::has_colors()) {
+    lua_pushboolean(L, false);
+    return 1;
+  }
+  curses::start_color();
+  curses::use_default_colors(); // -1 is the terminal's own fg/bg
+  lua_pushboolean(L, true);
+  return 1;
+}
+
+// curses.initPair(pair, fg, bg)
+static int lua_init_pair(lua_State *L) {
+  int pair = luaL_checkinteger(L, 1);
+  lua_pushboolean(L, curses::init_pair(pair, luaL_checkinteger(L, 2), luaL_checkinteger(L, 3)) != ERR);
+  return 1;
+}
+
+// curses.colorPair(pair) -> attr, combine with attributes using |
+static int lua_color_pair(lua_State *L) {
+  using namespace curses;
+  lua_pushinteger(L, COLOR_PAIR(luaL_checkinteger(L, 1)));
+  return 1;
+}
+
+// curses.update() - sends everything staged with noutRefresh
+static int lua_update(lua_State *L) {
+  curses::doupdate();
+  return 0;
+}
+
+static void pushCursesConstants(lua_State *L) {
+  using namespace curses;
+  struct { const char *name; lua_Integer value; } constants[] = {
+    {"A_NORMAL", A_NORMAL}, {"A_BOLD", A_BOLD}, {"A_DIM", A_DIM},
+    {"A_UNDERLINE", A_UNDERLINE}, {"A_REVERSE", A_REVERSE}, {"A_BLINK", A_BLINK},
+    {"A_STANDOUT", A_STANDOUT}, {"A_ITALIC", A_ITALIC},
+    {"COLOR_BLACK", COLOR_BLACK}, {"COLOR_RED", COLOR_RED}, {"COLOR_GREEN", COLOR_GREEN},
+    {"COLOR_YELLOW", COLOR_YELLOW}, {"COLOR_BLUE", COLOR_BLUE}, {"COLOR_MAGENTA", COLOR_MAGENTA},
+    {"COLOR_CYAN", COLOR_CYAN}, {"COLOR_WHITE", COLOR_WHITE}, {"COLOR_DEFAULT", -1},
+    {"KEY_UP", KEY_UP}, {"KEY_DOWN", KEY_DOWN}, {"KEY_LEFT", KEY_LEFT}, {"KEY_RIGHT", KEY_RIGHT},
+    {"KEY_HOME", KEY_HOME}, {"KEY_END", KEY_END}, {"KEY_PPAGE", KEY_PPAGE}, {"KEY_NPAGE", KEY_NPAGE},
+    {"KEY_BACKSPACE", KEY_BACKSPACE}, {"KEY_ENTER", KEY_ENTER}, {"KEY_RESIZE", KEY_RESIZE},
+    {"ERR", ERR},
+  };
+  for (auto &c : constants) {
+    lua_pushinteger(L, c.value);
+    lua_setfield(L, -2, c.name);
+  }
+}
+
+// Register window methods (no __gc)
+static void registerCursesWindowClass(lua_State *L) {
+  const char *type = typeid(CursesWindow).name();
+  if (luaL_newmetatable(L, type)) {
+    lua_pushstring(L, "__index");
+    lua_newtable(L);
+
+    static luaL_Reg methods[] = {
+      {"print", lua_window_print},
+      {"attrOn", lua_window_attr_on},
+      {"attrOff", lua_window_attr_off},
+      {"setAttr", lua_window_set_attr},
+      {"setBackground", lua_window_set_background},
+      {"erase", lua_window_erase},
+      {"clear", lua_window_clear},
+      {"box", lua_window_box},
+      {"move", lua_window_move},
+      {"setScrolling", lua_window_set_scrolling},
+      {"setScrollRegion", lua_window_set_scroll_region},
+      {"scroll", lua_window_scroll},
+      {"setView", lua_window_set_view},
+      {"noutRefresh", lua_window_nout_refresh},
+      {"refresh", lua_window_refresh},
+      {"getSize", lua_window_get_size},
+      {"getch", lua_window_getch},
+      {"unload", lua_window_unload},
+      {NULL, NULL}
+    };
+    push_funcs(L, methods);
+
+    lua_settable(L, -3); // metatable.__index = table
+  }
+  lua_pop(L, 1);
+}
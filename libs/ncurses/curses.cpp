@@ -1,6 +1,10 @@
 #include <lua.hpp>
 #include "../../../libs/lua_ffi.hpp"
+#include <clocale>
+#include <cwchar>
 
+// wide character API (wadd_wch) for the UTF-8 cells of curses-buffer.cpp, links with -lncursesw
+#define NCURSES_WIDECHAR 1
 namespace curses {
   #include <ncurses.h>
 }
@@ -8,8 +12,17 @@ namespace curses {
 // Declare the global window pointer
 static curses::WINDOW *win = nullptr;
 
+// bumped whenever the terminal contents are thrown away behind our back
+// (clear(), initscr(), resizes), so every cell buffer repaints fully on its next present
+static unsigned screenGeneration = 0;
+
+#include "curses-poll.cpp"
+#include "curses-window.cpp"
+#include "curses-buffer.cpp"
+
 // Initialize the ncurses library
 static int initscr(lua_State* L) {
+  setlocale(LC_ALL, ""); // ncursesw only writes UTF-8 in a UTF-8 locale
   win = curses::initscr();
   if (!win) {
     lua_pushstring(L, "Failed to initialize ncurses");
@@ -17,12 +30,17 @@ static int initscr(lua_State* L) {
   }
   curses::noecho(); // prevent typed characters from appearing
   curses::cbreak(); // read input without waiting for newline
+  curses::keypad(win, TRUE); // arrow and function keys as KEY_* codes, for getch and poll
+  curses::wtimeout(win, inputTimeout); // nodelay()/timeout() may be set before initscr
+  screenGeneration++;
   return 0;
 }
 
 // End the ncurses session
 static int endwin(lua_State* L) {
   if (win) {
+    pollShutdown();
+    cursesUnloadWindows();
     curses::endwin();
     win = nullptr;  // Reset the win pointer
   }
@@ -48,10 +66,12 @@ static int printw(lua_State* L){
 	y = lua_tonumber(L, 3);
 
 	curses::mvprintw(y,x, "%s", str);
+	stdscrWindow.generation = ++cursesWindowGeneration; // buffers on the screen repaint
 	return 0;
 }
 static int clear(lua_State* L) {
     curses::clear();
+    screenGeneration++; // buffers repaint fully on their next present
     return 0;
 }
 
@@ -60,7 +80,7 @@ static int refresh(lua_State* L) {
     return 0;
 }
 
-// Register the functions with Lua
+// The original functions, still set as globals for older scripts
 static luaL_Reg luaCursesFunctions[] = {
   {"initscr", initscr},
   {"endwin", endwin},
@@ -71,11 +91,36 @@ static luaL_Reg luaCursesFunctions[] = {
   {NULL, NULL}
 };
 
-// Open the curses library in Lua
+static luaL_Reg luaCursesModule[] = {
+  {"newBuffer", lua_new_buffer},
+  {"unloadBuffers", lua_buffer_unload_all},
+  {"nodelay", lua_nodelay},
+  {"timeout", lua_timeout},
+  {"poll", lua_poll},
+  {"watchFd", lua_watch_fd},
+  {"unwatchFd", lua_unwatch_fd},
+  {"newWindow", lua_new_window},
+  {"newPad", lua_new_pad},
+  {"stdscr", lua_stdscr},
+  {"startColor", lua_start_color},
+  {"initPair", lua_init_pair},
+  {"colorPair", lua_color_pair},
+  {"update", lua_update},
+  {NULL, NULL}
+};
+
+// Open the curses library in Lua, local curses = require("curses")
 extern "C" int luaopen_curses(lua_State *L) {
+  registerCellBufferClass(L);
+  registerCursesWindowClass(L);
   for (int i = 0; luaCursesFunctions[i].name; i++) {
     lua_pushcfunction(L, luaCursesFunctions[i].func);
     lua_setglobal(L, luaCursesFunctions[i].name);
   }
-  return 0;
+
+  lua_newtable(L);
+  push_funcs(L, luaCursesFunctions);
+  push_funcs(L, luaCursesModule);
+  pushCursesConstants(L);
+  return 1;
 }
@@ -0,0 +1,325 @@
+// pack.hpp - .pak asset archives and the mount table
+// A pack is one file holding many assets: a header, an index sorted by name,
+// the names, then every file's data at an aligned offset, each one stored or
+// LZ4 compressed on its own and tagged with a hash of its contents. Packs are
+// written offline by tools/pack.cpp and memory mapped when mounted.
+//
+// Mounting puts a pack's files under a virtual directory; the Image, Sound
+// and Font loaders and fs look there before the disk. Music streams can't come
+// from a pack: raylib opens them directly. The mount table lives in the Lua
+// registry, so raylib.so and fs.so see the same mounts.
+//
+//   Pack.mount("bin/assets.pak", "assets")
+//   local img = Image.load("assets/player.png") -- read from the pack
+//
+// Layout (little endian): PackHeader, count PackEntry, names, data.
+#pragma once
+#include <lua.hpp>
+#include "../lz4.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <new>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+#define PACK_MAGIC "RPAK"
+#define PACK_VERSION 1
+#define PACK_REGISTRY_KEY "rocket.packs"
+#define PACK_METATABLE "rocket.PackMounts"
+
+enum PackFlags {
+    PACK_LZ4 = 1 << 0,
+};
+
+struct PackHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t count;       // entries, sorted by name
+    uint32_t alignment;   // of every entry's data offset
+    uint64_t namesOffset; // from the start of the file
+    uint64_t namesSize;
+};
+
+struct PackEntry {
+    uint64_t offset;  // of the data, from the start of the file
+    uint64_t size;    // stored bytes
+    uint64_t rawSize; // bytes once decompressed
+    uint64_t hash;    // packHash of the raw bytes
+    uint32_t flags;   // PackFlags
+    uint32_t nameOffset; // in the names, not NUL terminated
+    uint32_t nameLength;
+    uint32_t reserved;
+};
+
+// FNV-1a 64, the content hash of an entry
+inline uint64_t packHash(const uint8_t* data, size_t n) {
+    uint64_t h = 14695981039346656037ull;
+    for (size_t i = 0; i < n; i++) {
+        h ^= data[i];
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+struct Pack {
+    std::string file;   // the .pak on disk
+    std::string prefix; // virtual directory, "" or ending in '/'
+    const uint8_t* base;
+    size_t size;
+    PackHeader header;
+    const PackEntry* entries;
+    const char* names;
+};
+
+// Maps file and validates its index. Returns NULL on success, or an error message.
+inline const char* packOpen(const char* file, Pack* p) {
+    int fd = open(file, O_RDONLY);
+    if (fd < 0) return "Cannot open pack";
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(PackHeader)) {
+        close(fd);
+        return "Not a pack file";
+    }
+    void* map = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // the mapping stays valid
+    if (map == MAP_FAILED) return "Cannot map pack";
+
+    p->file = file;
+    p->base = (const uint8_t*)map;
+    p->size = st.st_size;
+    memcpy(&p->header, map, sizeof(PackHeader));
+    p->entries = (const PackEntry*)(p->base + sizeof(PackHeader));
+    p->names = (const char*)p->base + p->header.namesOffset;
+
+    const PackHeader& h = p->header;
+    const char* err = nullptr;
+    // bounds are checked by subtracting, offset + size could wrap on a bad file
+    if (memcmp(h.magic, PACK_MAGIC, 4) != 0) err = "Not a pack file";
+    else if (h.version != PACK_VERSION) err = "Unsupported pack version";
+    else if (h.count > (p->size - sizeof(PackHeader)) / sizeof(PackEntry)
+             || h.namesSize > p->size || h.namesOffset > p->size - h.namesSize) err = "Truncated pack file";
+    for (uint32_t i = 0; !err && i < h.count; i++) {
+        const PackEntry& e = p->entries[i];
+        if (e.size > p->size || e.offset > p->size - e.size
+            || e.nameLength > h.namesSize || e.nameOffset > h.namesSize - e.nameLength
+            || (!(e.flags & PACK_LZ4) && e.size != e.rawSize)) err = "Corrupt pack index";
+    }
+    if (err) munmap(map, st.st_size);
+    return err;
+}
+
+inline void packClose(Pack* p) {
+    munmap((void*)p->base, p->size);
+}
+
+inline std::string packEntryName(const Pack& p, const PackEntry& e) {
+    return std::string(p.names + e.nameOffset, e.nameLength);
+}
+
+// Binary search of the index, NULL when the pack has no such file
+inline const PackEntry* packFind(const Pack& p, const char* name, size_t len) {
+    const PackEntry* begin = p.entries;
+    const PackEntry* end = p.entries + p.header.count;
+    const PackEntry* it = std::lower_bound(begin, end, 0, [&](const PackEntry& e, int) {
+        int c = memcmp(p.names + e.nameOffset, name, std::min<size_t>(e.nameLength, len));
+        return c < 0 || (c == 0 && e.nameLength < len);
+    });
+    if (it == end || it->nameLength != len || memcmp(p.names + it->nameOffset, name, len) != 0) return nullptr;
+    return it;
+}
+
+// One file read from a pack: data points into the mapping for stored
+// entries (valid while the pack is mounted), into scratch for compressed ones
+struct PackData {
+    const uint8_t* data;
+    size_t size;
+    std::vector<uint8_t> scratch;
+};
+
+inline bool packDecode(const Pack& p, const PackEntry& e, PackData* out) {
+    const uint8_t* stored = p.base + e.offset;
+    if (!(e.flags & PACK_LZ4)) {
+        out->data = stored;
+        out->size = e.size;
+        return true;
+    }
+    out->scratch.resize(e.rawSize);
+    long long n = lz4Decompress(stored, e.size, out->scratch.data(), e.rawSize);
+    out->data = out->scratch.data();
+    out->size = e.rawSize;
+    return n == (long long)e.rawSize;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Mount table
+// ─────────────────────────────────────────────────────────────────────────────
+
+// Shared by every module: a userdata in the registry, found by packInit
+struct PackMounts {
+    std::vector<Pack*> packs; // searched last mounted first
+};
+
+// This module's pointer to the shared table, set by packInit
+static PackMounts* packMounts = nullptr;
+
+inline int l_PackMountsGC(lua_State* L) {
+    PackMounts* mounts = (PackMounts*)luaL_checkudata(L, 1, PACK_METATABLE);
+    for (Pack* p : mounts->packs) {
+        packClose(p);
+        delete p;
+    }
+    mounts->~PackMounts();
+    return 0;
+}
+
+// Finds the mount table of L, creating it on first use. Every module that
+// reads through packs calls this when it's opened.
+inline PackMounts* packInit(lua_State* L) {
+    if (lua_getfield(L, LUA_REGISTRYINDEX, PACK_REGISTRY_KEY) == LUA_TUSERDATA) {
+        packMounts = (PackMounts*)lua_touserdata(L, -1);
+        lua_pop(L, 1);
+        return packMounts;
+    }
+    lua_pop(L, 1);
+
+    packMounts = new (lua_newuserdatauv(L, sizeof(PackMounts), 0)) PackMounts();
+    if (luaL_newmetatable(L, PACK_METATABLE)) {
+        lua_pushcfunction(L, l_PackMountsGC);
+        lua_setfield(L, -2, "__gc");
+    }
+    lua_setmetatable(L, -2);
+    lua_setfield(L, LUA_REGISTRYINDEX, PACK_REGISTRY_KEY);
+    return packMounts;
+}
+
+// Finds the mounted file at a virtual path ("./" prefixes are ignored)
+inline bool packLookup(const char* path, const Pack** pack, const PackEntry** entry) {
+    if (!packMounts || packMounts->packs.empty()) return false;
+    while (path[0] == '.' && path[1] == '/') path += 2;
+    size_t len = strlen(path);
+    for (auto it = packMounts->packs.rbegin(); it != packMounts->packs.rend(); ++it) {
+        const Pack& p = **it;
+        if (len < p.prefix.size() || memcmp(path, p.prefix.data(), p.prefix.size()) != 0) continue;
+        const PackEntry* e = packFind(p, path + p.prefix.size(), len - p.prefix.size());
+        if (e) {
+            *pack = &p;
+            *entry = e;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Reads a file from the mounted packs, false when none has it (or it's corrupt)
+inline bool packRead(const char* path, PackData* out) {
+    const Pack* p;
+    const PackEntry* e;
+    return packLookup(path, &p, &e) && packDecode(*p, *e, out);
+}
+
+inline bool packExists(const char* path) {
+    const Pack* p;
+    const PackEntry* e;
+    return packLookup(path, &p, &e);
+}
+
+// Pack.mount(file[, prefix]) -> true, or nil and a message. The pack's files
+// appear under prefix ("" by default) and shadow earlier mounts and the disk.
+inline int l_PackMount(lua_State* L) {
+    const char* file = luaL_checkstring(L, 1);
+    std::string prefix = luaL_optstring(L, 2, "");
+    if (!prefix.empty() && prefix.back() != '/') prefix += '/';
+    PackMounts* mounts = packInit(L);
+
+    Pack* p = new Pack();
+    if (const char* err = packOpen(file, p)) {
+        delete p;
+        lua_pushnil(L);
+        lua_pushfstring(L, "%s: '%s'", err, file);
+        return 2;
+    }
+    p->prefix = prefix;
+    mounts->packs.push_back(p);
+    lua_pushboolean(L, 1);
+    return 1;
+}
+
+// Pack.unmount(file) -> whether it was mounted. Assets already loaded from
+// the pack keep working, the loaders copy what they read.
+inline int l_PackUnmount(lua_State* L) {
+    const char* file = luaL_checkstring(L, 1);
+    PackMounts* mounts = packInit(L);
+    for (size_t i = mounts->packs.size(); i-- > 0;) {
+        Pack* p = mounts->packs[i];
+        if (p->file != file) continue;
+        packClose(p);
+        delete p;
+        mounts->packs.erase(mounts->packs.begin() + i);
+        lua_pushboolean(L, 1);
+        return 1;
+    }
+    lua_pushboolean(L, 0);
+    return 1;
+}
+
+// Pack.list(file) -> virtual paths of every file in a mounted pack
+inline int l_PackList(lua_State* L) {
+    const char* file = luaL_checkstring(L, 1);
+    PackMounts* mounts = packInit(L);
+    for (Pack* p : mounts->packs) {
+        if (p->file != file) continue;
+        lua_createtable(L, p->header.count, 0);
+        for (uint32_t i = 0; i < p->header.count; i++) {
+            std::string name = p->prefix + packEntryName(*p, p->entries[i]);
+            lua_pushlstring(L, name.data(), name.size());
+            lua_rawseti(L, -2, i + 1);
+        }
+        return 1;
+    }
+    lua_pushnil(L);
+    lua_pushfstring(L, "Pack not mounted: '%s'", file);
+    return 2;
+}
+
+// Pack.verify(file) -> true, or false and the first damaged file. Decodes
+// and hashes every entry of a mounted pack.
+inline int l_PackVerify(lua_State* L) {
+    const char* file = luaL_checkstring(L, 1);
+    PackMounts* mounts = packInit(L);
+    for (Pack* p : mounts->packs) {
+        if (p->file != file) continue;
+        PackData data;
+        for (uint32_t i = 0; i < p->header.count; i++) {
+            const PackEntry& e = p->entries[i];
+            if (!packDecode(*p, e, &data) || packHash(data.data, data.size) != e.hash) {
+                std::string name = packEntryName(*p, e);
+                lua_pushboolean(L, 0);
+                lua_pushlstring(L, name.data(), name.size());
+                return 2;
+            }
+        }
+        lua_pushboolean(L, 1);
+        return 1;
+    }
+    lua_pushnil(L);
+    lua_pushfstring(L, "Pack not mounted: '%s'", file);
+    return 2;
+}
+
+// Pushes the Pack module table {mount, unmount, list, verify}
+inline void pushPackModule(lua_State* L) {
+    static const luaL_Reg funcs[] = {
+        { "mount", l_PackMount },
+        { "unmount", l_PackUnmount },
+        { "list", l_PackList },
+        { "verify", l_PackVerify },
+        { NULL, NULL }
+    };
+    packInit(L);
+    luaL_newlib(L, funcs);
+}
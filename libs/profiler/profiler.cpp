@@ -0,0 +1,219 @@
+// profiler.cpp - sampling profiler for rocket scripts
+// included by main.cpp, enabled with `rocket --profile out.folded script.lua`
+//
+// A SIGPROF timer only bumps a counter; the samples are attributed to the
+// current call stack from inside the Lua hook, where it is safe to look at
+// the state. The call/return hooks keep a shadow stack per lua_State, which
+// also fire for C functions, so time spent inside bindings (DrawRectangle,
+// Image.load, fs.readFile...) shows up both in the flamegraph and in the
+// per-binding call counts written next to the folded output.
+#pragma once
+#include <lua.hpp>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <sys/time.h>
+#include <algorithm>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace profiler {
+
+struct Frame {
+    int id;
+    uint64_t start;
+};
+
+struct FuncInfo {
+    std::string name;
+    bool isC;
+    uint64_t calls = 0;
+    uint64_t totalNs = 0;
+};
+
+struct FuncKey {
+    const void *ptr; // C function pointer or chunk source
+    int line;        // -1 for C functions
+    bool operator==(const FuncKey &o) const { return ptr == o.ptr && line == o.line; }
+};
+
+struct FuncKeyHash {
+    size_t operator()(const FuncKey &k) const {
+        return std::hash<const void *>()(k.ptr) ^ ((size_t)k.line * 0x9e3779b97f4a7c15ull);
+    }
+};
+
+static volatile sig_atomic_t pendingSamples = 0;
+static bool running = false;
+
+static std::vector<FuncInfo> funcs;
+static std::unordered_map<FuncKey, int, FuncKeyHash> funcIds;
+static std::unordered_map<lua_State *, std::vector<Frame>> stacks;
+static std::map<std::vector<int>, uint64_t> folded;
+
+// last thread seen by the hook, saves a map lookup on every event
+static lua_State *currentL = nullptr;
+static std::vector<Frame> *currentStack = nullptr;
+
+static uint64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+static void onSigprof(int) { pendingSamples = pendingSamples + 1; }
+
+// Expects lua_getinfo(L, "nSf", ar) to have been called, with the function on the stack
+static int functionId(lua_State *L, lua_Debug *ar) {
+    bool isC = ar->what[0] == 'C';
+    FuncKey key = isC ? FuncKey{(const void *)lua_tocfunction(L, -1), -1}
+                      : FuncKey{(const void *)ar->source, ar->linedefined};
+
+    auto it = funcIds.find(key);
+    if (it != funcIds.end()) return it->second;
+
+    FuncInfo info;
+    info.isC = isC;
+    const char *name = ar->name ? ar->name : nullptr;
+    if (isC) {
+        info.name = std::string(name ? name : "?") + " [C]";
+    } else if (strcmp(ar->what, "main") == 0) {
+        info.name = std::string("main chunk (") + ar->short_src + ")";
+    } else {
+        char where[LUA_IDSIZE + 32];
+        snprintf(where, sizeof(where), " (%s:%d)", ar->short_src, ar->linedefined);
+        info.name = std::string(name ? name : "anonymous") + where;
+    }
+
+    int id = (int)funcs.size();
+    funcs.push_back(info);
+    funcIds[key] = id;
+    return id;
+}
+
+static void flushSamples() {
+    int n = pendingSamples;
+    if (n == 0 || !currentStack) return;
+    pendingSamples = pendingSamples - n;
+
+    std::vector<int> key;
+    key.reserve(currentStack->size());
+    for (const Frame &f : *currentStack) key.push_back(f.id);
+    folded[key] += n;
+}
+
+static void popFrame(std::vector<Frame> &stack, uint64_t now) {
+    Frame f = stack.back();
+    stack.pop_back();
+    FuncInfo &info = funcs[f.id];
+    info.calls++;
+    info.totalNs += now - f.start;
+}
+
+static void hook(lua_State *L, lua_Debug *ar) {
+    uint64_t now = nowNs();
+    if (L != currentL) {
+        currentL = L;
+        currentStack = &stacks[L];
+    }
+    std::vector<Frame> &stack = *currentStack;
+
+    // samples taken since the last event belong to the stack as it is now
+    flushSamples();
+
+    switch (ar->event) {
+    case LUA_HOOKTAILCALL:
+        if (!stack.empty()) popFrame(stack, now);
+        // fallthrough
+    case LUA_HOOKCALL: {
+        lua_getinfo(L, "nSf", ar);
+        int id = functionId(L, ar);
+        lua_pop(L, 1);
+        stack.push_back({id, now});
+    } break;
+    case LUA_HOOKRET: {
+        lua_getinfo(L, "Sf", ar);
+        ar->name = nullptr;
+        int id = functionId(L, ar);
+        lua_pop(L, 1);
+        // errors unwind without return events, drop the frames they skipped
+        while (!stack.empty() && stack.back().id != id) stack.pop_back();
+        if (!stack.empty()) popFrame(stack, now);
+    } break;
+    default:
+        break;
+    }
+}
+
+// Start sampling every `intervalUs` microseconds of CPU time
+static void start(lua_State *L, int intervalUs = 1000) {
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = onSigprof;
+    sa.sa_flags = SA_RESTART;
+    sigaction(SIGPROF, &sa, nullptr);
+
+    struct itimerval timer;
+    timer.it_interval.tv_sec = intervalUs / 1000000;
+    timer.it_interval.tv_usec = intervalUs % 1000000;
+    timer.it_value = timer.it_interval;
+    setitimer(ITIMER_PROF, &timer, nullptr);
+
+    // the count hook makes sure long loops without calls still get their samples
+    lua_sethook(L, hook, LUA_MASKCALL | LUA_MASKRET | LUA_MASKCOUNT, 1000);
+    running = true;
+}
+
+// Stop sampling and write `path` (folded stacks) and `path`.calls (per function stats)
+static bool stop(lua_State *L, const char *path) {
+    if (!running) return false;
+    running = false;
+
+    struct itimerval timer;
+    memset(&timer, 0, sizeof(timer));
+    setitimer(ITIMER_PROF, &timer, nullptr);
+    lua_sethook(L, nullptr, 0, 0);
+
+    FILE *out = fopen(path, "w");
+    if (!out) {
+        fprintf(stderr, "profiler: cannot open '%s' for writing\n", path);
+        return false;
+    }
+    for (const auto &entry : folded) {
+        for (size_t i = 0; i < entry.first.size(); i++) {
+            if (i) fputc(';', out);
+            fputs(funcs[entry.first[i]].name.c_str(), out);
+        }
+        if (entry.first.empty()) fputs("[idle]", out);
+        fprintf(out, " %llu\n", (unsigned long long)entry.second);
+    }
+    fclose(out);
+
+    std::string callsPath = std::string(path) + ".calls";
+    out = fopen(callsPath.c_str(), "w");
+    if (!out) {
+        fprintf(stderr, "profiler: cannot open '%s' for writing\n", callsPath.c_str());
+        return false;
+    }
+    std::vector<const FuncInfo *> sorted;
+    for (const FuncInfo &info : funcs)
+        if (info.calls) sorted.push_back(&info);
+    std::sort(sorted.begin(), sorted.end(),
+              [](const FuncInfo *a, const FuncInfo *b) { return a->totalNs > b->totalNs; });
+
+    fprintf(out, "# function\tcalls\ttotal_ms\tavg_us\n");
+    for (const FuncInfo *info : sorted) {
+        fprintf(out, "%s\t%llu\t%.3f\t%.3f\n", info->name.c_str(),
+                (unsigned long long)info->calls, info->totalNs / 1e6,
+                info->totalNs / 1e3 / info->calls);
+    }
+    fclose(out);
+
+    fprintf(stderr, "profiler: wrote %s and %s\n", path, callsPath.c_str());
+    return true;
+}
+
+} // namespace profiler
@@ -220,7 +220,7 @@ void mu_set_focus(mu_Context *ctx, mu_Id id) {
 #define HASH_INITIAL 2166136261
 
 static void hash(mu_Id *hash, const void *data, int size) {
-  const unsigned char *p = data;
+  const unsigned char *p = (const unsigned char*) data;
   while (size--) {
     *hash = (*hash ^ *p++) * 16777619;
   }
@@ -442,7 +442,7 @@ int mu_next_command(mu_Context *ctx, mu_Command **cmd) {
   }
   while ((char*) *cmd != ctx->command_list.items + ctx->command_list.idx) {
     if ((*cmd)->type != MU_COMMAND_JUMP) { return 1; }
-    *cmd = (*cmd)->jump.dst;
+    *cmd = (mu_Command*) (*cmd)->jump.dst;
   }
   return 0;
 }
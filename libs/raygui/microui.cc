@@ -2,54 +2,289 @@ extern "C" {
 #include "microui.h"
 #include "microui.c"
 }
-#include "../../ffi.hpp" // getArgByName
+// microui.c leaks its private helper macros into the unity build
+#undef unused
+#undef expect
+#undef push
+#undef pop
+#undef scrollbar
+#include "../../../libs/lua_ffi.hpp" // pushPtr, getPtr, getArgByName
+#include "rgui-textbox.cpp"          // GuiTextState, used by UI.Textbox
+#include "../raylib/ray-font.cpp"    // defaultFontFace, fontLayout
+#include <algorithm>
 #include <assert.h>
+#include <math.h>
 #include <raylib.h>
+#include <rlgl.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <vector>
 
 #include "lua.hpp"
 
+// this file is included by raylib.cpp after raygui.cpp
+//
+// Frame order from Lua:
+//   UI.Begin(ctx) ... widgets ... UI.End(ctx)
+//   UI.Update(ctx) -- feeds input for the next frame and draws this one
+// (or UI.Input/UI.Draw separately)
+
 #define FONT_SIZE 16
+#define ICON_SIZE 16
+
+struct MicContext {
+  mu_Context mu;
+  int widgetCounter; // positional ids for widgets keyed by a value pointer
+};
+
+static std::vector<MicContext *> micPool;
 
+// One texture holds the default font glyphs, the icons and a white texel for
+// rects, so everything inside a clip region is drawn with one draw call
+static struct {
+  Texture2D texture;
+  Font font; // the default font, pointing at `texture`
+  Rectangle white;
+  Rectangle icons[MU_ICON_MAX];
+} micAtlas = {};
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Icon atlas
+// The four microui icons are rasterized once into the atlas, antialiased by
+// distance to their strokes (close, check) or by supersampling (arrows).
+// ─────────────────────────────────────────────────────────────────────────────
+
+static float micSegmentDistance(float px, float py, float ax, float ay,
+                                float bx, float by) {
+  float dx = bx - ax, dy = by - ay;
+  float t = ((px - ax) * dx + (py - ay) * dy) / (dx * dx + dy * dy);
+  t = std::max(0.0f, std::min(1.0f, t));
+  float ex = px - (ax + t * dx), ey = py - (ay + t * dy);
+  return sqrtf(ex * ex + ey * ey);
+}
+
+static bool micInTriangle(float px, float py, const float *t) {
+  float d1 = (px - t[2]) * (t[1] - t[3]) - (t[0] - t[2]) * (py - t[3]);
+  float d2 = (px - t[4]) * (t[3] - t[5]) - (t[2] - t[4]) * (py - t[5]);
+  float d3 = (px - t[0]) * (t[5] - t[1]) - (t[4] - t[0]) * (py - t[1]);
+  bool neg = d1 < 0 || d2 < 0 || d3 < 0, pos = d1 > 0 || d2 > 0 || d3 > 0;
+  return !(neg && pos);
+}
+
+// coverage of the pixel centered at x, y (0..ICON_SIZE)
+static float micIconCoverage(int id, float x, float y) {
+  static const float collapsed[6] = {5, 3, 12, 8, 5, 13};
+  static const float expanded[6] = {3, 5, 13, 5, 8, 12};
+  switch (id) {
+  case MU_ICON_CLOSE: {
+    float d = std::min(micSegmentDistance(x, y, 4, 4, 12, 12),
+                       micSegmentDistance(x, y, 12, 4, 4, 12));
+    return std::max(0.0f, std::min(1.0f, 1.75f - d));
+  }
+  case MU_ICON_CHECK: {
+    float d = std::min(micSegmentDistance(x, y, 3, 8.5f, 6.5f, 12),
+                       micSegmentDistance(x, y, 6.5f, 12, 13, 4));
+    return std::max(0.0f, std::min(1.0f, 1.75f - d));
+  }
+  case MU_ICON_COLLAPSED:
+  case MU_ICON_EXPANDED: {
+    const float *tri = id == MU_ICON_COLLAPSED ? collapsed : expanded;
+    int hits = 0;
+    for (int sy = 0; sy < 4; sy++)
+      for (int sx = 0; sx < 4; sx++)
+        hits += micInTriangle(x - 0.375f + sx * 0.25f, y - 0.375f + sy * 0.25f, tri);
+    return hits / 16.0f;
+  }
+  }
+  return 0;
+}
+
+// needs a GL context, called on first draw or measure
+static void micAtlasInit() {
+  if (micAtlas.texture.id) return;
+
+  Font base = GetFontDefault();
+  Image fontImg = LoadImageFromTexture(base.texture);
+  ImageFormat(&fontImg, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+
+  int iconsWidth = 4 + (MU_ICON_MAX - 1) * (ICON_SIZE + 2);
+  int width = std::max(fontImg.width, iconsWidth);
+  int height = fontImg.height + ICON_SIZE + 2;
+  Image atlas = GenImageColor(width, height, BLANK);
+  Color *dst = (Color *)atlas.data;
+  Color *src = (Color *)fontImg.data;
+  for (int y = 0; y < fontImg.height; y++)
+    memcpy(&dst[y * width], &src[y * fontImg.width], fontImg.width * sizeof(Color));
+
+  // 2x2 white block, sampled in the middle so filtering never reaches BLANK
+  int row = fontImg.height + 1;
+  for (int y = 0; y < 2; y++)
+    for (int x = 0; x < 2; x++) dst[(row + y) * width + x] = WHITE;
+  micAtlas.white = {0.5f, row + 0.5f, 1, 1};
+
+  for (int id = 1; id < MU_ICON_MAX; id++) {
+    int ox = 4 + (id - 1) * (ICON_SIZE + 2);
+    for (int y = 0; y < ICON_SIZE; y++) {
+      for (int x = 0; x < ICON_SIZE; x++) {
+        float a = micIconCoverage(id, x + 0.5f, y + 0.5f);
+        dst[(row + y) * width + ox + x] = {255, 255, 255, (unsigned char)(a * 255)};
+      }
+    }
+    micAtlas.icons[id] = {(float)ox, (float)row, ICON_SIZE, ICON_SIZE};
+  }
+
+  micAtlas.texture = LoadTextureFromImage(atlas);
+  micAtlas.font = base;
+  micAtlas.font.texture = micAtlas.texture; // recs are unchanged, the glyphs were copied at 0,0
+  UnloadImage(atlas);
+  UnloadImage(fontImg);
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Text, drawn with the same metrics the layout cache measures with
+// ─────────────────────────────────────────────────────────────────────────────
+
+// same scale and spacing as DrawText
+static float micTextScale() { return (float)FONT_SIZE / micAtlas.font.baseSize; }
+static int micTextSpacing() { return FONT_SIZE / 10; }
+
+// calls fn(glyph index, codepoint, x) for every glyph of str[0..len), returns the width
+template <typename Fn>
+static float micForEachGlyph(const char *str, int len, Fn fn) {
+  const Font &font = micAtlas.font;
+  float scale = micTextScale(), x = 0;
+  int glyphs = 0;
+  for (int i = 0; i < len && str[i];) {
+    int size = 0;
+    int cp = GetCodepointNext(str + i, &size);
+    int index = GetGlyphIndex(font, cp);
+    fn(index, cp, x);
+    int advance = font.glyphs[index].advanceX;
+    x += (advance ? advance : font.recs[index].width) * scale + micTextSpacing();
+    glyphs++;
+    i += size;
+  }
+  return glyphs ? x - micTextSpacing() : 0;
+}
+
+// microui measures the same labels every frame, so this goes through the
+// default font's layout cache (ray-font.cpp), which uses the same glyph walk
 int text_width(mu_Font font, const char *str, int len) {
-  return MeasureText(str, FONT_SIZE);
+  if (len < 0) len = (int)strlen(str); // microui passes -1 for whole strings
+  FontFace *face = defaultFontFace();
+  if (!face->font.texture.id) return 0;
+  return (int)ceilf(fontLayout(face, str, len, FONT_SIZE).width);
 }
 
 int text_height(mu_Font font) { return FONT_SIZE; }
-static int init_mic(lua_State *L) {
-  mu_Context *ctx = (mu_Context *)malloc(sizeof(mu_Context));
-  mu_init(ctx);
-  ctx->text_height = text_height;
-  ctx->text_width = text_width;
-  pushPtr(L, ctx); // or false if you're managing it yourself
 
-  return 1;
+// ─────────────────────────────────────────────────────────────────────────────
+// Renderer
+// ─────────────────────────────────────────────────────────────────────────────
+
+
+// must be inside rlBegin(RL_QUADS) with the atlas texture set
+static void micQuad(Rectangle dst, Rectangle src, mu_Color c) {
+  float w = micAtlas.texture.width, h = micAtlas.texture.height;
+  float u0 = src.x / w, v0 = src.y / h;
+  float u1 = (src.x + src.width) / w, v1 = (src.y + src.height) / h;
+
+  rlCheckRenderBatchLimit(4); // flushes and restores the mode/texture if full
+  rlColor4ub(c.r, c.g, c.b, c.a);
+  rlTexCoord2f(u0, v0);
+  rlVertex2f(dst.x, dst.y);
+  rlTexCoord2f(u0, v1);
+  rlVertex2f(dst.x, dst.y + dst.height);
+  rlTexCoord2f(u1, v1);
+  rlVertex2f(dst.x + dst.width, dst.y + dst.height);
+  rlTexCoord2f(u1, v0);
+  rlVertex2f(dst.x + dst.width, dst.y);
 }
-static int begin_mic(lua_State *L) {
-  mu_Context *ctx = getPtr<mu_Context>(L, 1);
-  mu_begin(ctx);
-  return 0;
+
+static void micDrawText(const char *str, float px, float py, mu_Color color) {
+  const Font &font = micAtlas.font;
+  float scale = micTextScale();
+  float pad = font.glyphPadding;
+  micForEachGlyph(str, (int)strlen(str), [&](int index, int cp, float x) {
+    if (cp == ' ' || cp == '\t') return;
+    Rectangle rec = font.recs[index];
+    Rectangle src = {rec.x - pad, rec.y - pad, rec.width + 2 * pad,
+                     rec.height + 2 * pad};
+    Rectangle dst = {px + x + (font.glyphs[index].offsetX - pad) * scale,
+                     py + (font.glyphs[index].offsetY - pad) * scale,
+                     src.width * scale, src.height * scale};
+    micQuad(dst, src, color);
+  });
 }
-static mu_Rect unclipped_rect = {0, 0, 0x1000000, 0x1000000};
 
-static int update_mic(lua_State *L) {
-  mu_Context *ctx = getPtr<mu_Context>(L, 1);
+static void micRender(mu_Context *ctx) {
+  micAtlasInit();
+
+  mu_Rect clip = unclipped_rect;
+  rlSetTexture(micAtlas.texture.id);
+  rlBegin(RL_QUADS);
 
+  mu_Command *cmd = NULL;
+  while (mu_next_command(ctx, &cmd)) { // follows MU_COMMAND_JUMP itself
+    switch (cmd->type) {
+    case MU_COMMAND_CLIP: {
+      // windows re-send their clip rect a lot, only a real change ends the batch
+      if (memcmp(&cmd->clip.rect, &clip, sizeof(mu_Rect)) == 0) break;
+      clip = cmd->clip.rect;
+
+      rlEnd();
+      rlSetTexture(0);
+      if (memcmp(&clip, &unclipped_rect, sizeof(mu_Rect)) == 0) {
+        EndScissorMode();
+      } else {
+        BeginScissorMode(clip.x, clip.y, clip.w, clip.h);
+      }
+      rlSetTexture(micAtlas.texture.id);
+      rlBegin(RL_QUADS);
+    } break;
+    case MU_COMMAND_RECT: {
+      mu_Rect r = cmd->rect.rect;
+      micQuad({(float)r.x, (float)r.y, (float)r.w, (float)r.h}, micAtlas.white,
+              cmd->rect.color);
+    } break;
+    case MU_COMMAND_TEXT: {
+      micDrawText(cmd->text.str, cmd->text.pos.x, cmd->text.pos.y,
+                  cmd->text.color);
+    } break;
+    case MU_COMMAND_ICON: {
+      if (cmd->icon.id <= 0 || cmd->icon.id >= MU_ICON_MAX) break;
+      mu_Rect r = cmd->icon.rect;
+      Rectangle dst = {(float)(r.x + (r.w - ICON_SIZE) / 2),
+                       (float)(r.y + (r.h - ICON_SIZE) / 2), ICON_SIZE,
+                       ICON_SIZE};
+      micQuad(dst, micAtlas.icons[cmd->icon.id], cmd->icon.color);
+    } break;
+    default:
+      break;
+    }
+  }
+
+  rlEnd();
+  rlSetTexture(0);
+  if (memcmp(&clip, &unclipped_rect, sizeof(mu_Rect)) != 0) EndScissorMode();
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Input
+// ─────────────────────────────────────────────────────────────────────────────
+
+static void micInput(mu_Context *ctx) {
   int k = 0;
   while ((k = GetCharPressed()) != 0) {
-    char chr[2] = {char(k), 0};
+    int size = 0;
+    const char *utf8 = CodepointToUTF8(k, &size);
+    char chr[5] = {0};
+    memcpy(chr, utf8, size);
     mu_input_text(ctx, chr);
   }
 
-  /*
-  enum {
-    MU_MOUSE_LEFT       = (1 << 0),
-    MU_MOUSE_RIGHT      = (1 << 1),
-    MU_MOUSE_MIDDLE     = (1 << 2)
-  };
-  */
+  // MU_MOUSE_LEFT/RIGHT/MIDDLE are 1 << the raylib button number
   int _mx = GetMouseX();
   int _my = GetMouseY();
   mu_input_mousemove(ctx, _mx, _my);
@@ -60,22 +295,11 @@ static int update_mic(lua_State *L) {
       mu_input_mouseup(ctx, _mx, _my, 1 << btn);
     }
   }
+  // microui scrolls in pixels, the wheel moves in notches
   Vector2 scroll = GetMouseWheelMoveV();
-  mu_input_scroll(ctx, scroll.x, scroll.y);
-
-  /*
+  mu_input_scroll(ctx, (int)(scroll.x * -30), (int)(scroll.y * -30));
 
-  enum {
-          MU_KEY_SHIFT        = (1 << 0),
-          MU_KEY_CTRL         = (1 << 1),
-          MU_KEY_ALT          = (1 << 2),
-          MU_KEY_BACKSPACE    = (1 << 3),
-          MU_KEY_RETURN       = (1 << 4)
-  };
-  */
   int keys[8][2] = {
-      // i literaly had no clue this thing would work, i guess i understand a
-      // bit of C
       {KEY_LEFT_SHIFT, MU_KEY_SHIFT},  {KEY_RIGHT_SHIFT, MU_KEY_SHIFT},
       {KEY_LEFT_CONTROL, MU_KEY_CTRL}, {KEY_RIGHT_CONTROL, MU_KEY_CTRL},
       {KEY_LEFT_ALT, MU_KEY_ALT},      {KEY_RIGHT_ALT, MU_KEY_ALT},
@@ -83,89 +307,304 @@ static int update_mic(lua_State *L) {
       {KEY_ENTER, MU_KEY_RETURN},      {KEY_BACKSPACE, MU_KEY_BACKSPACE},
   };
 
+  // keydown marks the key as pressed for one frame, so only send it on press
+  // (and on key repeat, for backspace)
   for (int i = 0; i < 8; i++) {
-    if (IsKeyDown(keys[i][0])) {
+    if (IsKeyPressed(keys[i][0]) || IsKeyPressedRepeat(keys[i][0])) {
       mu_input_keydown(ctx, keys[i][1]);
     } else if (IsKeyReleased(keys[i][0])) {
       mu_input_keyup(ctx, keys[i][1]);
     }
   }
+}
 
-  mu_Command *cmd = NULL;
-  // mu_Command **cmd
-  while (mu_next_command(ctx, &cmd)) {
-    switch (cmd->type) {
-    case MU_COMMAND_JUMP: {
-      const char *msg =
-          TextFormat("%s:%i: not handled yet\n", __FILE__, __LINE__ + 1);
-      fprintf(stderr, "%s\n", msg);
-      abort();
+// ─────────────────────────────────────────────────────────────────────────────
+// Lua bindings
+// ─────────────────────────────────────────────────────────────────────────────
 
-    } break;
-    case MU_COMMAND_CLIP: {
-      if (memcmp(&cmd->clip.rect, &unclipped_rect, sizeof(mu_Rect)) == 0) {
-        EndScissorMode();
-      } else {
-        BeginScissorMode(cmd->clip.rect.x, cmd->clip.rect.y, cmd->clip.rect.w,
-                         cmd->clip.rect.h);
-      }
-    } break;
-    case MU_COMMAND_RECT: {
-      DrawRectangle(cmd->rect.rect.x, cmd->rect.rect.y, cmd->rect.rect.w,
-                    cmd->rect.rect.h,
-                    (Color){cmd->rect.color.r, cmd->rect.color.g,
-                            cmd->rect.color.b, cmd->rect.color.a});
-    } break;
-    case MU_COMMAND_TEXT: {
-      int posX = cmd->text.pos.x;
-      int posY = cmd->text.pos.y;
+static mu_Rect mic_getRect(lua_State *L, int idx) {
+  return mu_rect((int)getArgByName(L, "x", idx), (int)getArgByName(L, "y", idx),
+                 (int)getArgByName(L, "width", idx),
+                 (int)getArgByName(L, "height", idx));
+}
 
-      int w = MeasureText(cmd->text.str, FONT_SIZE);
+// slider/number/checkbox derive their id from the value pointer, which is a
+// stack temporary here, so every such widget gets the next positional id
+static void mic_pushWidgetId(MicContext *ctx) {
+  ctx->widgetCounter++;
+  mu_push_id(&ctx->mu, &ctx->widgetCounter, sizeof(int));
+}
 
-      DrawText(cmd->text.str, posX, posY, FONT_SIZE,
-               (Color){cmd->text.color.r, cmd->text.color.g, cmd->text.color.b,
-                       cmd->text.color.a});
+static int init_mic(lua_State *L) {
+  MicContext *ctx = new MicContext();
+  mu_init(&ctx->mu);
+  ctx->mu.text_height = text_height;
+  ctx->mu.text_width = text_width;
+  micPool.push_back(ctx);
+  pushPtr(L, ctx); // Pushed as userdata, no __gc
 
-    } break;
-    case MU_COMMAND_ICON: {
-      // i have no clue how to render the icons microui wants
-      DrawRectangle(cmd->icon.rect.x, cmd->icon.rect.y, cmd->icon.rect.w,
-                    cmd->icon.rect.h, RED);
-      if (cmd->icon.id == MU_ICON_CLOSE) {
-        DrawLine(cmd->icon.rect.x, cmd->icon.rect.y,
-                 cmd->icon.rect.x + cmd->icon.rect.w,
-                 cmd->icon.rect.y + cmd->icon.rect.h, WHITE);
-        DrawLine(cmd->icon.rect.x + cmd->icon.rect.w, cmd->icon.rect.y,
-                 cmd->icon.rect.x, cmd->icon.rect.y + cmd->icon.rect.h, WHITE);
-      }
+  return 1;
+}
+static int begin_mic(lua_State *L) {
+  MicContext *ctx = getPtr<MicContext>(L, 1);
+  ctx->widgetCounter = 0;
+  mu_begin(&ctx->mu);
+  return 0;
+}
 
-      // DrawText(TextFormat("%i",cmd->icon.id), cmd->icon.rect.x,
-      // cmd->icon.rect.y, 8, WHITE);
+static int end_mic(lua_State *L) {
+  MicContext *ctx = getPtr<MicContext>(L, 1);
+  mu_end(&ctx->mu);
+  return 0;
+}
 
-      /*
-      const char*msg =TextFormat("%s:%i: not handled yet\n", __FILE__,
-      __LINE__+1); fprintf(stderr, "%s\n", msg); abort();
-      */
+static int input_mic(lua_State *L) {
+  micInput(&getPtr<MicContext>(L, 1)->mu);
+  return 0;
+}
 
-    } break;
-    default:
-      break;
-    }
+static int draw_mic(lua_State *L) {
+  micRender(&getPtr<MicContext>(L, 1)->mu);
+  return 0;
+}
+
+// input for the next frame, then draw the commands of the frame that just ended
+static int update_mic(lua_State *L) {
+  MicContext *ctx = getPtr<MicContext>(L, 1);
+  micInput(&ctx->mu);
+  micRender(&ctx->mu);
+  return 0;
+}
+
+// UI.BeginWindow(ctx, title, rect[, opt]) -> open
+static int begin_window_mic(lua_State *L) {
+  MicContext *ctx = getPtr<MicContext>(L, 1);
+  const char *title = luaL_checkstring(L, 2);
+  mu_Rect rect = mic_getRect(L, 3);
+  int opt = luaL_optinteger(L, 4, 0);
+  lua_pushboolean(L, mu_begin_window_ex(&ctx->mu, title, rect, opt));
+  return 1;
+}
+
+static int end_window_mic(lua_State *L) {
+  mu_end_window(&getPtr<MicContext>(L, 1)->mu);
+  return 0;
+}
+
+// UI.LayoutRow(ctx, {widths...}, height)
+static int layout_row_mic(lua_State *L) {
+  MicContext *ctx = getPtr<MicContext>(L, 1);
+  luaL_checktype(L, 2, LUA_TTABLE);
+  int height = luaL_optinteger(L, 3, 0);
+  int widths[MU_MAX_WIDTHS];
+  int items = std::min((int)lua_rawlen(L, 2), MU_MAX_WIDTHS);
+  for (int i = 0; i < items; i++) {
+    lua_rawgeti(L, 2, i + 1);
+    widths[i] = (int)lua_tointeger(L, -1);
+    lua_pop(L, 1);
   }
+  mu_layout_row(&ctx->mu, items, widths, height);
   return 0;
 }
 
-static int end_mic(lua_State *L) {
-  mu_Context *ctx = getPtr<mu_Context>(L, 1);
-  mu_end(ctx);
+static int label_mic(lua_State *L) {
+  mu_label(&getPtr<MicContext>(L, 1)->mu, luaL_checkstring(L, 2));
+  return 0;
+}
+
+static int text_mic(lua_State *L) {
+  mu_text(&getPtr<MicContext>(L, 1)->mu, luaL_checkstring(L, 2));
+  return 0;
+}
+
+// UI.Button(ctx, label[, icon, opt]) -> clicked
+static int button_mic(lua_State *L) {
+  MicContext *ctx = getPtr<MicContext>(L, 1);
+  const char *label = luaL_checkstring(L, 2);
+  int icon = luaL_optinteger(L, 3, 0);
+  int opt = luaL_optinteger(L, 4, MU_OPT_ALIGNCENTER);
+  lua_pushboolean(L, mu_button_ex(&ctx->mu, label, icon, opt) & MU_RES_SUBMIT);
+  return 1;
+}
+
+// UI.Checkbox(ctx, label, checked) -> checked, changed
+static int checkbox_mic(lua_State *L) {
+  MicContext *ctx = getPtr<MicContext>(L, 1);
+  const char *label = luaL_checkstring(L, 2);
+  int state = lua_toboolean(L, 3);
+  mic_pushWidgetId(ctx);
+  int res = mu_checkbox(&ctx->mu, label, &state);
+  mu_pop_id(&ctx->mu);
+  lua_pushboolean(L, state);
+  lua_pushboolean(L, res & MU_RES_CHANGE);
+  return 2;
+}
+
+// UI.Slider(ctx, value, low, high[, step, fmt]) -> value, changed
+static int slider_mic(lua_State *L) {
+  MicContext *ctx = getPtr<MicContext>(L, 1);
+  mu_Real value = luaL_checknumber(L, 2);
+  mu_Real low = luaL_checknumber(L, 3);
+  mu_Real high = luaL_checknumber(L, 4);
+  mu_Real step = luaL_optnumber(L, 5, 0);
+  const char *fmt = luaL_optstring(L, 6, MU_SLIDER_FMT);
+  mic_pushWidgetId(ctx);
+  int res = mu_slider_ex(&ctx->mu, &value, low, high, step, fmt, MU_OPT_ALIGNCENTER);
+  mu_pop_id(&ctx->mu);
+  lua_pushnumber(L, value);
+  lua_pushboolean(L, res & MU_RES_CHANGE);
+  return 2;
+}
+
+// UI.Number(ctx, value, step[, fmt]) -> value, changed
+static int number_mic(lua_State *L) {
+  MicContext *ctx = getPtr<MicContext>(L, 1);
+  mu_Real value = luaL_checknumber(L, 2);
+  mu_Real step = luaL_checknumber(L, 3);
+  const char *fmt = luaL_optstring(L, 4, MU_SLIDER_FMT);
+  mic_pushWidgetId(ctx);
+  int res = mu_number_ex(&ctx->mu, &value, step, fmt, MU_OPT_ALIGNCENTER);
+  mu_pop_id(&ctx->mu);
+  lua_pushnumber(L, value);
+  lua_pushboolean(L, res & MU_RES_CHANGE);
+  return 2;
+}
+
+// UI.Textbox(ctx, textbox[, opt]) -> result flags
+// textbox is an rgui.newTextbox object, its buffer is edited in place
+static int textbox_mic(lua_State *L) {
+  MicContext *ctx = getPtr<MicContext>(L, 1);
+  GuiTextState *t = getPtr<GuiTextState>(L, 2);
+  int opt = luaL_optinteger(L, 3, 0);
+  int res = mu_textbox_ex(&ctx->mu, t->buffer.data(), (int)t->buffer.size(), opt);
+  if (res & MU_RES_CHANGE) {
+    t->length = strlen(t->buffer.data());
+    t->hash = 0;
+    guiTextInvalidate(L, *t);
+  }
+  lua_pushinteger(L, res);
+  return 1;
+}
+
+// UI.Header(ctx, label[, opt]) -> expanded
+static int header_mic(lua_State *L) {
+  MicContext *ctx = getPtr<MicContext>(L, 1);
+  lua_pushboolean(L, mu_header_ex(&ctx->mu, luaL_checkstring(L, 2), luaL_optinteger(L, 3, 0)));
+  return 1;
+}
+
+static int begin_treenode_mic(lua_State *L) {
+  MicContext *ctx = getPtr<MicContext>(L, 1);
+  lua_pushboolean(L, mu_begin_treenode_ex(&ctx->mu, luaL_checkstring(L, 2), luaL_optinteger(L, 3, 0)));
+  return 1;
+}
+
+static int end_treenode_mic(lua_State *L) {
+  mu_end_treenode(&getPtr<MicContext>(L, 1)->mu);
+  return 0;
+}
+
+static int begin_panel_mic(lua_State *L) {
+  MicContext *ctx = getPtr<MicContext>(L, 1);
+  mu_begin_panel_ex(&ctx->mu, luaL_checkstring(L, 2), luaL_optinteger(L, 3, 0));
+  return 0;
+}
+
+static int end_panel_mic(lua_State *L) {
+  mu_end_panel(&getPtr<MicContext>(L, 1)->mu);
+  return 0;
+}
+
+static int open_popup_mic(lua_State *L) {
+  mu_open_popup(&getPtr<MicContext>(L, 1)->mu, luaL_checkstring(L, 2));
+  return 0;
+}
+
+static int begin_popup_mic(lua_State *L) {
+  MicContext *ctx = getPtr<MicContext>(L, 1);
+  lua_pushboolean(L, mu_begin_popup(&ctx->mu, luaL_checkstring(L, 2)));
+  return 1;
+}
+
+static int end_popup_mic(lua_State *L) {
+  mu_end_popup(&getPtr<MicContext>(L, 1)->mu);
+  return 0;
+}
+
+static int unload_mic(lua_State *L) {
+  MicContext *ctx = getPtr<MicContext>(L, 1);
+  if (!ctx) return 0;
+  micPool.erase(std::remove(micPool.begin(), micPool.end(), ctx), micPool.end());
+  delete ctx;
+  return 0;
+}
+
+static int unload_all_mic(lua_State *L) {
+  for (MicContext *ctx : micPool) delete ctx;
+  micPool.clear();
+  if (micAtlas.texture.id) UnloadTexture(micAtlas.texture);
+  micAtlas = {};
   return 0;
 }
 
 void setup_microui(lua_State *L) {
+  // methods and module functions are the same, so ctx:Button("Ok") works too
   static luaL_Reg funcs[] = {
-      {"Init", init_mic},     {"Begin", begin_mic}, {"End", end_mic},
-      {"Update", update_mic}, {NULL, NULL},
+      {"Init", init_mic},
+      {"Begin", begin_mic},
+      {"End", end_mic},
+      {"Update", update_mic},
+      {"Input", input_mic},
+      {"Draw", draw_mic},
+      {"BeginWindow", begin_window_mic},
+      {"EndWindow", end_window_mic},
+      {"LayoutRow", layout_row_mic},
+      {"Label", label_mic},
+      {"Text", text_mic},
+      {"Button", button_mic},
+      {"Checkbox", checkbox_mic},
+      {"Slider", slider_mic},
+      {"Number", number_mic},
+      {"Textbox", textbox_mic},
+      {"Header", header_mic},
+      {"BeginTreenode", begin_treenode_mic},
+      {"EndTreenode", end_treenode_mic},
+      {"BeginPanel", begin_panel_mic},
+      {"EndPanel", end_panel_mic},
+      {"OpenPopup", open_popup_mic},
+      {"BeginPopup", begin_popup_mic},
+      {"EndPopup", end_popup_mic},
+      {"Unload", unload_mic},
+      {"UnloadAll", unload_all_mic},
+      {NULL, NULL},
   };
 
+  if (luaL_newmetatable(L, typeid(MicContext).name())) {
+    lua_pushstring(L, "__index");
+    lua_newtable(L);
+    push_funcs(L, funcs);
+    lua_settable(L, -3); // metatable.__index = table
+  }
+  lua_pop(L, 1);
+
   newModule("UI", funcs, L);
+
+  lua_getglobal(L, "UI");
+  static const struct { const char *name; int value; } constants[] = {
+      {"OPT_ALIGNCENTER", MU_OPT_ALIGNCENTER}, {"OPT_ALIGNRIGHT", MU_OPT_ALIGNRIGHT},
+      {"OPT_NOINTERACT", MU_OPT_NOINTERACT},   {"OPT_NOFRAME", MU_OPT_NOFRAME},
+      {"OPT_NORESIZE", MU_OPT_NORESIZE},       {"OPT_NOSCROLL", MU_OPT_NOSCROLL},
+      {"OPT_NOCLOSE", MU_OPT_NOCLOSE},         {"OPT_NOTITLE", MU_OPT_NOTITLE},
+      {"OPT_HOLDFOCUS", MU_OPT_HOLDFOCUS},     {"OPT_AUTOSIZE", MU_OPT_AUTOSIZE},
+      {"OPT_POPUP", MU_OPT_POPUP},             {"OPT_CLOSED", MU_OPT_CLOSED},
+      {"OPT_EXPANDED", MU_OPT_EXPANDED},       {"RES_ACTIVE", MU_RES_ACTIVE},
+      {"RES_SUBMIT", MU_RES_SUBMIT},           {"RES_CHANGE", MU_RES_CHANGE},
+      {"ICON_CLOSE", MU_ICON_CLOSE},           {"ICON_CHECK", MU_ICON_CHECK},
+      {"ICON_COLLAPSED", MU_ICON_COLLAPSED},   {"ICON_EXPANDED", MU_ICON_EXPANDED},
+  };
+  for (const auto &c : constants) {
+    lua_pushinteger(L, c.value);
+    lua_setfield(L, -2, c.name);
+  }
+  lua_pop(L, 1);
 }
@@ -7,6 +7,7 @@
 #include "raygui.h"
 #include <lua.hpp>
 #include "../../../libs/lua_ffi.hpp" // getArgByName
+#include <vector>
 
 static int lua_rgui_button(lua_State *L){
 	//GuiButton(Rectangle bounds, const char *text)
@@ -82,26 +83,30 @@ static int lua_rgui_textbox(lua_State *L){
 		(float)getArgByName(L, "height", 1)
 	};
 
-	const char* input = luaL_checkstring(L, 2);
+	size_t inputLen;
+	const char* input = luaL_checklstring(L, 2, &inputLen);
 	int maxSize = luaL_checkinteger(L, 3);
 	bool editMode = lua_toboolean(L, 4);
+	luaL_argcheck(L, maxSize > 0, 3, "maxSize must be positive");
 
-	// Allocate a writable buffer and copy the string
-	char* buffer = new char[maxSize];
-	strncpy(buffer, input, maxSize);
-	buffer[maxSize - 1] = '\0'; // Ensure null termination
+	// Reuse one scratch buffer instead of allocating every frame
+	static std::vector<char> buffer;
+	if (buffer.size() < (size_t)maxSize) buffer.resize(maxSize);
+	size_t len = std::min(inputLen, (size_t)maxSize - 1);
+	memcpy(buffer.data(), input, len);
+	buffer[len] = '\0';
 
 	// Call raygui
-	GuiTextBox(bounds, buffer, maxSize, editMode);
+	GuiTextBox(bounds, buffer.data(), maxSize, editMode);
 
-	// Push the result string back to Lua
-	lua_pushstring(L, buffer);
-
-	// Clean up
-	delete[] buffer;
+	// Hand back the same Lua string when nothing was typed
+	if (len == inputLen && strcmp(buffer.data(), input) == 0) lua_pushvalue(L, 2);
+	else lua_pushstring(L, buffer.data());
 	return 1;
 }
 
+#include "rgui-textbox.cpp"
+#include "rgui-panel.cpp"
 
 static luaL_Reg rayguiFunctions[] = {
 	{"button", lua_rgui_button},
@@ -109,11 +114,17 @@ static luaL_Reg rayguiFunctions[] = {
 	{"checkbox", lua_rgui_checkbox},
 	{"slider", lua_rgui_slider},
 	{"textbox", lua_rgui_textbox},
+	{"newTextbox", lua_rgui_new_textbox},
+	{"unloadTextboxes", lua_rgui_textbox_unload_all},
+	{"panel", lua_rgui_panel},
+	{"unloadPanels", lua_rgui_panel_unload_all},
 	{NULL, NULL}
 };
 
 
 void init_raygui(lua_State *L){
+	registerGuiTextboxClass(L);
+	registerGuiPanelClass(L);
 	lua_newtable(L);
     // Iterate over the functions and add them to the table
 	for (int i = 0; rayguiFunctions[i].name; i++) {
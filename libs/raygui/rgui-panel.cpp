@@ -0,0 +1,355 @@
+// rgui-panel.cpp
+// retained panels: the widget list is declared once with rgui.panel{...},
+// kept in C with its layout, and panel:update() runs every widget without
+// reading any Lua tables. included by raygui.cpp
+//
+//	local p = rgui.panel{ x = 10, y = 10, width = 200, title = "Audio",
+//		{ type = "slider", id = "volume", min = 0, max = 1, value = 0.5 },
+//		{ type = "checkbox", id = "mute", text = "Mute" },
+//		{ type = "button", id = "apply", text = "Apply" },
+//	}
+//	local changed = p:update() -- nil, or { volume = 0.7, apply = true, ... }
+#pragma once
+#include <raylib.h>
+// raygui.h (with the implementation) is included once by raygui.cpp
+#include <lua.hpp>
+#include "../../../libs/lua_ffi.hpp" // pushPtr, getPtr, getArgByName
+#include "rgui-textbox.cpp"          // GuiTextState
+#include <algorithm>                 // std::remove
+#include <cstring>
+#include <string>
+#include <vector>
+
+enum GuiWidgetType {
+	GUI_LABEL,
+	GUI_BUTTON,
+	GUI_CHECKBOX,
+	GUI_SLIDER,
+	GUI_TEXTBOX,
+};
+
+struct GuiWidget {
+	GuiWidgetType type;
+	std::string id;
+	std::string text, textRight;
+	float value, minValue, maxValue;
+	bool checked;
+	GuiTextState textState;   // textbox contents
+	float height;             // 0 uses the panel row height
+	bool fixedRect;           // rect given in the definition, skipped by the layout
+	bool visible;
+	Rectangle rect;
+};
+
+struct GuiRetainedPanel {
+	Rectangle bounds;
+	std::string title;
+	float padding, spacing, rowHeight;
+	bool autoHeight;
+	bool layoutDirty;
+	std::vector<GuiWidget> widgets;
+};
+
+static std::vector<GuiRetainedPanel*> guiPanelPool;
+
+static float guiFieldNumber(lua_State *L, int idx, const char *name, float def){
+	lua_getfield(L, idx, name);
+	float value = lua_isnumber(L, -1) ? (float)lua_tonumber(L, -1) : def;
+	lua_pop(L, 1);
+	return value;
+}
+
+static std::string guiFieldString(lua_State *L, int idx, const char *name, const char *def){
+	lua_getfield(L, idx, name);
+	std::string value = lua_isstring(L, -1) ? lua_tostring(L, -1) : def;
+	lua_pop(L, 1);
+	return value;
+}
+
+// reads one widget definition table at idx, returns nullptr or what is wrong with it
+static const char *guiParseWidget(lua_State *L, int idx, GuiWidget &w){
+	std::string type = guiFieldString(L, idx, "type", "");
+	if (type == "label") w.type = GUI_LABEL;
+	else if (type == "button") w.type = GUI_BUTTON;
+	else if (type == "checkbox") w.type = GUI_CHECKBOX;
+	else if (type == "slider") w.type = GUI_SLIDER;
+	else if (type == "textbox") w.type = GUI_TEXTBOX;
+	else return "has no valid type";
+
+	w.id = guiFieldString(L, idx, "id", "");
+	w.text = guiFieldString(L, idx, "text", "");
+	w.textRight = guiFieldString(L, idx, "textRight", "");
+	w.value = guiFieldNumber(L, idx, "value", 0);
+	w.minValue = guiFieldNumber(L, idx, "min", 0);
+	w.maxValue = guiFieldNumber(L, idx, "max", 1);
+	w.height = guiFieldNumber(L, idx, "height", 0);
+	w.visible = true;
+
+	lua_getfield(L, idx, "checked");
+	w.checked = lua_toboolean(L, -1);
+	lua_pop(L, 1);
+
+	if (w.type == GUI_TEXTBOX) {
+		lua_getfield(L, idx, "multiline");
+		bool multiline = lua_toboolean(L, -1);
+		lua_pop(L, 1);
+		float maxSize = guiFieldNumber(L, idx, "maxSize", 256);
+		if (!(maxSize > 0)) return "maxSize must be positive";
+		guiTextInit(w.textState, (size_t)maxSize, w.text.data(), w.text.size(), multiline);
+		w.text.clear();
+	}
+
+	lua_getfield(L, idx, "rect");
+	w.fixedRect = lua_istable(L, -1);
+	if (w.fixedRect) {
+		int rect = lua_gettop(L);
+		w.rect = {
+			(float)getArgByName(L, "x", rect),
+			(float)getArgByName(L, "y", rect),
+			(float)getArgByName(L, "width", rect),
+			(float)getArgByName(L, "height", rect)
+		};
+	}
+	lua_pop(L, 1);
+	return nullptr;
+}
+
+// stacks the visible widgets top to bottom inside the panel bounds
+static void guiLayoutPanel(GuiRetainedPanel *p){
+	float top = p->bounds.y + p->padding;
+	if (!p->title.empty()) top += RAYGUI_WINDOWBOX_STATUSBAR_HEIGHT;
+
+	float y = top;
+	for (GuiWidget &w : p->widgets) {
+		if (!w.visible || w.fixedRect) continue;
+		float h = w.height > 0 ? w.height : p->rowHeight;
+		w.rect = { p->bounds.x + p->padding, y, p->bounds.width - 2*p->padding, h };
+		y += h + p->spacing;
+	}
+	if (p->autoHeight) p->bounds.height = (y > top ? y - p->spacing : y) + p->padding - p->bounds.y;
+	p->layoutDirty = false;
+}
+
+static GuiWidget *guiFindWidget(GuiRetainedPanel *p, const char *id){
+	for (GuiWidget &w : p->widgets)
+		if (w.id == id) return &w;
+	return nullptr;
+}
+
+static void freeGuiPanel(lua_State *L, GuiRetainedPanel *p){
+	for (GuiWidget &w : p->widgets)
+		if (w.type == GUI_TEXTBOX) luaL_unref(L, LUA_REGISTRYINDEX, w.textState.ref);
+	delete p;
+}
+
+static void guiPushWidgetValue(lua_State *L, GuiWidget &w){
+	switch (w.type) {
+		case GUI_CHECKBOX: lua_pushboolean(L, w.checked); break;
+		case GUI_SLIDER: lua_pushnumber(L, w.value); break;
+		case GUI_TEXTBOX: guiTextPush(L, w.textState); break;
+		case GUI_LABEL: lua_pushstring(L, w.text.c_str()); break;
+		default: lua_pushnil(L); break;
+	}
+}
+
+// rgui.panel{ x, y, width[, height, title, padding, spacing, rowHeight], widget, widget, ... }
+static int lua_rgui_panel(lua_State *L){
+	luaL_checktype(L, 1, LUA_TTABLE);
+
+	GuiRetainedPanel *p = new GuiRetainedPanel();
+	p->bounds = {
+		guiFieldNumber(L, 1, "x", 0),
+		guiFieldNumber(L, 1, "y", 0),
+		guiFieldNumber(L, 1, "width", 200),
+		guiFieldNumber(L, 1, "height", 0)
+	};
+	p->autoHeight = p->bounds.height <= 0;
+	p->title = guiFieldString(L, 1, "title", "");
+	p->padding = guiFieldNumber(L, 1, "padding", 8);
+	p->spacing = guiFieldNumber(L, 1, "spacing", 4);
+	p->rowHeight = guiFieldNumber(L, 1, "rowHeight", 24);
+
+	lua_Integer count = lua_rawlen(L, 1);
+	p->widgets.reserve(count);
+	for (lua_Integer i = 1; i <= count; i++) {
+		lua_rawgeti(L, 1, i);
+		GuiWidget w;
+		const char *error = lua_istable(L, -1) ? guiParseWidget(L, lua_gettop(L), w) : "has no valid type";
+		lua_pop(L, 1);
+		if (error) {
+			delete p;
+			return luaL_error(L, "rgui.panel: widget %d %s", (int)i, error);
+		}
+		p->widgets.push_back(std::move(w));
+	}
+	guiLayoutPanel(p);
+
+	guiPanelPool.push_back(p);
+	pushPtr(L, p); // Pushed as userdata, no __gc
+	return 1;
+}
+
+// panel:update() -> nil, or a table of { id = new value } for every widget that
+// changed this frame (buttons report true when clicked)
+static int lua_rgui_panel_update(lua_State *L){
+	GuiRetainedPanel *p = getPtr<GuiRetainedPanel>(L, 1);
+	if (p->layoutDirty) guiLayoutPanel(p);
+
+	if (!p->title.empty()) GuiPanel(p->bounds, p->title.c_str());
+
+	bool anyChanged = false;
+	for (GuiWidget &w : p->widgets) {
+		if (!w.visible) continue;
+		bool changed = false;
+		switch (w.type) {
+			case GUI_LABEL:
+				GuiLabel(w.rect, w.text.c_str());
+				break;
+			case GUI_BUTTON:
+				changed = GuiButton(w.rect, w.text.c_str());
+				break;
+			case GUI_CHECKBOX: {
+				bool before = w.checked;
+				GuiCheckBox(w.rect, w.text.c_str(), &w.checked);
+				changed = w.checked != before;
+				break;
+			}
+			case GUI_SLIDER: {
+				float before = w.value;
+				GuiSlider(w.rect, w.text.c_str(), w.textRight.c_str(), &w.value, w.minValue, w.maxValue);
+				changed = w.value != before;
+				break;
+			}
+			case GUI_TEXTBOX:
+				changed = guiTextDraw(L, w.textState, w.rect);
+				break;
+		}
+		if (!changed || w.id.empty()) continue;
+
+		if (!anyChanged) lua_newtable(L);
+		anyChanged = true;
+		if (w.type == GUI_BUTTON) lua_pushboolean(L, 1);
+		else guiPushWidgetValue(L, w);
+		lua_setfield(L, -2, w.id.c_str());
+	}
+	if (!anyChanged) lua_pushnil(L);
+	return 1;
+}
+
+// panel:get(id) -> current value
+static int lua_rgui_panel_get(lua_State *L){
+	GuiRetainedPanel *p = getPtr<GuiRetainedPanel>(L, 1);
+	GuiWidget *w = guiFindWidget(p, luaL_checkstring(L, 2));
+	if (!w) return 0;
+	guiPushWidgetValue(L, *w);
+	return 1;
+}
+
+// panel:set(id, value) - value is a number, boolean or string depending on the widget
+static int lua_rgui_panel_set(lua_State *L){
+	GuiRetainedPanel *p = getPtr<GuiRetainedPanel>(L, 1);
+	const char *id = luaL_checkstring(L, 2);
+	GuiWidget *w = guiFindWidget(p, id);
+	if (!w) return luaL_error(L, "panel has no widget '%s'", id);
+
+	switch (w->type) {
+		case GUI_CHECKBOX: w->checked = lua_toboolean(L, 3); break;
+		case GUI_SLIDER: w->value = luaL_checknumber(L, 3); break;
+		case GUI_TEXTBOX: {
+			size_t len;
+			const char *text = luaL_checklstring(L, 3, &len);
+			guiTextSet(L, w->textState, text, len);
+			break;
+		}
+		default: w->text = luaL_checkstring(L, 3); break;
+	}
+	return 0;
+}
+
+// panel:setVisible(id, visible) - hidden widgets take no space
+static int lua_rgui_panel_set_visible(lua_State *L){
+	GuiRetainedPanel *p = getPtr<GuiRetainedPanel>(L, 1);
+	const char *id = luaL_checkstring(L, 2);
+	GuiWidget *w = guiFindWidget(p, id);
+	if (!w) return luaL_error(L, "panel has no widget '%s'", id);
+
+	bool visible = lua_toboolean(L, 3);
+	if (w->visible != visible) p->layoutDirty = true;
+	w->visible = visible;
+	return 0;
+}
+
+// panel:setBounds(rect) - only x/y/width/height present in rect are changed
+static int lua_rgui_panel_set_bounds(lua_State *L){
+	GuiRetainedPanel *p = getPtr<GuiRetainedPanel>(L, 1);
+	luaL_checktype(L, 2, LUA_TTABLE);
+	Rectangle b = {
+		guiFieldNumber(L, 2, "x", p->bounds.x),
+		guiFieldNumber(L, 2, "y", p->bounds.y),
+		guiFieldNumber(L, 2, "width", p->bounds.width),
+		guiFieldNumber(L, 2, "height", p->autoHeight ? 0 : p->bounds.height)
+	};
+	float dx = b.x - p->bounds.x, dy = b.y - p->bounds.y;
+	for (GuiWidget &w : p->widgets) {
+		if (!w.fixedRect) continue;
+		w.rect.x += dx; // fixed rects move with the panel
+		w.rect.y += dy;
+	}
+	p->autoHeight = b.height <= 0;
+	p->bounds = b;
+	p->layoutDirty = true;
+	return 0;
+}
+
+static int lua_rgui_panel_get_bounds(lua_State *L){
+	GuiRetainedPanel *p = getPtr<GuiRetainedPanel>(L, 1);
+	if (p->layoutDirty) guiLayoutPanel(p);
+	lua_newtable(L);
+	lua_pushnumber(L, p->bounds.x);
+	lua_setfield(L, -2, "x");
+	lua_pushnumber(L, p->bounds.y);
+	lua_setfield(L, -2, "y");
+	lua_pushnumber(L, p->bounds.width);
+	lua_setfield(L, -2, "width");
+	lua_pushnumber(L, p->bounds.height);
+	lua_setfield(L, -2, "height");
+	return 1;
+}
+
+static int lua_rgui_panel_unload(lua_State *L){
+	GuiRetainedPanel *p = getPtr<GuiRetainedPanel>(L, 1);
+	if (!p) return 0;
+	guiPanelPool.erase(std::remove(guiPanelPool.begin(), guiPanelPool.end(), p), guiPanelPool.end());
+	freeGuiPanel(L, p);
+	return 0;
+}
+
+static int lua_rgui_panel_unload_all(lua_State *L){
+	for (GuiRetainedPanel *p : guiPanelPool) freeGuiPanel(L, p);
+	guiPanelPool.clear();
+	return 0;
+}
+
+// Register panel methods (no __gc)
+static void registerGuiPanelClass(lua_State *L){
+	const char *type = typeid(GuiRetainedPanel).name();
+	if (luaL_newmetatable(L, type)) {
+		lua_pushstring(L, "__index");
+		lua_newtable(L);
+
+		static luaL_Reg methods[] = {
+			{"update", lua_rgui_panel_update},
+			{"get", lua_rgui_panel_get},
+			{"set", lua_rgui_panel_set},
+			{"setVisible", lua_rgui_panel_set_visible},
+			{"setBounds", lua_rgui_panel_set_bounds},
+			{"getBounds", lua_rgui_panel_get_bounds},
+			{"unload", lua_rgui_panel_unload},
+			{NULL, NULL}
+		};
+		push_funcs(L, methods);
+
+		lua_settable(L, -3); // metatable.__index = table
+	}
+	lua_pop(L, 1);
+}
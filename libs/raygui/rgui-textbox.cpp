@@ -0,0 +1,252 @@
+// rgui-textbox.cpp
+// textbox state objects: the text lives in a native buffer that GuiTextBox
+// edits in place, so nothing is copied while the box is idle. The Lua string
+// is only rebuilt by getText() after the contents changed.
+// included by raygui.cpp, also used by the panel textboxes (rgui-panel.cpp)
+//
+//	local console = rgui.newTextbox(64 * 1024, "", true) -- size, text, multiline
+//	if console:draw({ x = 10, y = 10, width = 400, height = 300 }) then
+//		print(console:getText())
+//	end
+#pragma once
+#include <raylib.h>
+// raygui.h (with the implementation) is included once by raygui.cpp
+#include <lua.hpp>
+#include "../../../libs/lua_ffi.hpp" // pushPtr, getPtr, getArgByName
+#include <algorithm>                 // std::remove
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+struct GuiTextState {
+	std::vector<char> buffer; // capacity is fixed at creation, always null terminated
+	size_t length;
+	uint64_t hash;            // of the contents, only kept up to date while editing
+	bool editMode;
+	bool multiline;
+	bool dirty;               // changed since the last getText()
+	int ref;                  // registry ref of the cached Lua string, LUA_NOREF when stale
+};
+
+static std::vector<GuiTextState*> guiTextPool;
+
+static uint64_t guiTextHash(const char *text, size_t len){
+	uint64_t h = 1469598103934665603ull; // FNV-1a
+	for (size_t i = 0; i < len; i++) h = (h ^ (unsigned char)text[i]) * 1099511628211ull;
+	return h;
+}
+
+static void guiTextInit(GuiTextState &t, size_t size, const char *text, size_t len, bool multiline){
+	t.buffer.assign(std::max<size_t>(size, 2), '\0');
+	t.length = std::min(len, t.buffer.size() - 1);
+	memcpy(t.buffer.data(), text, t.length);
+	t.hash = 0;
+	t.editMode = false;
+	t.multiline = multiline;
+	t.dirty = false;
+	t.ref = LUA_NOREF;
+}
+
+// drops the cached Lua string after the buffer was modified
+static void guiTextInvalidate(lua_State *L, GuiTextState &t){
+	luaL_unref(L, LUA_REGISTRYINDEX, t.ref);
+	t.ref = LUA_NOREF;
+	t.dirty = true;
+}
+
+static void guiTextSet(lua_State *L, GuiTextState &t, const char *text, size_t len){
+	t.length = std::min(len, t.buffer.size() - 1);
+	memcpy(t.buffer.data(), text, t.length);
+	t.buffer[t.length] = '\0';
+	t.hash = guiTextHash(t.buffer.data(), t.length);
+	guiTextInvalidate(L, t);
+}
+
+// raygui has no multiline editing: ENTER would end the edit, so the newline
+// is inserted here at the shared cursor, returns false when the buffer is full
+static bool guiTextInsertNewline(GuiTextState &t){
+	if (t.length + 1 >= t.buffer.size()) return false;
+
+	size_t at = std::min((size_t)textBoxCursorIndex, t.length);
+	memmove(&t.buffer[at + 1], &t.buffer[at], t.length - at + 1);
+	t.buffer[at] = '\n';
+	t.length++;
+	textBoxCursorIndex = (int)at + 1;
+	return true;
+}
+
+// Draws the box and handles input, returns true when the text changed
+static bool guiTextDraw(lua_State *L, GuiTextState &t, Rectangle bounds){
+	bool editing = t.editMode;
+	if (editing && t.hash == 0) t.hash = guiTextHash(t.buffer.data(), t.length);
+
+	// the ENTER toggle is ignored even when the newline did not fit
+	bool enter = editing && t.multiline && IsKeyPressed(KEY_ENTER);
+	bool inserted = enter && guiTextInsertNewline(t);
+	int cursor = textBoxCursorIndex;
+	int alignVertical = 0, wrapMode = 0;
+	if (t.multiline) {
+		alignVertical = GuiGetStyle(DEFAULT, TEXT_ALIGNMENT_VERTICAL);
+		wrapMode = GuiGetStyle(DEFAULT, TEXT_WRAP_MODE);
+		GuiSetStyle(DEFAULT, TEXT_ALIGNMENT_VERTICAL, TEXT_ALIGN_TOP);
+		// word wrap only works for read only text, so it is used while not editing
+		if (!editing) GuiSetStyle(DEFAULT, TEXT_WRAP_MODE, TEXT_WRAP_WORD);
+	}
+
+	if (GuiTextBox(bounds, t.buffer.data(), (int)t.buffer.size(), t.editMode) && !enter)
+		t.editMode = !t.editMode;
+	// GuiTextBox also sees the ENTER and moves the cursor back to the start
+	if (enter) textBoxCursorIndex = cursor;
+
+	if (t.multiline) {
+		GuiSetStyle(DEFAULT, TEXT_ALIGNMENT_VERTICAL, alignVertical);
+		GuiSetStyle(DEFAULT, TEXT_WRAP_MODE, wrapMode);
+	}
+	if (!editing) {
+		t.hash = 0; // recomputed when editing starts
+		return false;
+	}
+
+	// raygui only inserts or deletes, a same length edit is caught by the hash
+	size_t length = strlen(t.buffer.data());
+	uint64_t hash = guiTextHash(t.buffer.data(), length);
+	bool changed = inserted || length != t.length || hash != t.hash;
+	t.length = length;
+	t.hash = hash;
+	if (changed) guiTextInvalidate(L, t);
+	return changed;
+}
+
+// pushes the contents, reusing the last Lua string while nothing changed
+static void guiTextPush(lua_State *L, GuiTextState &t){
+	if (t.ref == LUA_NOREF) {
+		lua_pushlstring(L, t.buffer.data(), t.length);
+		lua_pushvalue(L, -1);
+		t.ref = luaL_ref(L, LUA_REGISTRYINDEX);
+	} else {
+		lua_rawgeti(L, LUA_REGISTRYINDEX, t.ref);
+	}
+	t.dirty = false;
+}
+
+// rgui.newTextbox(maxSize[, text, multiline]) -> textbox
+static int lua_rgui_new_textbox(lua_State *L){
+	int maxSize = luaL_checkinteger(L, 1);
+	luaL_argcheck(L, maxSize > 0, 1, "maxSize must be positive");
+	size_t len = 0;
+	const char *text = luaL_optlstring(L, 2, "", &len);
+	bool multiline = lua_toboolean(L, 3);
+
+	GuiTextState *t = new GuiTextState();
+	guiTextInit(*t, maxSize, text, len, multiline);
+	guiTextPool.push_back(t);
+	pushPtr(L, t); // Pushed as userdata, no __gc
+	return 1;
+}
+
+// textbox:draw(rect) -> true if the text changed this frame
+static int lua_rgui_textbox_draw(lua_State *L){
+	GuiTextState *t = getPtr<GuiTextState>(L, 1);
+	Rectangle bounds = {
+		(float)getArgByName(L, "x", 2),
+		(float)getArgByName(L, "y", 2),
+		(float)getArgByName(L, "width", 2),
+		(float)getArgByName(L, "height", 2)
+	};
+	lua_pushboolean(L, guiTextDraw(L, *t, bounds));
+	return 1;
+}
+
+// textbox:getText() -> string, the same string object until the text changes
+static int lua_rgui_textbox_get_text(lua_State *L){
+	guiTextPush(L, *getPtr<GuiTextState>(L, 1));
+	return 1;
+}
+
+static int lua_rgui_textbox_set_text(lua_State *L){
+	GuiTextState *t = getPtr<GuiTextState>(L, 1);
+	size_t len;
+	const char *text = luaL_checklstring(L, 2, &len);
+	guiTextSet(L, *t, text, len);
+	return 0;
+}
+
+// textbox:append(text) - cheap for logs/consoles, no copy of the existing text
+static int lua_rgui_textbox_append(lua_State *L){
+	GuiTextState *t = getPtr<GuiTextState>(L, 1);
+	size_t len;
+	const char *text = luaL_checklstring(L, 2, &len);
+	len = std::min(len, t->buffer.size() - 1 - t->length);
+	memcpy(&t->buffer[t->length], text, len);
+	t->length += len;
+	t->buffer[t->length] = '\0';
+	t->hash = 0;
+	guiTextInvalidate(L, *t);
+	lua_pushboolean(L, len == lua_rawlen(L, 2)); // false when truncated
+	return 1;
+}
+
+// textbox:isDirty() -> true if the text changed since the last getText()
+static int lua_rgui_textbox_is_dirty(lua_State *L){
+	lua_pushboolean(L, getPtr<GuiTextState>(L, 1)->dirty);
+	return 1;
+}
+
+static int lua_rgui_textbox_is_editing(lua_State *L){
+	lua_pushboolean(L, getPtr<GuiTextState>(L, 1)->editMode);
+	return 1;
+}
+
+static int lua_rgui_textbox_set_editing(lua_State *L){
+	getPtr<GuiTextState>(L, 1)->editMode = lua_toboolean(L, 2);
+	return 0;
+}
+
+static int lua_rgui_textbox_length(lua_State *L){
+	lua_pushinteger(L, getPtr<GuiTextState>(L, 1)->length);
+	return 1;
+}
+
+static int lua_rgui_textbox_unload(lua_State *L){
+	GuiTextState *t = getPtr<GuiTextState>(L, 1);
+	if (!t) return 0;
+	luaL_unref(L, LUA_REGISTRYINDEX, t->ref);
+	guiTextPool.erase(std::remove(guiTextPool.begin(), guiTextPool.end(), t), guiTextPool.end());
+	delete t;
+	return 0;
+}
+
+static int lua_rgui_textbox_unload_all(lua_State *L){
+	for (GuiTextState *t : guiTextPool) {
+		luaL_unref(L, LUA_REGISTRYINDEX, t->ref);
+		delete t;
+	}
+	guiTextPool.clear();
+	return 0;
+}
+
+// Register textbox methods (no __gc)
+static void registerGuiTextboxClass(lua_State *L){
+	const char *type = typeid(GuiTextState).name();
+	if (luaL_newmetatable(L, type)) {
+		lua_pushstring(L, "__index");
+		lua_newtable(L);
+
+		static luaL_Reg methods[] = {
+			{"draw", lua_rgui_textbox_draw},
+			{"getText", lua_rgui_textbox_get_text},
+			{"setText", lua_rgui_textbox_set_text},
+			{"append", lua_rgui_textbox_append},
+			{"isDirty", lua_rgui_textbox_is_dirty},
+			{"isEditing", lua_rgui_textbox_is_editing},
+			{"setEditing", lua_rgui_textbox_set_editing},
+			{"length", lua_rgui_textbox_length},
+			{"unload", lua_rgui_textbox_unload},
+			{NULL, NULL}
+		};
+		push_funcs(L, methods);
+
+		lua_settable(L, -3); // metatable.__index = table
+	}
+	lua_pop(L, 1);
+}
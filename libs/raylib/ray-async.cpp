@@ -0,0 +1,316 @@
+// ray-async.cpp - Async: coroutine tasks resumed by the frame loop
+// Tasks wait on frames, time, signals or anything with a done() method
+// (jobs from jobs.so, for one). Everything that became ready is resumed in one
+// batch from EndDrawing (or Async.tick()), before the frame is presented, so
+// a task can draw. Sleeping tasks sit in timer wheels and cost nothing until
+// their slot comes up, 100k of them do not slow the frame down.
+//
+//	Async.run(function()
+//	    wait.seconds(2)
+//	    local tiles = wait.done(job) -- a jobs.so job, resumes once job:done() is true
+//	    local who = wait.signal("player_died")
+//	    for i = 1, 30 do flash(i); wait.frames(1) end
+//	end)
+#pragma once
+#include <lua.hpp>
+#include <raylib.h>
+#include "../../../libs/lua_ffi.hpp" // newModule
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#define ASYNC_WHEEL_SLOTS 1024 // power of two
+#define ASYNC_WHEEL_MASK (ASYNC_WHEEL_SLOTS - 1)
+
+struct AsyncTask {
+    lua_State* co;
+    int ref;          // registry ref keeping the coroutine alive
+    uint32_t id;
+    uint32_t waitId;  // bumped per wait, entries from an older wait are ignored
+    int pollRef;      // wait.done target, LUA_NOREF otherwise
+    int resumeArgs;   // values already pushed on co for the next resume
+};
+
+// A pending wake-up, refers to the task by id so cancelled tasks are simply not found
+struct AsyncTimer {
+    uint32_t id;
+    uint32_t waitId;
+    uint64_t due;
+};
+
+// Hashed timer wheel: a timer lives in the slot of its due tick and is only
+// looked at when that slot comes around (once per revolution for long waits)
+struct TimerWheel {
+    std::vector<AsyncTimer> slots[ASYNC_WHEEL_SLOTS];
+    uint64_t now = 0; // last tick processed
+
+    void add(AsyncTimer t) {
+        slots[std::max(t.due, now + 1) & ASYNC_WHEEL_MASK].push_back(t);
+    }
+
+    // moves every timer due by `to` into out
+    void advance(uint64_t to, std::vector<AsyncTimer>& out) {
+        if (to <= now) return;
+        uint64_t steps = std::min<uint64_t>(to - now, ASYNC_WHEEL_SLOTS); // a long hitch visits each slot once
+        for (uint64_t i = 1; i <= steps; i++) {
+            std::vector<AsyncTimer>& slot = slots[(now + i) & ASYNC_WHEEL_MASK];
+            for (size_t j = 0; j < slot.size();) {
+                if (slot[j].due <= to) {
+                    out.push_back(slot[j]);
+                    slot[j] = slot.back();
+                    slot.pop_back();
+                } else {
+                    j++;
+                }
+            }
+        }
+        now = to;
+    }
+};
+
+static std::unordered_map<uint32_t, AsyncTask*> asyncTasks;
+static std::unordered_map<lua_State*, AsyncTask*> asyncByThread;
+static std::unordered_map<std::string, std::vector<AsyncTimer>> asyncSignals;
+static std::vector<AsyncTimer> asyncPolls;  // wait.done, checked every tick
+static std::vector<AsyncTimer> asyncReady;  // resumed on the next tick
+static TimerWheel asyncFrameWheel;          // ticks are frames
+static TimerWheel asyncTimeWheel;           // ticks are milliseconds
+static uint64_t asyncFrame = 0;
+static uint32_t asyncNextId = 1;
+
+// Milliseconds since the first call. Not GetTime(): that stays at 0 without
+// a window, and Async.tick() also drives scripts that never open one.
+static uint64_t asyncNowMs() {
+    static const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    return (uint64_t)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void asyncFree(lua_State* L, AsyncTask* t) {
+    asyncTasks.erase(t->id);
+    asyncByThread.erase(t->co);
+    luaL_unref(L, LUA_REGISTRYINDEX, t->pollRef);
+    luaL_unref(L, LUA_REGISTRYINDEX, t->ref);
+    delete t;
+}
+
+// The task running on L, errors when called outside of one
+static AsyncTask* asyncCurrent(lua_State* L) {
+    auto it = asyncByThread.find(L);
+    if (it == asyncByThread.end())
+        luaL_error(L, "wait functions can only be used inside a task started with Async.run");
+    AsyncTask* t = it->second;
+    t->waitId++;
+    return t;
+}
+
+// Resumes t with its pending arguments. Returns false and leaves the
+// error with a traceback on L when the task failed
+static bool asyncResume(lua_State* L, AsyncTask* t) {
+    int nargs = t->resumeArgs, nres = 0;
+    t->resumeArgs = 0;
+    uint32_t before = ++t->waitId; // whatever it waited on is over
+    int status = lua_resume(t->co, L, nargs, &nres);
+    if (status == LUA_YIELD) {
+        lua_pop(t->co, nres);
+        // wait functions bump waitId and queue themselves, a bare coroutine.yield() waits a frame
+        if (t->waitId == before) asyncFrameWheel.add({ t->id, ++t->waitId, asyncFrame + 1 });
+        return true;
+    }
+    if (status != LUA_OK) {
+        luaL_traceback(L, t->co, lua_tostring(t->co, -1), 0);
+        asyncFree(L, t);
+        return false;
+    }
+    asyncFree(L, t); // finished
+    return true;
+}
+
+// Resumes everything that is due. Returns the first task error (with a
+// traceback) or an empty string; the other tasks still ran
+static std::string asyncTick(lua_State* L) {
+    asyncFrame++;
+    std::vector<AsyncTimer> due;
+    due.swap(asyncReady);
+    asyncFrameWheel.advance(asyncFrame, due);
+    asyncTimeWheel.advance(asyncNowMs(), due);
+
+    // wait.done targets, a function or anything with a done() method
+    for (size_t i = 0; i < asyncPolls.size();) {
+        auto it = asyncTasks.find(asyncPolls[i].id);
+        if (it == asyncTasks.end() || it->second->waitId != asyncPolls[i].waitId) {
+            asyncPolls[i] = asyncPolls.back();
+            asyncPolls.pop_back();
+            continue;
+        }
+        AsyncTask* t = it->second;
+        lua_rawgeti(L, LUA_REGISTRYINDEX, t->pollRef);
+        bool ready = true;
+        int type = lua_type(L, -1);
+        if (type == LUA_TFUNCTION || type == LUA_TTABLE || type == LUA_TUSERDATA) {
+            int nargs = 0;
+            if (type != LUA_TFUNCTION) {
+                lua_getfield(L, -1, "done");
+                lua_insert(L, -2); // obj:done()
+                nargs = 1;
+            }
+            ready = lua_pcall(L, nargs, 1, 0) != LUA_OK || lua_toboolean(L, -1); // an error ends the wait too
+        }
+        lua_pop(L, 1);
+        if (ready) {
+            lua_rawgeti(L, LUA_REGISTRYINDEX, t->pollRef);
+            lua_xmove(L, t->co, 1); // wait.done returns its target
+            t->resumeArgs = 1;
+            luaL_unref(L, LUA_REGISTRYINDEX, t->pollRef);
+            t->pollRef = LUA_NOREF;
+            due.push_back(asyncPolls[i]);
+            asyncPolls[i] = asyncPolls.back();
+            asyncPolls.pop_back();
+        } else {
+            i++;
+        }
+    }
+
+    std::string error;
+    for (const AsyncTimer& timer : due) {
+        auto it = asyncTasks.find(timer.id);
+        if (it == asyncTasks.end() || it->second->waitId != timer.waitId) continue; // cancelled or woken otherwise
+        if (!asyncResume(L, it->second)) {
+            if (error.empty()) error = lua_tostring(L, -1);
+            lua_pop(L, 1);
+        }
+    }
+    return error;
+}
+
+// wait.frames([n]) - resumes n frames from now (1 by default)
+static int l_WaitFrames(lua_State* L) {
+    AsyncTask* t = asyncCurrent(L);
+    lua_Integer n = std::max<lua_Integer>(luaL_optinteger(L, 1, 1), 1);
+    asyncFrameWheel.add({ t->id, t->waitId, asyncFrame + (uint64_t)n });
+    return lua_yield(L, 0);
+}
+
+// wait.seconds(t) - resumes on the first frame after t seconds
+static int l_WaitSeconds(lua_State* L) {
+    AsyncTask* t = asyncCurrent(L);
+    double seconds = std::max(luaL_checknumber(L, 1), 0.0);
+    asyncTimeWheel.add({ t->id, t->waitId, asyncNowMs() + (uint64_t)std::ceil(seconds * 1000.0) });
+    return lua_yield(L, 0);
+}
+
+// wait.signal(name) -> the values passed to Async.signal(name, ...)
+static int l_WaitSignal(lua_State* L) {
+    AsyncTask* t = asyncCurrent(L);
+    asyncSignals[luaL_checkstring(L, 1)].push_back({ t->id, t->waitId, 0 });
+    return lua_yield(L, 0);
+}
+
+// wait.done(x) -> x, once x() or x:done() returns true; checked every frame
+static int l_WaitDone(lua_State* L) {
+    luaL_checkany(L, 1);
+    AsyncTask* t = asyncCurrent(L);
+    lua_pushvalue(L, 1);
+    t->pollRef = luaL_ref(L, LUA_REGISTRYINDEX);
+    asyncPolls.push_back({ t->id, t->waitId, 0 });
+    return lua_yield(L, 0);
+}
+
+// Async.run(fn, ...) -> task id, runs fn until its first wait
+static int l_AsyncRun(lua_State* L) {
+    luaL_checktype(L, 1, LUA_TFUNCTION);
+    int nargs = lua_gettop(L) - 1;
+
+    AsyncTask* t = new AsyncTask();
+    t->co = lua_newthread(L);
+    t->ref = luaL_ref(L, LUA_REGISTRYINDEX);
+    t->id = asyncNextId++;
+    t->pollRef = LUA_NOREF;
+    t->resumeArgs = nargs;
+    asyncTasks[t->id] = t;
+    asyncByThread[t->co] = t;
+
+    lua_xmove(L, t->co, nargs + 1); // fn and its arguments
+    uint32_t id = t->id;
+    if (!asyncResume(L, t)) return lua_error(L);
+    lua_pushinteger(L, id);
+    return 1;
+}
+
+// Async.cancel(id) - the task is dropped wherever it waits
+static int l_AsyncCancel(lua_State* L) {
+    auto it = asyncTasks.find((uint32_t)luaL_checkinteger(L, 1));
+    if (it == asyncTasks.end() || it->second->co == L) return 0; // a task can not cancel itself mid run
+    asyncFree(L, it->second);
+    return 0;
+}
+
+// Async.signal(name, ...) - wakes every task in wait.signal(name) on the next tick
+static int l_AsyncSignal(lua_State* L) {
+    auto it = asyncSignals.find(luaL_checkstring(L, 1));
+    if (it == asyncSignals.end()) return 0;
+    std::vector<AsyncTimer> waiters;
+    waiters.swap(it->second);
+    asyncSignals.erase(it);
+
+    int nargs = lua_gettop(L) - 1;
+    int woken = 0;
+    for (const AsyncTimer& w : waiters) {
+        auto task = asyncTasks.find(w.id);
+        if (task == asyncTasks.end() || task->second->waitId != w.waitId) continue;
+        AsyncTask* t = task->second;
+        lua_checkstack(t->co, nargs);
+        for (int i = 2; i <= nargs + 1; i++) lua_pushvalue(L, i);
+        lua_xmove(L, t->co, nargs);
+        t->resumeArgs = nargs;
+        asyncReady.push_back(w);
+        woken++;
+    }
+    lua_pushinteger(L, woken);
+    return 1;
+}
+
+// Async.status(id) -> "waiting" or "dead"
+static int l_AsyncStatus(lua_State* L) {
+    bool alive = asyncTasks.count((uint32_t)luaL_checkinteger(L, 1)) > 0;
+    lua_pushstring(L, alive ? "waiting" : "dead");
+    return 1;
+}
+
+static int l_AsyncCount(lua_State* L) {
+    lua_pushinteger(L, asyncTasks.size());
+    return 1;
+}
+
+// Async.tick() - for loops that do not call EndDrawing
+static int l_AsyncTick(lua_State* L) {
+    std::string error = asyncTick(L);
+    if (!error.empty()) return luaL_error(L, "%s", error.c_str());
+    return 0;
+}
+
+static luaL_Reg asyncFuncs[] = {
+    { "run", l_AsyncRun },
+    { "cancel", l_AsyncCancel },
+    { "signal", l_AsyncSignal },
+    { "status", l_AsyncStatus },
+    { "count", l_AsyncCount },
+    { "tick", l_AsyncTick },
+    { NULL, NULL }
+};
+
+static luaL_Reg waitFuncs[] = {
+    { "frames", l_WaitFrames },
+    { "seconds", l_WaitSeconds },
+    { "signal", l_WaitSignal },
+    { "done", l_WaitDone },
+    { NULL, NULL }
+};
+
+extern "C" void init_raylib_async(lua_State* L) {
+    newModule("Async", asyncFuncs, L);
+    newModule("wait", waitFuncs, L);
+}
@@ -1,6 +1,10 @@
 #include <lua.hpp>
 #include <raylib.h>
 #include "../../../../libs/lua_ffi.hpp" // getArgByName
+#include <raymath.h> // MatrixInvert
+#include "../../buffer.hpp" // Buffer, testBuffer
+#include <cstring>
+#include <algorithm>
 
 #define LUA lua_State* ctx
 
@@ -141,13 +145,373 @@ int l_UpdateCamera3D(LUA) {
     return 0;
 }
 
+// ─────────────────────────────────────────────────────────────────────────────
+// Camera objects
+// Cameras created with Camera2D.new/Camera3D.new are userdata holding the
+// raylib struct itself, fields are read and written directly (cam.zoom = 2).
+// Field names are resolved with a switch (a perfect hash over the few names)
+// instead of a strcmp chain.
+// ─────────────────────────────────────────────────────────────────────────────
+
+#define CAMERA2D_META "rocket.Camera2D"
+#define CAMERA3D_META "rocket.Camera3D"
+
+enum CameraField {
+    CAM_NONE,
+    CAM_OFFSET, CAM_TARGET, CAM_ROTATION, CAM_ZOOM,        // 2D
+    CAM_POSITION, CAM_UP, CAM_FOVY, CAM_PROJECTION         // 3D (+ target)
+};
+
+static CameraField camera2DField(const char* key, size_t len) {
+    CameraField f = CAM_NONE;
+    const char* name = nullptr;
+    switch (key[0]) {
+        case 'o': f = CAM_OFFSET;   name = "offset";   break;
+        case 't': f = CAM_TARGET;   name = "target";   break;
+        case 'r': f = CAM_ROTATION; name = "rotation"; break;
+        case 'z': f = CAM_ZOOM;     name = "zoom";     break;
+        default: return CAM_NONE;
+    }
+    return (strlen(name) == len && memcmp(name, key, len) == 0) ? f : CAM_NONE;
+}
+
+static CameraField camera3DField(const char* key, size_t len) {
+    CameraField f = CAM_NONE;
+    const char* name = nullptr;
+    switch (len) {  // all 3D field names have different lengths
+        case 2:  f = CAM_UP;         name = "up";         break;
+        case 4:  f = CAM_FOVY;       name = "fovy";       break;
+        case 6:  f = CAM_TARGET;     name = "target";     break;
+        case 8:  f = CAM_POSITION;   name = "position";   break;
+        case 10: f = CAM_PROJECTION; name = "projection"; break;
+        default: return CAM_NONE;
+    }
+    return memcmp(name, key, len) == 0 ? f : CAM_NONE;
+}
+
+static Camera2D* checkCamera2D(LUA, int idx) {
+    return (Camera2D*)luaL_checkudata(ctx, idx, CAMERA2D_META);
+}
+
+static Camera3D* checkCamera3D(LUA, int idx) {
+    return (Camera3D*)luaL_checkudata(ctx, idx, CAMERA3D_META);
+}
+
+// Camera object at idx, or the global camera when the argument is absent
+static Camera2D* optCamera2D(LUA, int idx) {
+    Camera2D* cam = (Camera2D*)luaL_testudata(ctx, idx, CAMERA2D_META);
+    return cam ? cam : &globalCam2d;
+}
+
+static Camera3D* optCamera3D(LUA, int idx) {
+    Camera3D* cam = (Camera3D*)luaL_testudata(ctx, idx, CAMERA3D_META);
+    return cam ? cam : &globalCam3d;
+}
+
+// Camera2D.new([offset, target, rotation, zoom])
+int l_NewCamera2D(LUA) {
+    Camera2D cam = { {0, 0}, {0, 0}, 0.0f, 1.0f };
+    if (!lua_isnoneornil(ctx, 1)) { GET_VEC2(offset, 1); cam.offset = offset; }
+    if (!lua_isnoneornil(ctx, 2)) { GET_VEC2(target, 2); cam.target = target; }
+    cam.rotation = luaL_optnumber(ctx, 3, 0.0);
+    cam.zoom     = luaL_optnumber(ctx, 4, 1.0);
+
+    Camera2D* ud = (Camera2D*)lua_newuserdatauv(ctx, sizeof(Camera2D), 0);
+    *ud = cam;
+    luaL_setmetatable(ctx, CAMERA2D_META);
+    return 1;
+}
+
+// Camera3D.new([position, target, up, fovy, projection])
+int l_NewCamera3D(LUA) {
+    Camera3D cam = { {0, 10, 10}, {0, 0, 0}, {0, 1, 0}, 45.0f, CAMERA_PERSPECTIVE };
+    if (!lua_isnoneornil(ctx, 1)) { GET_VEC3(position, 1); cam.position = position; }
+    if (!lua_isnoneornil(ctx, 2)) { GET_VEC3(target, 2); cam.target = target; }
+    if (!lua_isnoneornil(ctx, 3)) { GET_VEC3(up, 3); cam.up = up; }
+    cam.fovy       = luaL_optnumber(ctx, 4, 45.0);
+    cam.projection = luaL_optinteger(ctx, 5, CAMERA_PERSPECTIVE);
+
+    Camera3D* ud = (Camera3D*)lua_newuserdatauv(ctx, sizeof(Camera3D), 0);
+    *ud = cam;
+    luaL_setmetatable(ctx, CAMERA3D_META);
+    return 1;
+}
+
+// __index: fields first, then the methods table in upvalue 1
+int l_Camera2DIndex(LUA) {
+    Camera2D* cam = checkCamera2D(ctx, 1);
+    size_t len;
+    const char* key = lua_tolstring(ctx, 2, &len);
+    switch (key ? camera2DField(key, len) : CAM_NONE) {
+        case CAM_OFFSET:   { RETURN_VEC2(cam->offset); return 1; }
+        case CAM_TARGET:   { RETURN_VEC2(cam->target); return 1; }
+        case CAM_ROTATION: lua_pushnumber(ctx, cam->rotation); return 1;
+        case CAM_ZOOM:     lua_pushnumber(ctx, cam->zoom); return 1;
+        default: break;
+    }
+    lua_pushvalue(ctx, 2);
+    lua_rawget(ctx, lua_upvalueindex(1));
+    return 1;
+}
+
+int l_Camera2DNewIndex(LUA) {
+    Camera2D* cam = checkCamera2D(ctx, 1);
+    size_t len;
+    const char* key = luaL_checklstring(ctx, 2, &len);
+    switch (camera2DField(key, len)) {
+        case CAM_OFFSET:   { GET_VEC2(val, 3); cam->offset = val; break; }
+        case CAM_TARGET:   { GET_VEC2(val, 3); cam->target = val; break; }
+        case CAM_ROTATION: cam->rotation = luaL_checknumber(ctx, 3); break;
+        case CAM_ZOOM:     cam->zoom = luaL_checknumber(ctx, 3); break;
+        default: return luaL_error(ctx, "Camera2D has no field '%s'", key);
+    }
+    return 0;
+}
+
+int l_Camera3DIndex(LUA) {
+    Camera3D* cam = checkCamera3D(ctx, 1);
+    size_t len;
+    const char* key = lua_tolstring(ctx, 2, &len);
+    switch (key ? camera3DField(key, len) : CAM_NONE) {
+        case CAM_POSITION:   { RETURN_VEC3(cam->position); return 1; }
+        case CAM_TARGET:     { RETURN_VEC3(cam->target); return 1; }
+        case CAM_UP:         { RETURN_VEC3(cam->up); return 1; }
+        case CAM_FOVY:       lua_pushnumber(ctx, cam->fovy); return 1;
+        case CAM_PROJECTION: lua_pushinteger(ctx, cam->projection); return 1;
+        default: break;
+    }
+    lua_pushvalue(ctx, 2);
+    lua_rawget(ctx, lua_upvalueindex(1));
+    return 1;
+}
+
+int l_Camera3DNewIndex(LUA) {
+    Camera3D* cam = checkCamera3D(ctx, 1);
+    size_t len;
+    const char* key = luaL_checklstring(ctx, 2, &len);
+    switch (camera3DField(key, len)) {
+        case CAM_POSITION:   { GET_VEC3(val, 3); cam->position = val; break; }
+        case CAM_TARGET:     { GET_VEC3(val, 3); cam->target = val; break; }
+        case CAM_UP:         { GET_VEC3(val, 3); cam->up = val; break; }
+        case CAM_FOVY:       cam->fovy = luaL_checknumber(ctx, 3); break;
+        case CAM_PROJECTION: cam->projection = luaL_checkinteger(ctx, 3); break;
+        default: return luaL_error(ctx, "Camera3D has no field '%s'", key);
+    }
+    return 0;
+}
+
+int l_Camera2DBegin(LUA) {
+    BeginMode2D(*checkCamera2D(ctx, 1));
+    return 0;
+}
+
+int l_Camera2DWorldToScreen(LUA) {
+    Camera2D* cam = checkCamera2D(ctx, 1);
+    GET_VEC2(pos, 2);
+    Vector2 result = GetWorldToScreen2D(pos, *cam);
+    RETURN_VEC2(result);
+    return 1;
+}
+
+int l_Camera2DScreenToWorld(LUA) {
+    Camera2D* cam = checkCamera2D(ctx, 1);
+    GET_VEC2(pos, 2);
+    Vector2 result = GetScreenToWorld2D(pos, *cam);
+    RETURN_VEC2(result);
+    return 1;
+}
+
+// cam:copy() / cam:makeGlobal() copy a camera object into a new object / the global camera
+int l_Camera2DCopy(LUA) {
+    Camera2D* cam = checkCamera2D(ctx, 1);
+    Camera2D* ud = (Camera2D*)lua_newuserdatauv(ctx, sizeof(Camera2D), 0);
+    *ud = *cam;
+    luaL_setmetatable(ctx, CAMERA2D_META);
+    return 1;
+}
+
+int l_Camera2DMakeGlobal(LUA) {
+    globalCam2d = *checkCamera2D(ctx, 1);
+    return 0;
+}
+
+int l_Camera3DBegin(LUA) {
+    BeginMode3D(*checkCamera3D(ctx, 1));
+    return 0;
+}
+
+int l_Camera3DUpdate(LUA) {
+    Camera3D* cam = checkCamera3D(ctx, 1);
+    UpdateCamera(cam, luaL_checkinteger(ctx, 2));
+    return 0;
+}
+
+int l_Camera3DCopy(LUA) {
+    Camera3D* cam = checkCamera3D(ctx, 1);
+    Camera3D* ud = (Camera3D*)lua_newuserdatauv(ctx, sizeof(Camera3D), 0);
+    *ud = *cam;
+    luaL_setmetatable(ctx, CAMERA3D_META);
+    return 1;
+}
+
+int l_Camera3DMakeGlobal(LUA) {
+    globalCam3d = *checkCamera3D(ctx, 1);
+    return 0;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Batched transforms
+// Points are a flat array {x1, y1, x2, y2, ...} or an f32/f64 Buffer of the
+// same layout, converted in place; the camera matrix is computed once per call
+// instead of once per point.
+// ─────────────────────────────────────────────────────────────────────────────
+
+#define BATCH_CHUNK 256
+
+// Transforms `count` points stored in xs/ys with the 2D affine part of m
+static void transformPoints2D(const Matrix& m, float* __restrict xs, float* __restrict ys, int count) {
+    for (int i = 0; i < count; i++) {
+        float x = xs[i], y = ys[i];
+        xs[i] = m.m0 * x + m.m4 * y + m.m12;
+        ys[i] = m.m1 * x + m.m5 * y + m.m13;
+    }
+}
+
+// Same for interleaved x, y pairs, the layout of a points Buffer
+template <typename T>
+static void transformInterleaved2D(const Matrix& m, T* __restrict p, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        T x = p[i * 2], y = p[i * 2 + 1];
+        p[i * 2] = m.m0 * x + m.m4 * y + m.m12;
+        p[i * 2 + 1] = m.m1 * x + m.m5 * y + m.m13;
+    }
+}
+
+static void transformTable2D(LUA, int idx, const Matrix& m) {
+    if (Buffer* b = testBuffer(ctx, idx)) {
+        luaL_argcheck(ctx, b->type == BUFFER_F32 || b->type == BUFFER_F64, idx, "f32 or f64 buffer expected");
+        if (b->type == BUFFER_F32) transformInterleaved2D(m, b->as<float>(), b->count / 2);
+        else transformInterleaved2D(m, b->as<double>(), b->count / 2);
+        return;
+    }
+    luaL_checktype(ctx, idx, LUA_TTABLE);
+    lua_Integer len = lua_rawlen(ctx, idx) / 2;
+    float xs[BATCH_CHUNK], ys[BATCH_CHUNK];
+
+    for (lua_Integer base = 0; base < len; base += BATCH_CHUNK) {
+        int count = (int)std::min<lua_Integer>(BATCH_CHUNK, len - base);
+        for (int i = 0; i < count; i++) {
+            lua_rawgeti(ctx, idx, (base + i) * 2 + 1);
+            lua_rawgeti(ctx, idx, (base + i) * 2 + 2);
+            xs[i] = lua_tonumber(ctx, -2);
+            ys[i] = lua_tonumber(ctx, -1);
+            lua_pop(ctx, 2);
+        }
+        transformPoints2D(m, xs, ys, count);
+        for (int i = 0; i < count; i++) {
+            lua_pushnumber(ctx, xs[i]);
+            lua_rawseti(ctx, idx, (base + i) * 2 + 1);
+            lua_pushnumber(ctx, ys[i]);
+            lua_rawseti(ctx, idx, (base + i) * 2 + 2);
+        }
+    }
+}
+
+// Camera2D.worldToScreenBatch(points) or cam:worldToScreenBatch(points) -> points
+int l_WorldToScreen2DBatch(LUA) {
+    Camera2D* cam = optCamera2D(ctx, 1);
+    int idx = cam == &globalCam2d ? 1 : 2;
+    transformTable2D(ctx, idx, GetCameraMatrix2D(*cam));
+    lua_settop(ctx, idx);
+    return 1;
+}
+
+int l_ScreenToWorld2DBatch(LUA) {
+    Camera2D* cam = optCamera2D(ctx, 1);
+    int idx = cam == &globalCam2d ? 1 : 2;
+    transformTable2D(ctx, idx, MatrixInvert(GetCameraMatrix2D(*cam)));
+    lua_settop(ctx, idx);
+    return 1;
+}
+
+// World space AABB covered by a screen area, for culling
+static Rectangle cameraVisibleRect(const Camera2D& cam, float width, float height) {
+    Matrix inv = MatrixInvert(GetCameraMatrix2D(cam));
+    float xs[4] = { 0, width, 0, width };
+    float ys[4] = { 0, 0, height, height };
+    transformPoints2D(inv, xs, ys, 4);
+
+    float minX = *std::min_element(xs, xs + 4), maxX = *std::max_element(xs, xs + 4);
+    float minY = *std::min_element(ys, ys + 4), maxY = *std::max_element(ys, ys + 4);
+    return { minX, minY, maxX - minX, maxY - minY };
+}
+
+// Camera2D.visibleRect([width, height]) or cam:visibleRect([width, height])
+// width/height default to the screen size
+int l_VisibleRect2D(LUA) {
+    Camera2D* cam = optCamera2D(ctx, 1);
+    int idx = cam == &globalCam2d ? 1 : 2;
+    float width = luaL_optnumber(ctx, idx, GetScreenWidth());
+    float height = luaL_optnumber(ctx, idx + 1, GetScreenHeight());
+
+    Rectangle rect = cameraVisibleRect(*cam, width, height);
+    lua_newtable(ctx);
+    lua_pushnumber(ctx, rect.x);      lua_setfield(ctx, -2, "x");
+    lua_pushnumber(ctx, rect.y);      lua_setfield(ctx, -2, "y");
+    lua_pushnumber(ctx, rect.width);  lua_setfield(ctx, -2, "width");
+    lua_pushnumber(ctx, rect.height); lua_setfield(ctx, -2, "height");
+    return 1;
+}
+
+static void registerCameraClass(LUA, const char* meta, luaL_Reg* methods,
+                                lua_CFunction index, lua_CFunction newindex) {
+    if (luaL_newmetatable(ctx, meta)) {
+        lua_newtable(ctx);
+        push_funcs(ctx, methods);
+        lua_pushcclosure(ctx, index, 1);
+        lua_setfield(ctx, -2, "__index");
+        lua_pushcfunction(ctx, newindex);
+        lua_setfield(ctx, -2, "__newindex");
+    }
+    lua_pop(ctx, 1);
+}
+
+void registerCameraClasses(LUA) {
+    static luaL_Reg methods2D[] = {
+        { "begin", l_Camera2DBegin },
+        { "stop", l_StopCamera2D },
+        { "worldToScreen", l_Camera2DWorldToScreen },
+        { "screenToWorld", l_Camera2DScreenToWorld },
+        { "worldToScreenBatch", l_WorldToScreen2DBatch },
+        { "screenToWorldBatch", l_ScreenToWorld2DBatch },
+        { "visibleRect", l_VisibleRect2D },
+        { "copy", l_Camera2DCopy },
+        { "makeGlobal", l_Camera2DMakeGlobal },
+        { NULL, NULL }
+    };
+    static luaL_Reg methods3D[] = {
+        { "begin", l_Camera3DBegin },
+        { "stop", l_StopCamera3D },
+        { "update", l_Camera3DUpdate },
+        { "copy", l_Camera3DCopy },
+        { "makeGlobal", l_Camera3DMakeGlobal },
+        { NULL, NULL }
+    };
+    registerCameraClass(ctx, CAMERA2D_META, methods2D, l_Camera2DIndex, l_Camera2DNewIndex);
+    registerCameraClass(ctx, CAMERA3D_META, methods3D, l_Camera3DIndex, l_Camera3DNewIndex);
+}
+
 void pushCamera2D(LUA) {
     lua_newtable(ctx);
+    lua_pushcfunction(ctx, l_NewCamera2D);            lua_setfield(ctx, -2, "new");
     lua_pushcfunction(ctx, l_SetupCamera2D);          lua_setfield(ctx, -2, "setup");
     lua_pushcfunction(ctx, l_UseCamera2D);            lua_setfield(ctx, -2, "begin");
     lua_pushcfunction(ctx, l_StopCamera2D);           lua_setfield(ctx, -2, "stop");
     lua_pushcfunction(ctx, l_WorldToScreen2D);        lua_setfield(ctx, -2, "worldToScreen");
     lua_pushcfunction(ctx, l_ScreenToWorld2D);        lua_setfield(ctx, -2, "screenToWorld");
+    lua_pushcfunction(ctx, l_WorldToScreen2DBatch);   lua_setfield(ctx, -2, "worldToScreenBatch");
+    lua_pushcfunction(ctx, l_ScreenToWorld2DBatch);   lua_setfield(ctx, -2, "screenToWorldBatch");
+    lua_pushcfunction(ctx, l_VisibleRect2D);          lua_setfield(ctx, -2, "visibleRect");
     lua_pushcfunction(ctx, l_SetCamera2DField);       lua_setfield(ctx, -2, "setVec2");
     lua_pushcfunction(ctx, l_SetCamera2DNumber);      lua_setfield(ctx, -2, "setNumber");
     lua_setglobal(ctx, "Camera2D");
@@ -155,6 +519,7 @@ void pushCamera2D(LUA) {
 
 void pushCamera3D(LUA) {
     lua_newtable(ctx);
+    lua_pushcfunction(ctx, l_NewCamera3D);            lua_setfield(ctx, -2, "new");
     lua_pushcfunction(ctx, l_SetupCamera3D);          lua_setfield(ctx, -2, "setup");
     lua_pushcfunction(ctx, l_UseCamera3D);            lua_setfield(ctx, -2, "begin");
     lua_pushcfunction(ctx, l_StopCamera3D);           lua_setfield(ctx, -2, "stop");
@@ -174,6 +539,7 @@ void pushCamera3D(LUA) {
 }
 
 void initRaylibCamera(LUA) {
+    registerCameraClasses(ctx);
     pushCamera2D(ctx);
     pushCamera3D(ctx);
 }
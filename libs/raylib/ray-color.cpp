@@ -61,6 +61,12 @@ static Color lua_getColor(lua_State *L, int StartOfTable) {
   return color;
 }
 
+// Color with rgb scaled by alpha, the tint to draw premultiplied textures with
+static Color colorPremultiply(Color c) {
+  return Color{ (unsigned char)(c.r * c.a / 255), (unsigned char)(c.g * c.a / 255),
+                (unsigned char)(c.b * c.a / 255), c.a };
+}
+
 // Function to create a new color from a lua/lua table
 static int lua_create_color(lua_State *L) {
   // Check if the argument is a table
@@ -0,0 +1,401 @@
+// ray-font.cpp - Font: TTF fonts in bitmap or SDF atlases with a layout cache
+// Laying out a string (codepoint decoding, glyph lookup, advances) is done once
+// per (string, size) and cached on the font; drawing a cached layout is a
+// straight run of rlgl quads on the atlas texture, so consecutive text draws
+// with the same font end up in one draw call. DrawText/MeasureText go through
+// the same cache with raylib's default font.
+//
+//	local mono = Font.load("assets/mono.ttf", 32, { sdf = true })
+//	mono:drawLines(log, 10, 10, 14, WHITE) -- one shader bind for the whole view
+#pragma once
+#include <lua.hpp>
+#include <raylib.h>
+#include <rlgl.h>
+#include "../../../libs/lua_ffi.hpp" // pushPtr, getPtr
+#include "ray-target.cpp"            // optColor
+#include <algorithm>                 // std::remove
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#define FONT_LAYOUT_CACHE_SIZE 4096 // layouts per generation, see fontLayout
+
+// One glyph of a laid out string: destination relative to the text origin,
+// source in atlas pixels
+struct GlyphQuad {
+    float x, y, w, h;
+    float sx, sy, sw, sh;
+};
+
+struct TextLayout {
+    std::string text; // the key, compared on lookup so hash collisions only cost a rebuild
+    float size;
+    float width, height;
+    std::vector<GlyphQuad> quads;
+};
+
+struct FontFace {
+    Font font;
+    bool sdf;
+    bool isDefault;    // raylib's default font, never unloaded
+    float spacing;     // at baseSize, scaled with the draw size
+    float lineSpacing;
+    size_t cacheSize;
+    // two generations: when `layouts` is full it becomes `oldLayouts`, so
+    // strings still drawn every frame survive and stale ones are dropped
+    std::unordered_map<uint64_t, TextLayout> layouts;
+    std::unordered_map<uint64_t, TextLayout> oldLayouts;
+};
+
+static std::vector<FontFace*> fontPool;
+static FontFace defaultFontFaceData = {};
+
+static Shader fontSdfShader = { 0 };
+
+static const char* fontSdfFS =
+    "#version 330\n"
+    "in vec2 fragTexCoord;\n"
+    "in vec4 fragColor;\n"
+    "uniform sampler2D texture0;\n"
+    "uniform vec4 colDiffuse;\n"
+    "out vec4 finalColor;\n"
+    "void main() {\n"
+    "    float d = texture(texture0, fragTexCoord).a;\n"
+    "    float w = fwidth(d);\n"
+    "    float a = smoothstep(0.5 - w, 0.5 + w, d);\n"
+    "    finalColor = vec4(fragColor.rgb, fragColor.a*a)*colDiffuse;\n"
+    "}\n";
+
+// loaded on first use, needs a GL context
+static Shader fontGetSdfShader() {
+    if (!fontSdfShader.id) fontSdfShader = LoadShaderFromMemory(NULL, fontSdfFS);
+    return fontSdfShader;
+}
+
+// raylib's default font, picked up after InitWindow created it
+static FontFace* defaultFontFace() {
+    FontFace* face = &defaultFontFaceData;
+    if (!face->font.texture.id) {
+        face->font = GetFontDefault();
+        face->isDefault = true;
+        face->lineSpacing = 2; // same as DrawText
+        face->cacheSize = FONT_LAYOUT_CACHE_SIZE;
+    }
+    return face;
+}
+
+// called by CloseWindow: the next window gets a new default font texture and
+// GL context, so the default face (and its layouts) and the SDF shader are
+// picked up again. Pointers to the default face stay valid.
+static void fontCloseWindow() {
+    defaultFontFaceData = FontFace{};
+    fontSdfShader = Shader{ 0 };
+}
+
+static float fontSpacing(const FontFace* face, float size) {
+    if (face->isDefault) return (float)((int)size / 10); // DrawText: fontSize/defaultFontSize
+    return face->spacing * size / face->font.baseSize;
+}
+
+static uint64_t fontLayoutKey(const char* text, size_t len, float size) {
+    uint64_t h = 1469598103934665603ull; // FNV-1a
+    for (size_t i = 0; i < len; i++) h = (h ^ (unsigned char)text[i]) * 1099511628211ull;
+    uint32_t bits;
+    memcpy(&bits, &size, sizeof(bits));
+    return (h ^ bits) * 1099511628211ull;
+}
+
+static bool fontLayoutMatches(const TextLayout& layout, const char* text, size_t len, float size) {
+    return layout.size == size && layout.text.size() == len && memcmp(layout.text.data(), text, len) == 0;
+}
+
+// Same glyph placement and metrics as DrawTextEx/MeasureTextEx
+static void fontBuildLayout(const FontFace* face, TextLayout& layout, const char* text, size_t len, float size) {
+    const Font& font = face->font;
+    float scale = size / font.baseSize;
+    float spacing = fontSpacing(face, size);
+    float pad = (float)font.glyphPadding;
+
+    layout.text.assign(text, len);
+    layout.size = size;
+    layout.quads.clear();
+
+    float x = 0, y = 0, width = 0;
+    for (size_t i = 0; i < len;) {
+        int bytes = 0;
+        int cp = GetCodepointNext(text + i, &bytes);
+        i += std::max(bytes, 1);
+
+        if (cp == '\n') {
+            width = std::max(width, x > 0 ? x - spacing : 0);
+            x = 0;
+            y += size + face->lineSpacing;
+            continue;
+        }
+
+        int index = GetGlyphIndex(font, cp);
+        const GlyphInfo& glyph = font.glyphs[index];
+        const Rectangle& rec = font.recs[index];
+        if (cp != ' ' && cp != '\t') {
+            layout.quads.push_back({
+                x + (glyph.offsetX - pad) * scale, y + (glyph.offsetY - pad) * scale,
+                (rec.width + 2 * pad) * scale, (rec.height + 2 * pad) * scale,
+                rec.x - pad, rec.y - pad, rec.width + 2 * pad, rec.height + 2 * pad
+            });
+        }
+        x += (glyph.advanceX ? glyph.advanceX : rec.width) * scale + spacing;
+    }
+    layout.width = std::max(width, x > 0 ? x - spacing : 0);
+    layout.height = y + size;
+}
+
+// Cached layout of text at size, valid until the next fontLayout call on this face
+static const TextLayout& fontLayout(FontFace* face, const char* text, size_t len, float size) {
+    uint64_t key = fontLayoutKey(text, len, size);
+
+    auto it = face->layouts.find(key);
+    if (it != face->layouts.end() && fontLayoutMatches(it->second, text, len, size)) return it->second;
+
+    if (face->layouts.size() >= face->cacheSize) {
+        face->oldLayouts.swap(face->layouts);
+        face->layouts.clear();
+    }
+
+    TextLayout& layout = face->layouts[key];
+    auto old = face->oldLayouts.find(key);
+    if (old != face->oldLayouts.end() && fontLayoutMatches(old->second, text, len, size)) {
+        layout = std::move(old->second); // still in use, promote it
+        face->oldLayouts.erase(old);
+    } else {
+        fontBuildLayout(face, layout, text, len, size);
+    }
+    return layout;
+}
+
+// must be inside rlBegin(RL_QUADS) with the atlas texture set
+static void fontEmitLayout(const FontFace* face, const TextLayout& layout, float x, float y, Color tint) {
+    float iw = 1.0f / face->font.texture.width, ih = 1.0f / face->font.texture.height;
+    for (const GlyphQuad& q : layout.quads) {
+        rlCheckRenderBatchLimit(4); // flushes and restores the mode/texture if full
+        float u0 = q.sx * iw, v0 = q.sy * ih, u1 = (q.sx + q.sw) * iw, v1 = (q.sy + q.sh) * ih;
+        float x0 = x + q.x, y0 = y + q.y;
+
+        rlColor4ub(tint.r, tint.g, tint.b, tint.a);
+        rlNormal3f(0.0f, 0.0f, 1.0f);
+        rlTexCoord2f(u0, v0); rlVertex2f(x0, y0);
+        rlTexCoord2f(u0, v1); rlVertex2f(x0, y0 + q.h);
+        rlTexCoord2f(u1, v1); rlVertex2f(x0 + q.w, y0 + q.h);
+        rlTexCoord2f(u1, v0); rlVertex2f(x0 + q.w, y0);
+    }
+}
+
+static void fontBeginBatch(const FontFace* face) {
+    if (face->sdf) BeginShaderMode(fontGetSdfShader());
+    rlSetTexture(face->font.texture.id);
+    rlBegin(RL_QUADS);
+}
+
+static void fontEndBatch(const FontFace* face) {
+    rlEnd();
+    rlSetTexture(0);
+    if (face->sdf) EndShaderMode();
+}
+
+static void fontDrawText(FontFace* face, const char* text, size_t len, float x, float y, float size, Color tint) {
+    if (!face->font.texture.id || len == 0) return;
+    fontBeginBatch(face);
+    fontEmitLayout(face, fontLayout(face, text, len, size), x, y, tint);
+    fontEndBatch(face);
+}
+
+// Font.load(path, size[, { sdf = false, codepoints = "...", spacing = 0, lineSpacing = 2 }]) -> font
+static int l_FontLoad(lua_State* L) {
+    const char* path = luaL_checkstring(L, 1);
+    int size = luaL_checkinteger(L, 2);
+    luaL_argcheck(L, size > 0, 2, "size must be positive");
+
+    bool sdf = false;
+    float spacing = 0, lineSpacing = 2;
+    int* codepoints = NULL;
+    int codepointCount = 0;
+    if (lua_istable(L, 3)) {
+        lua_getfield(L, 3, "sdf");
+        sdf = lua_toboolean(L, -1);
+        lua_getfield(L, 3, "spacing");
+        spacing = luaL_optnumber(L, -1, 0);
+        lua_getfield(L, 3, "lineSpacing");
+        lineSpacing = luaL_optnumber(L, -1, 2);
+        lua_getfield(L, 3, "codepoints");
+        if (lua_isstring(L, -1)) codepoints = LoadCodepoints(lua_tostring(L, -1), &codepointCount);
+        lua_pop(L, 4);
+    }
+
+    int dataSize = 0;
+    unsigned char* data = LoadFileData(path, &dataSize);
+    if (!data) {
+        UnloadCodepoints(codepoints);
+        lua_pushnil(L);
+        lua_pushfstring(L, "Failed to read font: %s", path);
+        return 2;
+    }
+
+    // LoadFontEx only builds bitmap atlases, so the SDF path goes through LoadFontData
+    Font font = { 0 };
+    font.baseSize = size;
+    font.glyphCount = codepointCount > 0 ? codepointCount : 95;
+    font.glyphPadding = sdf ? 0 : 4; // SDF glyphs carry their own padding
+    font.glyphs = LoadFontData(data, dataSize, size, codepoints, codepointCount, sdf ? FONT_SDF : FONT_DEFAULT);
+    UnloadFileData(data);
+    UnloadCodepoints(codepoints);
+    if (!font.glyphs) {
+        lua_pushnil(L);
+        lua_pushfstring(L, "Failed to load font: %s", path);
+        return 2;
+    }
+
+    Image atlas = GenImageFontAtlas(font.glyphs, &font.recs, font.glyphCount, size, font.glyphPadding, 0);
+    font.texture = LoadTextureFromImage(atlas);
+    UnloadImage(atlas);
+    SetTextureFilter(font.texture, sdf ? TEXTURE_FILTER_BILINEAR : TEXTURE_FILTER_POINT);
+
+    FontFace* face = new FontFace();
+    face->font = font;
+    face->sdf = sdf;
+    face->isDefault = false;
+    face->spacing = spacing;
+    face->lineSpacing = lineSpacing;
+    face->cacheSize = FONT_LAYOUT_CACHE_SIZE;
+    fontPool.push_back(face);
+    pushPtr(L, face); // Pushed as userdata, no __gc
+    return 1;
+}
+
+// Font.default() -> the font DrawText uses
+static int l_FontDefault(lua_State* L) {
+    pushPtr(L, defaultFontFace());
+    return 1;
+}
+
+// font:draw(text, x, y[, size, color])
+static int l_FontDraw(lua_State* L) {
+    FontFace* face = getPtr<FontFace>(L, 1);
+    size_t len;
+    const char* text = luaL_checklstring(L, 2, &len);
+    float x = luaL_checknumber(L, 3);
+    float y = luaL_checknumber(L, 4);
+    float size = luaL_optnumber(L, 5, face->font.baseSize);
+    fontDrawText(face, text, len, x, y, size, optColor(L, 6));
+    return 0;
+}
+
+// font:drawLines(lines, x, y, lineHeight[, color, first, last]) - draws lines[first..last]
+// top to bottom in one batch, for log views and consoles; size is lineHeight
+static int l_FontDrawLines(lua_State* L) {
+    FontFace* face = getPtr<FontFace>(L, 1);
+    luaL_checktype(L, 2, LUA_TTABLE);
+    float x = luaL_checknumber(L, 3);
+    float y = luaL_checknumber(L, 4);
+    float lineHeight = luaL_checknumber(L, 5);
+    Color tint = optColor(L, 6);
+    lua_Integer first = luaL_optinteger(L, 7, 1);
+    lua_Integer last = luaL_optinteger(L, 8, (lua_Integer)lua_rawlen(L, 2));
+    if (!face->font.texture.id || first > last) return 0;
+
+    fontBeginBatch(face);
+    for (lua_Integer i = first; i <= last; i++, y += lineHeight) {
+        lua_rawgeti(L, 2, i);
+        size_t len;
+        const char* text = lua_tolstring(L, -1, &len);
+        if (text && len) fontEmitLayout(face, fontLayout(face, text, len, lineHeight), x, y, tint);
+        lua_pop(L, 1);
+    }
+    fontEndBatch(face);
+    return 0;
+}
+
+// font:measure(text[, size]) -> width, height
+static int l_FontMeasure(lua_State* L) {
+    FontFace* face = getPtr<FontFace>(L, 1);
+    size_t len;
+    const char* text = luaL_checklstring(L, 2, &len);
+    const TextLayout& layout = fontLayout(face, text, len, luaL_optnumber(L, 3, face->font.baseSize));
+    lua_pushnumber(L, layout.width);
+    lua_pushnumber(L, layout.height);
+    return 2;
+}
+
+static int l_FontGetSize(lua_State* L) {
+    lua_pushinteger(L, getPtr<FontFace>(L, 1)->font.baseSize);
+    return 1;
+}
+
+// font:setCacheSize(layouts) - layouts kept per generation, about twice that at most
+static int l_FontSetCacheSize(lua_State* L) {
+    FontFace* face = getPtr<FontFace>(L, 1);
+    face->cacheSize = std::max(1, (int)luaL_checkinteger(L, 2));
+    return 0;
+}
+
+static int l_FontClearCache(lua_State* L) {
+    FontFace* face = getPtr<FontFace>(L, 1);
+    face->layouts.clear();
+    face->oldLayouts.clear();
+    return 0;
+}
+
+static void freeFontFace(FontFace* face) {
+    UnloadFont(face->font);
+    delete face;
+}
+
+static int l_FontUnload(lua_State* L) {
+    FontFace* face = getPtr<FontFace>(L, 1);
+    if (!face || face->isDefault) return 0;
+    fontPool.erase(std::remove(fontPool.begin(), fontPool.end(), face), fontPool.end());
+    freeFontFace(face);
+    return 0;
+}
+
+static int l_FontUnloadAll(lua_State* L) {
+    for (FontFace* face : fontPool) freeFontFace(face);
+    fontPool.clear();
+    return 0;
+}
+
+// Register Font methods (no __gc)
+static void registerFontClass(lua_State* L) {
+    const char* type = typeid(FontFace).name();
+    if (luaL_newmetatable(L, type)) {
+        lua_pushstring(L, "__index");
+        lua_newtable(L);
+
+        static luaL_Reg methods[] = {
+            { "draw", l_FontDraw },
+            { "drawLines", l_FontDrawLines },
+            { "measure", l_FontMeasure },
+            { "getSize", l_FontGetSize },
+            { "setCacheSize", l_FontSetCacheSize },
+            { "clearCache", l_FontClearCache },
+            { "unload", l_FontUnload },
+            { NULL, NULL }
+        };
+        push_funcs(L, methods);
+
+        lua_settable(L, -3); // metatable.__index = table
+    }
+    lua_pop(L, 1);
+}
+
+static luaL_Reg fontFuncs[] = {
+    { "load", l_FontLoad },
+    { "default", l_FontDefault },
+    { "unloadAll", l_FontUnloadAll },
+    { NULL, NULL }
+};
+
+extern "C" void init_raylib_font(lua_State* L) {
+    registerFontClass(L);
+    newModule("Font", fontFuncs, L);
+}
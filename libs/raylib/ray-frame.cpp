@@ -0,0 +1,250 @@
+// ray-frame.cpp - per frame timings and the FrameStats overlay
+// BeginDrawing/EndDrawing (ray-init.cpp) and Music:Update (ray-sound.cpp)
+// feed the timings, everything is kept in a ring buffer so the history can be
+// read (percentiles, CSV dump) while frames keep being recorded.
+#pragma once
+#include <lua.hpp>
+#include <raylib.h>
+#include "../../../libs/lua_ffi.hpp" // newModule
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+// timings in milliseconds, the Lua heap in KB
+struct FrameSample {
+    float update;  // EndDrawing of the last frame -> BeginDrawing
+    float draw;    // BeginDrawing -> EndDrawing
+    float present; // EndDrawing itself (swap, vsync, input polling)
+    float audio;   // time spent in Music:Update during the frame
+    float total;
+    float heap;      // Lua heap at the end of the frame
+    float heapDelta; // change since the last frame: allocations minus what the GC freed
+};
+
+#define FRAME_HISTORY 1024 // must be a power of two
+
+// Single producer ring: only the frame loop writes, readers copy what they need.
+// `head` is published after the sample is written, so a reader never sees a
+// half written entry unless it is lapped by more than FRAME_HISTORY frames.
+struct FrameRing {
+    FrameSample samples[FRAME_HISTORY];
+    std::atomic<uint32_t> head{0};
+
+    void push(const FrameSample &s) {
+        uint32_t h = head.load(std::memory_order_relaxed);
+        samples[h & (FRAME_HISTORY - 1)] = s;
+        head.store(h + 1, std::memory_order_release);
+    }
+
+    // copies the last `max` samples, oldest first
+    std::vector<FrameSample> snapshot(uint32_t max = FRAME_HISTORY) const {
+        uint32_t h = head.load(std::memory_order_acquire);
+        uint32_t n = std::min(std::min(h, max), (uint32_t)FRAME_HISTORY);
+        std::vector<FrameSample> out(n);
+        for (uint32_t i = 0; i < n; i++)
+            out[i] = samples[(h - n + i) & (FRAME_HISTORY - 1)];
+        return out;
+    }
+};
+
+static struct {
+    bool enabled = false;
+    bool overlay = false;
+    int overlayX = 10, overlayY = 10;
+    double lastEnd = 0;
+    double begin = 0;
+    float lastHeap = -1; // KB, -1 until the first frame is recorded
+    FrameSample current = {};
+    FrameRing ring;
+} frameStats;
+
+static double frameNowMs() {
+    return std::chrono::duration<double, std::milli>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+static float framePercentile(std::vector<float> &values, float p) {
+    if (values.empty()) return 0;
+    size_t idx = (size_t)(p * (values.size() - 1));
+    std::nth_element(values.begin(), values.begin() + idx, values.end());
+    return values[idx];
+}
+
+static void frameDrawOverlay(int x, int y) {
+    const int width = 240, height = 80;
+    const float msToPx = height / 33.3f; // the graph tops out at 30 fps
+    std::vector<FrameSample> history = frameStats.ring.snapshot(width);
+
+    DrawRectangle(x, y, width, height + 30, Fade(BLACK, 0.6f));
+    int base = y + height;
+    int bx = x + width - (int)history.size();
+    for (const FrameSample &s : history) {
+        // stacked bar: update, draw, present, audio
+        float parts[4] = {s.update, s.draw, s.present, s.audio};
+        Color colors[4] = {SKYBLUE, LIME, ORANGE, MAGENTA};
+        int top = base;
+        for (int i = 0; i < 4; i++) {
+            int h = (int)(parts[i] * msToPx);
+            if (top - h < y) h = top - y;
+            if (h > 0) DrawLine(bx, top, bx, top - h, colors[i]);
+            top -= h;
+        }
+        bx++;
+    }
+    int line60 = base - (int)(16.6f * msToPx);
+    DrawLine(x, line60, x + width, line60, Fade(WHITE, 0.5f));
+
+    std::vector<float> totals;
+    totals.reserve(history.size());
+    for (const FrameSample &s : history) totals.push_back(s.total);
+    float p50 = framePercentile(totals, 0.5f);
+    float p99 = framePercentile(totals, 0.99f);
+    float max = totals.empty() ? 0 : *std::max_element(totals.begin(), totals.end());
+    DrawText(TextFormat("p50 %.2f  p99 %.2f  max %.2f ms", p50, p99, max), x + 4,
+             base + 8, 10, WHITE);
+}
+
+// called from lua_start_drawing
+static void frameBegin() {
+    if (!frameStats.enabled) return;
+    double now = frameNowMs();
+    if (frameStats.lastEnd == 0) frameStats.lastEnd = now;
+    frameStats.current.update = now - frameStats.lastEnd;
+    frameStats.begin = now;
+}
+
+// called from lua_stop_drawing, wraps EndDrawing itself
+static void frameEnd(lua_State *L) {
+    if (!frameStats.enabled) {
+        EndDrawing();
+        return;
+    }
+    FrameSample &cur = frameStats.current;
+    double drawEnd = frameNowMs();
+    cur.draw = drawEnd - frameStats.begin;
+
+    // the overlay is not part of any bucket
+    if (frameStats.overlay) frameDrawOverlay(frameStats.overlayX, frameStats.overlayY);
+
+    double presentStart = frameNowMs();
+    EndDrawing();
+    double presentEnd = frameNowMs();
+    cur.present = presentEnd - presentStart;
+
+    // the collector runs wherever the script allocates, so its work shows up in
+    // the heap size; it is read, never driven, so enabling stats changes nothing
+    cur.heap = lua_gc(L, LUA_GCCOUNT) + lua_gc(L, LUA_GCCOUNTB) / 1024.0f;
+    cur.heapDelta = frameStats.lastHeap < 0 ? 0 : cur.heap - frameStats.lastHeap;
+    frameStats.lastHeap = cur.heap;
+
+    cur.total = presentEnd - frameStats.lastEnd;
+    frameStats.ring.push(cur);
+    frameStats.lastEnd = presentEnd;
+    cur = {};
+}
+
+// called around Music:Update
+static void frameAddAudio(double ms) {
+    if (frameStats.enabled) frameStats.current.audio += ms;
+}
+
+static int l_FrameStatsEnable(lua_State *L) {
+    frameStats.enabled = lua_isnone(L, 1) ? true : lua_toboolean(L, 1);
+    frameStats.lastEnd = 0;
+    frameStats.lastHeap = -1;
+    frameStats.current = {};
+    return 0;
+}
+
+static int l_FrameStatsOverlay(lua_State *L) {
+    frameStats.overlay = lua_isnone(L, 1) ? true : lua_toboolean(L, 1);
+    frameStats.overlayX = luaL_optinteger(L, 2, 10);
+    frameStats.overlayY = luaL_optinteger(L, 3, 10);
+    return 0;
+}
+
+static void pushFramePercentiles(lua_State *L, std::vector<float> &values, const char *name) {
+    lua_newtable(L);
+    lua_pushnumber(L, framePercentile(values, 0.5f));
+    lua_setfield(L, -2, "p50");
+    lua_pushnumber(L, framePercentile(values, 0.99f));
+    lua_setfield(L, -2, "p99");
+    lua_pushnumber(L, values.empty() ? 0 : *std::max_element(values.begin(), values.end()));
+    lua_setfield(L, -2, "max");
+    lua_setfield(L, -2, name);
+}
+
+// FrameStats.get([frames]) -> { frames = n, total = {p50, p99, max}, update = {...}, ... }
+// heap and heapDelta are in KB, everything else in milliseconds
+static int l_FrameStatsGet(lua_State *L) {
+    uint32_t count = luaL_optinteger(L, 1, FRAME_HISTORY);
+    std::vector<FrameSample> history = frameStats.ring.snapshot(count);
+
+    std::vector<float> columns[7];
+    for (const FrameSample &s : history) {
+        columns[0].push_back(s.update);
+        columns[1].push_back(s.draw);
+        columns[2].push_back(s.present);
+        columns[3].push_back(s.audio);
+        columns[4].push_back(s.total);
+        columns[5].push_back(s.heap);
+        columns[6].push_back(s.heapDelta);
+    }
+
+    lua_newtable(L);
+    lua_pushinteger(L, history.size());
+    lua_setfield(L, -2, "frames");
+    pushFramePercentiles(L, columns[0], "update");
+    pushFramePercentiles(L, columns[1], "draw");
+    pushFramePercentiles(L, columns[2], "present");
+    pushFramePercentiles(L, columns[3], "audio");
+    pushFramePercentiles(L, columns[4], "total");
+    pushFramePercentiles(L, columns[5], "heap");
+    pushFramePercentiles(L, columns[6], "heapDelta");
+    return 1;
+}
+
+static int l_FrameStatsDumpCSV(lua_State *L) {
+    const char *path = luaL_checkstring(L, 1);
+    FILE *file = fopen(path, "w");
+    if (!file) {
+        lua_pushboolean(L, 0);
+        lua_pushfstring(L, "Cannot open file '%s' for writing", path);
+        return 2;
+    }
+
+    fprintf(file, "frame,update_ms,draw_ms,present_ms,audio_ms,total_ms,heap_kb,heap_delta_kb\n");
+    std::vector<FrameSample> history = frameStats.ring.snapshot();
+    for (size_t i = 0; i < history.size(); i++) {
+        const FrameSample &s = history[i];
+        fprintf(file, "%zu,%.4f,%.4f,%.4f,%.4f,%.4f,%.1f,%.1f\n", i, s.update, s.draw,
+                s.present, s.audio, s.total, s.heap, s.heapDelta);
+    }
+    fclose(file);
+    lua_pushboolean(L, 1);
+    return 1;
+}
+
+static int l_FrameStatsReset(lua_State *L) {
+    frameStats.ring.head.store(0, std::memory_order_release);
+    frameStats.lastEnd = 0;
+    frameStats.lastHeap = -1;
+    frameStats.current = {};
+    return 0;
+}
+
+static luaL_Reg frameStatsFuncs[] = {
+    { "enable", l_FrameStatsEnable },
+    { "overlay", l_FrameStatsOverlay },
+    { "get", l_FrameStatsGet },
+    { "dumpCSV", l_FrameStatsDumpCSV },
+    { "reset", l_FrameStatsReset },
+    { NULL, NULL }
+};
+
+void init_raylib_frame_stats(lua_State *L) {
+    newModule("FrameStats", frameStatsFuncs, L);
+}
@@ -0,0 +1,176 @@
+// ray-headless.cpp - render into an offscreen target instead of the window
+// enabled with `rocket --headless` (or ROCKET_HEADLESS=1 when using raylib.so)
+//
+// The window is created hidden and every BeginDrawing/EndDrawing pair is
+// redirected into a RenderTexture2D, so frames can be read back, saved as
+// PNG or streamed to a video encoder. The GL context still comes from
+// raylib's platform layer: on machines without a display server run under
+// Xvfb or use a raylib build with a surfaceless/DRM platform.
+#pragma once
+#include <lua.hpp>
+#include <raylib.h>
+#include "../../../libs/lua_ffi.hpp" // newModule
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+static bool rocketHeadless = false;
+static int headlessFrameLimit = 0; // 0 means run until the script stops
+
+static struct {
+    RenderTexture2D target = {0};
+    int frames = 0;
+    // recording: either a directory of numbered PNGs or a pipe taking raw RGBA
+    std::string recordDir;
+    FILE *recordPipe = nullptr;
+} headless;
+
+static bool headlessEnabled() {
+    if (!rocketHeadless) {
+        const char *env = getenv("ROCKET_HEADLESS");
+        rocketHeadless = env && env[0] && strcmp(env, "0") != 0;
+    }
+    return rocketHeadless;
+}
+
+// the returned image is owned by the caller
+static Image headlessReadFrame() {
+    Image img = LoadImageFromTexture(headless.target.texture);
+    ImageFlipVertical(&img); // render textures are stored bottom-up
+    return img;
+}
+
+static void headlessRecordFrame() {
+    if (headless.recordDir.empty() && !headless.recordPipe) return;
+
+    Image img = headlessReadFrame();
+    if (headless.recordPipe) {
+        ImageFormat(&img, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+        fwrite(img.data, 4, (size_t)img.width * img.height, headless.recordPipe);
+    } else {
+        ExportImage(img, TextFormat("%s/frame_%05d.png", headless.recordDir.c_str(), headless.frames));
+    }
+    UnloadImage(img);
+}
+
+// called by lua_create_window instead of InitWindow
+static void headlessInitWindow(int width, int height, const char *title) {
+    SetConfigFlags(FLAG_WINDOW_HIDDEN);
+    InitWindow(width, height, title);
+    headless.target = LoadRenderTexture(width, height);
+    headless.frames = 0;
+}
+
+static void headlessCloseWindow() {
+    if (headless.recordPipe) {
+        pclose(headless.recordPipe);
+        headless.recordPipe = nullptr;
+    }
+    if (headless.target.id) UnloadRenderTexture(headless.target);
+    headless.target = {0};
+}
+
+// called right after BeginDrawing
+static void headlessBeginFrame() {
+    if (rocketHeadless && headless.target.id) BeginTextureMode(headless.target);
+}
+
+// called right before EndDrawing, frames are counted in windowed mode too for --frames
+static void headlessEndFrame() {
+    if (rocketHeadless && headless.target.id) {
+        EndTextureMode();
+        headlessRecordFrame();
+    }
+    headless.frames++;
+}
+
+static bool headlessShouldClose() {
+    return headlessFrameLimit > 0 && headless.frames >= headlessFrameLimit;
+}
+
+static int l_HeadlessIsEnabled(lua_State *L) {
+    lua_pushboolean(L, headlessEnabled());
+    return 1;
+}
+
+// Headless.saveFrame(path) - exports the last finished frame, format from the extension
+static int l_HeadlessSaveFrame(lua_State *L) {
+    const char *path = luaL_checkstring(L, 1);
+    if (!headless.target.id) {
+        lua_pushboolean(L, 0);
+        lua_pushstring(L, "Not running headless");
+        return 2;
+    }
+    Image img = headlessReadFrame();
+    bool ok = ExportImage(img, path);
+    UnloadImage(img);
+    lua_pushboolean(L, ok);
+    return 1;
+}
+
+// Headless.readPixels() -> RGBA8 string, width, height
+static int l_HeadlessReadPixels(lua_State *L) {
+    if (!headless.target.id) {
+        lua_pushnil(L);
+        lua_pushstring(L, "Not running headless");
+        return 2;
+    }
+    Image img = headlessReadFrame();
+    ImageFormat(&img, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+    lua_pushlstring(L, (const char *)img.data, (size_t)img.width * img.height * 4);
+    lua_pushinteger(L, img.width);
+    lua_pushinteger(L, img.height);
+    UnloadImage(img);
+    return 3;
+}
+
+// Headless.record(dir) writes dir/frame_00000.png for every frame.
+// Headless.record("|cmd") pipes raw RGBA frames into cmd, e.g.
+// "|ffmpeg -f rawvideo -pix_fmt rgba -s 640x480 -r 60 -i - out.mp4"
+static int l_HeadlessRecord(lua_State *L) {
+    const char *dest = luaL_checkstring(L, 1);
+    if (headless.recordPipe) pclose(headless.recordPipe);
+    headless.recordPipe = nullptr;
+    headless.recordDir.clear();
+
+    if (dest[0] == '|') {
+        headless.recordPipe = popen(dest + 1, "w");
+        if (!headless.recordPipe) {
+            lua_pushboolean(L, 0);
+            lua_pushfstring(L, "Cannot start '%s'", dest + 1);
+            return 2;
+        }
+    } else {
+        headless.recordDir = dest;
+    }
+    lua_pushboolean(L, 1);
+    return 1;
+}
+
+static int l_HeadlessStopRecording(lua_State *L) {
+    if (headless.recordPipe) pclose(headless.recordPipe);
+    headless.recordPipe = nullptr;
+    headless.recordDir.clear();
+    return 0;
+}
+
+// Headless.frameLimit(n) - WindowShouldClose returns true after n frames
+static int l_HeadlessFrameLimit(lua_State *L) {
+    headlessFrameLimit = luaL_checkinteger(L, 1);
+    return 0;
+}
+
+static luaL_Reg headlessFuncs[] = {
+    { "isEnabled", l_HeadlessIsEnabled },
+    { "saveFrame", l_HeadlessSaveFrame },
+    { "readPixels", l_HeadlessReadPixels },
+    { "record", l_HeadlessRecord },
+    { "stopRecording", l_HeadlessStopRecording },
+    { "frameLimit", l_HeadlessFrameLimit },
+    { NULL, NULL }
+};
+
+void init_raylib_headless(lua_State *L) {
+    newModule("Headless", headlessFuncs, L);
+}
@@ -3,21 +3,206 @@
 #include <vector>
 #include "../../../libs/lua_ffi.hpp" // needs: pushPtr, getPtr
 #include "ray-color.cpp" // needs: Color lua_getColor(lua_State*, int)
-#include <algorithm>     // std::remove
+#include "../buffer.hpp"  // Buffer, checkBuffer, pushNewBuffer
+#include "ray-imgops.cpp" // CPU pixel kernels
+#include "../rtex.hpp"    // .rtex containers made by tools/texconv.cpp
+#include "../pack/pack.hpp" // packRead
+#include <algorithm>     // std::remove, std::find
+#include <string>
 
 struct Img {
     Image image;
     Texture2D texture;
+    int dirtyX0, dirtyY0, dirtyX1, dirtyY1; // pixels changed since the last upload, empty when x1 <= x0
+    std::string path; // file the pixels can be reloaded from, empty once they were edited
+    bool premultiplied; // drawn with BLEND_ALPHA_PREMULTIPLY
+    unsigned version;   // bumped by every upload, lets texture users see in place edits
 };
 
 // Manual image pool tracking
 static std::vector<Img*> imgPool;
+
+// False once img was unloaded, for modules that keep an Img* and draw its
+// texture later (Particles, Tilemap)
+static bool imgAlive(const Img* img) {
+    return img && std::find(imgPool.begin(), imgPool.end(), img) != imgPool.end();
+}
+
+// Default for the keepPixels load flag, see Image.setKeepPixels
+static bool imgKeepPixelsDefault = true;
+
+static void imgMarkDirty(Img* img, int x, int y, int w, int h) {
+    if (w <= 0 || h <= 0) return;
+    img->path.clear(); // the file no longer matches
+    if (img->dirtyX1 <= img->dirtyX0) {
+        img->dirtyX0 = x;
+        img->dirtyY0 = y;
+        img->dirtyX1 = x + w;
+        img->dirtyY1 = y + h;
+        return;
+    }
+    img->dirtyX0 = std::min(img->dirtyX0, x);
+    img->dirtyY0 = std::min(img->dirtyY0, y);
+    img->dirtyX1 = std::max(img->dirtyX1, x + w);
+    img->dirtyY1 = std::max(img->dirtyY1, y + h);
+}
+
+// Blend mode to draw img's texture with, given the one straight alpha pixels
+// use: premultiplied pixels (texconv's default, img:premultiply()) take
+// BLEND_ALPHA_PREMULTIPLY, or BLEND_ADD_COLORS in place of BLEND_ADDITIVE.
+// Draw them with an imgTint'd color too. img may be NULL.
+static int imgBlendMode(const Img* img, int blend) {
+    if (!img || !img->premultiplied) return blend;
+    return blend == BLEND_ADDITIVE ? BLEND_ADD_COLORS : BLEND_ALPHA_PREMULTIPLY;
+}
+
+static Color imgTint(const Img* img, Color tint) {
+    return img && img->premultiplied ? colorPremultiply(tint) : tint;
+}
+
+// Sends the dirty pixels to the texture. A texture that no longer matches the
+// image (after resize, crop or a format change) is recreated instead, which
+// gives it a new id. Mipmapped textures get their mip levels regenerated.
+static void imgUpload(Img* img) {
+    Image& image = img->image;
+    if (!image.data) return; // pixels dropped, the texture is already current
+    bool mipmapped = img->texture.mipmaps > 1;
+    bool uploaded = true;
+    if (img->texture.width != image.width || img->texture.height != image.height
+        || img->texture.format != image.format) {
+        if (img->texture.id) UnloadTexture(img->texture);
+        img->texture = LoadTextureFromImage(image);
+        if (mipmapped && img->texture.id) {
+            GenTextureMipmaps(&img->texture);
+            SetTextureFilter(img->texture, TEXTURE_FILTER_TRILINEAR);
+        }
+    } else if (img->dirtyX1 > img->dirtyX0) {
+        int x = img->dirtyX0, y = img->dirtyY0;
+        int w = img->dirtyX1 - x, h = img->dirtyY1 - y;
+        const uint8_t* px = (const uint8_t*)image.data + ((size_t)y * image.width + x) * 4;
+        Rectangle rect = { (float)x, (float)y, (float)w, (float)h };
+        if (w == image.width) {
+            UpdateTextureRec(img->texture, rect, px); // whole rows are already contiguous
+        } else {
+            std::vector<uint8_t> rows((size_t)w * h * 4);
+            for (int row = 0; row < h; row++)
+                memcpy(&rows[(size_t)row * w * 4], px + (size_t)row * image.width * 4, (size_t)w * 4);
+            UpdateTextureRec(img->texture, rect, rows.data());
+        }
+        if (mipmapped) GenTextureMipmaps(&img->texture); // UpdateTextureRec only wrote level 0
+    } else {
+        uploaded = false;
+    }
+    if (uploaded) img->version++;
+    img->dirtyX0 = img->dirtyY0 = img->dirtyX1 = img->dirtyY1 = 0;
+}
+
+// Frees the CPU copy of a texture, after sending it any pending changes.
+// Width, height and format stay valid; imgEnsurePixels brings the pixels back.
+static void imgDropPixels(Img* img) {
+    if (!img->image.data) return;
+    imgUpload(img);
+    UnloadImage(img->image);
+    img->image.data = nullptr;
+}
+
+// Loads a .rtex container, from a mounted pack or the disk. Uncompressed
+// pixels go to the GPU straight from the mapping; *image only gets its own
+// copy of the pixels when keepPixels is set (size and format are filled in
+// either way). tex may be NULL to load just the pixels. Returns NULL or an
+// error message.
+static const char* imgLoadRtex(const char* path, bool keepPixels, Image* image, Texture2D* tex, bool* premultiplied) {
+    RtexFile f;
+    PackData packed; // f points into it when the file comes from a pack
+    if (packRead(path, &packed)) {
+        if (const char* err = rtexParse(packed.data, packed.size, &f)) return err;
+    } else if (const char* err = rtexOpen(path, &f)) {
+        return err;
+    }
+    const RtexHeader& h = f.header;
+    Image view = { (void*)rtexRawPixels(f), (int)h.width, (int)h.height, (int)h.mipmaps, (int)h.format };
+    void* decoded = nullptr;
+    if (!view.data || keepPixels) {
+        decoded = MemAlloc((unsigned int)h.rawSize);
+        if (!decoded || !rtexDecode(f, decoded)) {
+            MemFree(decoded);
+            rtexClose(&f);
+            return "Corrupt rtex file";
+        }
+        view.data = decoded;
+    }
+
+    const char* err = nullptr;
+    if (tex) {
+        *tex = LoadTextureFromImage(view);
+        if (!tex->id) err = "Failed to create texture";
+        else if (h.mipmaps > 1) SetTextureFilter(*tex, TEXTURE_FILTER_TRILINEAR);
+    }
+    rtexClose(&f);
+    if (err || !keepPixels) {
+        MemFree(decoded);
+        view.data = nullptr;
+    }
+    *image = view;
+    if (premultiplied) *premultiplied = h.flags & RTEX_PREMULTIPLIED;
+    return err;
+}
+
+// LoadImage that also reads .rtex containers
+static Image imgLoadFile(const char* path) {
+    if (!IsFileExtension(path, ".rtex")) return LoadImage(path);
+    Image image = { 0 };
+    imgLoadRtex(path, true, &image, nullptr, nullptr);
+    return image;
+}
+
+// Reloads dropped pixels: from the file when the image was never edited
+// (resized back to the texture size for loadAndResize/loadAndScale), from the
+// texture otherwise. False when both fail.
+static bool imgEnsurePixels(Img* img) {
+    if (img->image.data) return true;
+    Image image = { 0 };
+    if (!img->path.empty()) {
+        image = imgLoadFile(img->path.c_str());
+        if (image.data && (image.width != img->texture.width || image.height != img->texture.height))
+            ImageResize(&image, img->texture.width, img->texture.height);
+    }
+    if (!image.data && img->texture.id) image = LoadImageFromTexture(img->texture);
+    if (!image.data) return false;
+    img->image = image;
+    return true;
+}
+
+// keepPixels argument of the loaders, the global default when missing
+static bool optKeepPixels(lua_State* L, int arg) {
+    return lua_isnoneornil(L, arg) ? imgKeepPixelsDefault : lua_toboolean(L, arg);
+}
+
+// Tracks a freshly loaded image and drops its pixels unless they are wanted
+static void imgLoaded(Img* img, const char* path, bool keepPixels) {
+    img->path = path;
+    imgPool.push_back(img); // Track for cleanup
+    if (!keepPixels) imgDropPixels(img);
+}
+
+// Readies the CPU copy for a kernel: pixels present, RGBA8. ImageFormat can't
+// decode block compressed formats (DXT, ETC...), those images can't be edited.
+// Only the first mip level is edited, imgUpload regenerates the others.
+static void imgPrepareOps(lua_State* L, Img* img) {
+    if (!imgEnsurePixels(img)) luaL_error(L, "Failed to reload image pixels");
+    imgopsEnsureRGBA(&img->image);
+    if (img->image.format != PIXELFORMAT_UNCOMPRESSED_R8G8B8A8)
+        luaL_error(L, "Image ops need uncompressed pixels (format %d)", img->image.format);
+    img->image.mipmaps = 1;
+}
+
+// Image.loadAndResize(path, width, height[, keepPixels])
 static int l_LoadAndResize(lua_State* L){
     const char* path = luaL_checkstring(L, 1);
     int width = luaL_checkinteger(L, 2);
     int height = luaL_checkinteger(L, 3);
 
-    Image img = LoadImage(path);
+    Image img = imgLoadFile(path);
     if (!img.data) {
         lua_pushnil(L);
         lua_pushstring(L, "Failed to load image");
@@ -34,17 +219,18 @@ static int l_LoadAndResize(lua_State* L){
     }
 
     Img* wrapper = new Img{ img, tex };
-    imgPool.push_back(wrapper); // Track for cleanup
+    imgLoaded(wrapper, path, optKeepPixels(L, 4));
 
     pushPtr(L, wrapper); // Pushed as userdata, no __gc
     return 1;
 }
 
+// Image.loadAndScale(path, scale[, keepPixels])
 static int l_LoadAndScale(lua_State* L){
     const char* path = luaL_checkstring(L, 1);
     float scale = luaL_checknumber(L, 2);
 
-    Image img = LoadImage(path);
+    Image img = imgLoadFile(path);
     if (!img.data) {
         lua_pushnil(L);
         lua_pushstring(L, "Failed to load image");
@@ -62,15 +248,38 @@ static int l_LoadAndScale(lua_State* L){
     }
 
     Img* wrapper = new Img{ img, tex };
-    imgPool.push_back(wrapper); // Track for cleanup
+    imgLoaded(wrapper, path, optKeepPixels(L, 3));
 
     pushPtr(L, wrapper); // Pushed as userdata, no __gc
     return 1;
 }
 
+// Image.load(path[, keepPixels]) - with keepPixels false the CPU copy is freed
+// once the texture is made and reloaded from the file only when an image op
+// or getPixels needs it (default: Image.setKeepPixels, true unless changed).
+// .rtex files (tools/texconv.cpp) are mapped and uploaded without decoding.
 static int l_LoadImage(lua_State* L) {
     const char* path = luaL_checkstring(L, 1);
 
+    if (IsFileExtension(path, ".rtex")) {
+        Image img;
+        Texture2D tex;
+        bool premultiplied;
+        bool keepPixels = optKeepPixels(L, 2);
+        if (const char* err = imgLoadRtex(path, keepPixels, &img, &tex, &premultiplied)) {
+            lua_pushnil(L);
+            lua_pushstring(L, err);
+            return 2;
+        }
+
+        Img* wrapper = new Img{ img, tex };
+        wrapper->premultiplied = premultiplied;
+        imgLoaded(wrapper, path, keepPixels);
+
+        pushPtr(L, wrapper); // Pushed as userdata, no __gc
+        return 1;
+    }
+
     Image img = LoadImage(path);
     if (!img.data) {
         lua_pushnil(L);
@@ -86,6 +295,39 @@ static int l_LoadImage(lua_State* L) {
         return 2;
     }
 
+    Img* wrapper = new Img{ img, tex };
+    imgLoaded(wrapper, path, optKeepPixels(L, 2));
+
+    pushPtr(L, wrapper); // Pushed as userdata, no __gc
+    return 1;
+}
+
+// Image.fromBuffer(buffer, width, height) -> image, buffer holds width*height
+// RGBA8 pixels (a u8 buffer, or any view of the same bytes)
+static int l_ImageFromBuffer(lua_State* L) {
+    Buffer* buf = checkBuffer(L, 1);
+    int width = luaL_checkinteger(L, 2);
+    int height = luaL_checkinteger(L, 3);
+    luaL_argcheck(L, width > 0 && height > 0, 2, "size must be positive");
+    size_t size = (size_t)width * height * 4;
+    luaL_argcheck(L, buf->byteSize() == size, 1, "expected width*height*4 bytes");
+
+    Image img = { MemAlloc(size), width, height, 1, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 };
+    if (!img.data) {
+        lua_pushnil(L);
+        lua_pushstring(L, "Failed to allocate image");
+        return 2;
+    }
+    memcpy(img.data, buf->bytes(), size);
+
+    Texture2D tex = LoadTextureFromImage(img);
+    if (!tex.id) {
+        UnloadImage(img);
+        lua_pushnil(L);
+        lua_pushstring(L, "Failed to create texture");
+        return 2;
+    }
+
     Img* wrapper = new Img{ img, tex };
     imgPool.push_back(wrapper); // Track for cleanup
 
@@ -93,12 +335,17 @@ static int l_LoadImage(lua_State* L) {
     return 1;
 }
 
+// img:draw(x, y, color) - premultiplied images (see isPremultiplied) are
+// drawn with BLEND_ALPHA_PREMULTIPLY
 static int l_Draw(lua_State* L) {
     Img* img = getPtr<Img>(L, 1);
     int x = luaL_checkinteger(L, 2);
     int y = luaL_checkinteger(L, 3);
     Color c = lua_getColor(L, 4);
-    DrawTexture(img->texture, x, y, c);
+    int blend = imgBlendMode(img, BLEND_ALPHA);
+    if (blend != BLEND_ALPHA) BeginBlendMode(blend);
+    DrawTexture(img->texture, x, y, imgTint(img, c));
+    if (blend != BLEND_ALPHA) EndBlendMode();
     return 0;
 }
 
@@ -112,6 +359,200 @@ static int l_GetSize(lua_State* L) {
     return 1;
 }
 
+// img:getPixels() -> u8 buffer of width*height RGBA8 pixels (a copy)
+static int l_GetPixels(lua_State* L) {
+    Img* img = getPtr<Img>(L, 1);
+    if (!imgEnsurePixels(img)) return luaL_error(L, "Failed to reload image pixels");
+    Buffer* buf = pushNewBuffer(L, BUFFER_U8, (size_t)img->image.width * img->image.height * 4);
+    Color* colors = LoadImageColors(img->image);
+    if (colors) {
+        memcpy(buf->bytes(), colors, buf->byteSize());
+        UnloadImageColors(colors);
+    }
+    return 1;
+}
+
+// img:update([buffer]) uploads the pixels changed by the image ops to the
+// texture. With a buffer of width*height RGBA8 pixels, replaces every pixel
+// first.
+static int l_UpdateImage(lua_State* L) {
+    Img* img = getPtr<Img>(L, 1);
+    if (!lua_isnoneornil(L, 2)) {
+        Buffer* buf = checkBuffer(L, 2);
+        size_t size = (size_t)img->image.width * img->image.height * 4;
+        luaL_argcheck(L, buf->byteSize() == size, 2, "expected width*height*4 bytes");
+        imgPrepareOps(L, img);
+        memcpy(img->image.data, buf->bytes(), size);
+        imgMarkDirty(img, 0, 0, img->image.width, img->image.height);
+    }
+    imgUpload(img);
+    return 0;
+}
+
+// img:resize(width, height[, filter]) - filter is "bilinear" (default),
+// "nearest" or "box" (averages, best for shrinking)
+static int l_ImageResize(lua_State* L) {
+    Img* img = getPtr<Img>(L, 1);
+    int width = luaL_checkinteger(L, 2);
+    int height = luaL_checkinteger(L, 3);
+    int filter = luaL_checkoption(L, 4, "bilinear", imgopsFilterNames);
+    luaL_argcheck(L, width > 0 && height > 0, 2, "size must be positive");
+
+    imgPrepareOps(L, img);
+    Image resized = imgopsResize(img->image, width, height, filter);
+    if (!resized.data) return luaL_error(L, "Failed to allocate image");
+    UnloadImage(img->image);
+    img->image = resized;
+    imgMarkDirty(img, 0, 0, width, height);
+    return 0;
+}
+
+// img:blur(radius[, passes]) - box blur, 3 passes (the default) looks gaussian
+static int l_ImageBlur(lua_State* L) {
+    Img* img = getPtr<Img>(L, 1);
+    int radius = luaL_checkinteger(L, 2);
+    int passes = luaL_optinteger(L, 3, 3);
+    if (radius <= 0 || passes <= 0) return 0;
+
+    imgPrepareOps(L, img);
+    imgopsBlur(&img->image, radius, passes);
+    imgMarkDirty(img, 0, 0, img->image.width, img->image.height);
+    return 0;
+}
+
+// img:colorMatrix(m) - m is a table of 20 numbers, a 4x5 row major matrix:
+// r' = m[1]*r + m[2]*g + m[3]*b + m[4]*a + m[5] and so on, channels in 0-255
+static int l_ImageColorMatrix(lua_State* L) {
+    Img* img = getPtr<Img>(L, 1);
+    luaL_checktype(L, 2, LUA_TTABLE);
+    luaL_argcheck(L, lua_rawlen(L, 2) == 20, 2, "expected 20 numbers");
+    float m[20];
+    for (int i = 0; i < 20; i++) {
+        lua_rawgeti(L, 2, i + 1);
+        m[i] = lua_tonumber(L, -1);
+        lua_pop(L, 1);
+    }
+
+    imgPrepareOps(L, img);
+    imgopsColorMatrix(&img->image, m);
+    imgMarkDirty(img, 0, 0, img->image.width, img->image.height);
+    return 0;
+}
+
+// img:tint(color) - multiplies every pixel by color
+static int l_ImageTint(lua_State* L) {
+    Img* img = getPtr<Img>(L, 1);
+    Color c = lua_getColor(L, 2);
+    float m[20] = {
+        c.r / 255.0f, 0, 0, 0, 0,
+        0, c.g / 255.0f, 0, 0, 0,
+        0, 0, c.b / 255.0f, 0, 0,
+        0, 0, 0, c.a / 255.0f, 0,
+    };
+
+    imgPrepareOps(L, img);
+    imgopsColorMatrix(&img->image, m);
+    imgMarkDirty(img, 0, 0, img->image.width, img->image.height);
+    return 0;
+}
+
+static int l_ImagePremultiply(lua_State* L) {
+    Img* img = getPtr<Img>(L, 1);
+    if (img->premultiplied) return 0;
+    imgPrepareOps(L, img);
+    imgopsPremultiply(&img->image);
+    img->premultiplied = true;
+    imgMarkDirty(img, 0, 0, img->image.width, img->image.height);
+    return 0;
+}
+
+// img:crop(x, y, w, h) - clipped to the image
+static int l_ImageCrop(lua_State* L) {
+    Img* img = getPtr<Img>(L, 1);
+    int x = luaL_checkinteger(L, 2), y = luaL_checkinteger(L, 3);
+    int w = luaL_checkinteger(L, 4), h = luaL_checkinteger(L, 5);
+    if (!imgopsClip(&x, &y, &w, &h, img->image.width, img->image.height))
+        return luaL_error(L, "crop rectangle is outside the image");
+
+    imgPrepareOps(L, img);
+    Image cropped = imgopsCrop(img->image, x, y, w, h);
+    if (!cropped.data) return luaL_error(L, "Failed to allocate image");
+    UnloadImage(img->image);
+    img->image = cropped;
+    imgMarkDirty(img, 0, 0, w, h);
+    return 0;
+}
+
+// img:blit(src, x, y[, sx, sy, w, h[, blend]]) - draws a region of another
+// image (all of it by default) at x, y; alpha blended unless blend is false
+static int l_ImageBlit(lua_State* L) {
+    Img* img = getPtr<Img>(L, 1);
+    Img* src = getPtr<Img>(L, 2);
+    int x = luaL_checkinteger(L, 3), y = luaL_checkinteger(L, 4);
+    imgPrepareOps(L, img);
+    imgPrepareOps(L, src);
+    int sx = luaL_optinteger(L, 5, 0), sy = luaL_optinteger(L, 6, 0);
+    int w = luaL_optinteger(L, 7, src->image.width), h = luaL_optinteger(L, 8, src->image.height);
+    bool blend = lua_isnoneornil(L, 9) || lua_toboolean(L, 9);
+
+    int touched[4];
+    imgopsBlit(&img->image, src->image, sx, sy, w, h, x, y, blend, touched);
+    imgMarkDirty(img, touched[0], touched[1], touched[2], touched[3]);
+    return 0;
+}
+
+// img:copy() -> a new image with its own pixels and texture, e.g. to make a
+// thumbnail or a tinted variant without loading the file again
+static int l_ImageCopy(lua_State* L) {
+    Img* img = getPtr<Img>(L, 1);
+    if (!imgEnsurePixels(img)) return luaL_error(L, "Failed to reload image pixels");
+    Image copy = ImageCopy(img->image);
+    if (!copy.data) {
+        lua_pushnil(L);
+        lua_pushstring(L, "Failed to copy image");
+        return 2;
+    }
+
+    Texture2D tex = LoadTextureFromImage(copy);
+    if (!tex.id) {
+        UnloadImage(copy);
+        lua_pushnil(L);
+        lua_pushstring(L, "Failed to create texture");
+        return 2;
+    }
+
+    Img* wrapper = new Img{ copy, tex };
+    wrapper->premultiplied = img->premultiplied;
+    imgPool.push_back(wrapper); // Track for cleanup
+
+    pushPtr(L, wrapper); // Pushed as userdata, no __gc
+    return 1;
+}
+
+// img:dropPixels() - frees the CPU copy now, see Image.load
+static int l_ImageDropPixels(lua_State* L) {
+    imgDropPixels(getPtr<Img>(L, 1));
+    return 0;
+}
+
+// img:isPremultiplied() - true for premultiplied .rtex files and after
+// img:premultiply()
+static int l_ImageIsPremultiplied(lua_State* L) {
+    lua_pushboolean(L, getPtr<Img>(L, 1)->premultiplied);
+    return 1;
+}
+
+static int l_ImageHasPixels(lua_State* L) {
+    lua_pushboolean(L, getPtr<Img>(L, 1)->image.data != nullptr);
+    return 1;
+}
+
+// Image.setKeepPixels(keep) - default for the keepPixels flag of the loaders
+static int l_SetKeepPixels(lua_State* L) {
+    imgKeepPixelsDefault = lua_toboolean(L, 1);
+    return 0;
+}
+
 // Unload one specific image
 static int l_UnloadImage(lua_State* L) {
     Img* img = getPtr<Img>(L, 1);
@@ -151,6 +592,28 @@ static void registerImageClass(lua_State* L) {
         lua_pushcfunction(L, l_GetSize);
         lua_setfield(L, -2, "getSize");
 
+        lua_pushcfunction(L, l_GetPixels);
+        lua_setfield(L, -2, "getPixels");
+
+        lua_pushcfunction(L, l_UpdateImage);
+        lua_setfield(L, -2, "update");
+
+        static luaL_Reg ops[] = {
+            { "resize", l_ImageResize },
+            { "blur", l_ImageBlur },
+            { "colorMatrix", l_ImageColorMatrix },
+            { "tint", l_ImageTint },
+            { "premultiply", l_ImagePremultiply },
+            { "crop", l_ImageCrop },
+            { "blit", l_ImageBlit },
+            { "copy", l_ImageCopy },
+            { "dropPixels", l_ImageDropPixels },
+            { "hasPixels", l_ImageHasPixels },
+            { "isPremultiplied", l_ImageIsPremultiplied },
+            { NULL, NULL }
+        };
+        push_funcs(L, ops);
+
         lua_pushcfunction(L, l_UnloadImage);
         lua_setfield(L, -2, "unload");
 
@@ -165,10 +628,13 @@ static luaL_Reg imgFuncs[] = {
     { "unloadAll", l_UnloadAll },
     { "loadAndResize", l_LoadAndResize },
     { "loadAndScale", l_LoadAndScale },
+    { "fromBuffer", l_ImageFromBuffer },
+    { "setKeepPixels", l_SetKeepPixels },
     { NULL, NULL }
 };
 
 extern "C" void init_raylib_img(lua_State* L) {
     registerImageClass(L);
+    registerBufferClass(L);
     newModule("Image", imgFuncs, L);
 }
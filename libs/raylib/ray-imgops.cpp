@@ -0,0 +1,269 @@
+// ray-imgops.cpp - CPU pixel kernels for Img (ray-img.cpp binds them to Lua)
+// Every kernel works on RGBA8 images (imgopsEnsureRGBA converts), splits its
+// rows across threads with parallelFor and uses SSE2 for the per pixel float
+// math when it's available. Nothing here touches the GPU: ray-img.cpp tracks
+// what changed and uploads it on img:update().
+#pragma once
+#include <raylib.h>
+#include "ray-parallel.cpp" // parallelFor
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#define IMGOPS_MIN_ROWS 32 // rows per thread before a kernel goes parallel
+
+enum ImgopsFilter { IMGOPS_NEAREST, IMGOPS_BILINEAR, IMGOPS_BOX };
+
+static const char* const imgopsFilterNames[] = { "nearest", "bilinear", "box", NULL };
+
+static void imgopsEnsureRGBA(Image* image) {
+    if (image->format != PIXELFORMAT_UNCOMPRESSED_R8G8B8A8)
+        ImageFormat(image, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+}
+
+// A new RGBA8 image with MemAlloc'd pixels, so UnloadImage can free it
+static Image imgopsAlloc(int width, int height) {
+    Image image = { MemAlloc((unsigned int)width * height * 4), width, height, 1, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 };
+    return image;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Resize
+// ─────────────────────────────────────────────────────────────────────────────
+
+// Returns a resized copy of src. Box averages every source pixel under the
+// destination pixel, which is what thumbnails want; bilinear is for upscaling
+// and small changes.
+static Image imgopsResize(const Image& src, int width, int height, int filter) {
+    Image dst = imgopsAlloc(width, height);
+    if (!dst.data) return dst;
+    const uint8_t* s = (const uint8_t*)src.data;
+    uint8_t* d = (uint8_t*)dst.data;
+    int sw = src.width, sh = src.height;
+    float scaleX = (float)sw / width, scaleY = (float)sh / height;
+
+    parallelFor(height, IMGOPS_MIN_ROWS, [&](int begin, int end) {
+        for (int y = begin; y < end; y++) {
+            uint8_t* out = d + (size_t)y * width * 4;
+            if (filter == IMGOPS_NEAREST) {
+                int sy = std::min((int)(y * scaleY), sh - 1);
+                for (int x = 0; x < width; x++) {
+                    int sx = std::min((int)(x * scaleX), sw - 1);
+                    memcpy(out + x * 4, s + ((size_t)sy * sw + sx) * 4, 4);
+                }
+            } else if (filter == IMGOPS_BILINEAR) {
+                float fy = std::max((y + 0.5f) * scaleY - 0.5f, 0.0f);
+                int y0 = std::min((int)fy, sh - 1), y1 = std::min(y0 + 1, sh - 1);
+                float ty = fy - y0;
+                for (int x = 0; x < width; x++) {
+                    float fx = std::max((x + 0.5f) * scaleX - 0.5f, 0.0f);
+                    int x0 = std::min((int)fx, sw - 1), x1 = std::min(x0 + 1, sw - 1);
+                    float tx = fx - x0;
+                    const uint8_t* p00 = s + ((size_t)y0 * sw + x0) * 4;
+                    const uint8_t* p10 = s + ((size_t)y0 * sw + x1) * 4;
+                    const uint8_t* p01 = s + ((size_t)y1 * sw + x0) * 4;
+                    const uint8_t* p11 = s + ((size_t)y1 * sw + x1) * 4;
+                    for (int c = 0; c < 4; c++) {
+                        float top = p00[c] + (p10[c] - p00[c]) * tx;
+                        float bottom = p01[c] + (p11[c] - p01[c]) * tx;
+                        out[x * 4 + c] = (uint8_t)(top + (bottom - top) * ty + 0.5f);
+                    }
+                }
+            } else {
+                int sy0 = (int)(y * scaleY);
+                int sy1 = std::max(sy0 + 1, std::min((int)std::ceil((y + 1) * scaleY), sh));
+                for (int x = 0; x < width; x++) {
+                    int sx0 = (int)(x * scaleX);
+                    int sx1 = std::max(sx0 + 1, std::min((int)std::ceil((x + 1) * scaleX), sw));
+                    uint32_t sum[4] = { 0, 0, 0, 0 };
+                    for (int sy = sy0; sy < sy1; sy++) {
+                        const uint8_t* row = s + ((size_t)sy * sw + sx0) * 4;
+                        for (int sx = sx0; sx < sx1; sx++, row += 4)
+                            for (int c = 0; c < 4; c++) sum[c] += row[c];
+                    }
+                    uint32_t n = (uint32_t)(sy1 - sy0) * (sx1 - sx0);
+                    for (int c = 0; c < 4; c++) out[x * 4 + c] = (uint8_t)((sum[c] + n / 2) / n);
+                }
+            }
+        }
+    });
+    return dst;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Blur
+// ─────────────────────────────────────────────────────────────────────────────
+
+// One box blur pass along a line of n pixels, stride apart, using a running
+// sum so the cost does not depend on the radius. Edges are clamped.
+static void imgopsBoxLine(const uint8_t* in, uint8_t* out, int n, size_t stride, int radius) {
+    int sum[4] = { 0, 0, 0, 0 };
+    int window = radius * 2 + 1;
+    for (int i = -radius; i <= radius; i++) {
+        const uint8_t* p = in + std::min(std::max(i, 0), n - 1) * stride;
+        for (int c = 0; c < 4; c++) sum[c] += p[c];
+    }
+    for (int i = 0; i < n; i++) {
+        uint8_t* o = out + i * stride;
+        for (int c = 0; c < 4; c++) o[c] = (uint8_t)((sum[c] + window / 2) / window);
+        const uint8_t* add = in + std::min(i + radius + 1, n - 1) * stride;
+        const uint8_t* sub = in + std::max(i - radius, 0) * stride;
+        for (int c = 0; c < 4; c++) sum[c] += add[c] - sub[c];
+    }
+}
+
+// Box blur of the given radius, repeated `passes` times (3 passes is close to
+// a gaussian). Rows and columns each run in parallel.
+static void imgopsBlur(Image* image, int radius, int passes) {
+    int w = image->width, h = image->height;
+    uint8_t* px = (uint8_t*)image->data;
+    std::vector<uint8_t> tmp((size_t)w * h * 4);
+
+    for (int pass = 0; pass < passes; pass++) {
+        parallelFor(h, IMGOPS_MIN_ROWS, [&](int begin, int end) {
+            for (int y = begin; y < end; y++)
+                imgopsBoxLine(px + (size_t)y * w * 4, tmp.data() + (size_t)y * w * 4, w, 4, radius);
+        });
+        parallelFor(w, IMGOPS_MIN_ROWS, [&](int begin, int end) {
+            for (int x = begin; x < end; x++)
+                imgopsBoxLine(tmp.data() + x * 4, px + x * 4, h, (size_t)w * 4, radius);
+        });
+    }
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Color
+// ─────────────────────────────────────────────────────────────────────────────
+
+// Applies a 4x5 row major color matrix: out.r = m[0]*r + m[1]*g + m[2]*b +
+// m[3]*a + m[4], and so on for g, b and a, with channels and offsets in 0-255
+static void imgopsColorMatrix(Image* image, const float m[20]) {
+    uint8_t* px = (uint8_t*)image->data;
+    int w = image->width;
+
+    parallelFor(image->height, IMGOPS_MIN_ROWS, [&](int begin, int end) {
+        uint8_t* p = px + (size_t)begin * w * 4;
+        uint8_t* stop = px + (size_t)end * w * 4;
+#ifdef __SSE2__
+        // one pixel per step: the four channels are the four lanes, each
+        // column of the matrix scales one input channel
+        __m128 col[5];
+        for (int k = 0; k < 5; k++) col[k] = _mm_setr_ps(m[k], m[5 + k], m[10 + k], m[15 + k]);
+        __m128i zero = _mm_setzero_si128();
+        for (; p < stop; p += 4) {
+            __m128i in = _mm_cvtsi32_si128(*(const int*)p);
+            __m128 v = _mm_cvtepi32_ps(_mm_unpacklo_epi16(_mm_unpacklo_epi8(in, zero), zero));
+            __m128 r = _mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 0, 0, 0));
+            __m128 g = _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1));
+            __m128 b = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2));
+            __m128 a = _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3));
+            __m128 out = _mm_add_ps(_mm_add_ps(_mm_mul_ps(col[0], r), _mm_mul_ps(col[1], g)),
+                                    _mm_add_ps(_mm_add_ps(_mm_mul_ps(col[2], b), _mm_mul_ps(col[3], a)), col[4]));
+            __m128i q = _mm_cvtps_epi32(out); // saturated to 0-255 by the packs below
+            q = _mm_packs_epi32(q, q);
+            *(int*)p = _mm_cvtsi128_si32(_mm_packus_epi16(q, q));
+        }
+#else
+        for (; p < stop; p += 4) {
+            float in[4] = { (float)p[0], (float)p[1], (float)p[2], (float)p[3] };
+            for (int c = 0; c < 4; c++) {
+                const float* row = m + c * 5;
+                float v = row[0] * in[0] + row[1] * in[1] + row[2] * in[2] + row[3] * in[3] + row[4];
+                p[c] = (uint8_t)std::min(std::max(v + 0.5f, 0.0f), 255.0f);
+            }
+        }
+#endif
+    });
+}
+
+// Multiplies the color channels by alpha, for drawing with BLEND_ALPHA_PREMULTIPLY
+static void imgopsPremultiply(Image* image) {
+    uint8_t* px = (uint8_t*)image->data;
+    int w = image->width;
+    parallelFor(image->height, IMGOPS_MIN_ROWS, [&](int begin, int end) {
+        uint8_t* stop = px + (size_t)end * w * 4;
+        for (uint8_t* p = px + (size_t)begin * w * 4; p < stop; p += 4) {
+            unsigned a = p[3];
+            for (int c = 0; c < 3; c++) p[c] = (uint8_t)((p[c] * a + 127) / 255);
+        }
+    });
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Crop and blit
+// ─────────────────────────────────────────────────────────────────────────────
+
+// Clips the rectangle (x, y, w, h) against a width x height image, false when
+// nothing is left
+static bool imgopsClip(int* x, int* y, int* w, int* h, int width, int height) {
+    if (*x < 0) { *w += *x; *x = 0; }
+    if (*y < 0) { *h += *y; *y = 0; }
+    *w = std::min(*w, width - *x);
+    *h = std::min(*h, height - *y);
+    return *w > 0 && *h > 0;
+}
+
+// Returns the (already clipped) region of src as a new image
+static Image imgopsCrop(const Image& src, int x, int y, int w, int h) {
+    Image dst = imgopsAlloc(w, h);
+    if (!dst.data) return dst;
+    for (int row = 0; row < h; row++)
+        memcpy((uint8_t*)dst.data + (size_t)row * w * 4,
+               (const uint8_t*)src.data + ((size_t)(y + row) * src.width + x) * 4, (size_t)w * 4);
+    return dst;
+}
+
+// Draws the (sx, sy, w, h) region of src at (dx, dy) in dst, alpha blended
+// when blend is set, copied otherwise. Clips against both images and writes
+// the destination rectangle it touched to out (w or h is 0 when none).
+static void imgopsBlit(Image* dst, const Image& src, int sx, int sy, int w, int h, int dx, int dy, bool blend, int out[4]) {
+    out[0] = out[1] = out[2] = out[3] = 0;
+    if (sx < 0) { w += sx; dx -= sx; sx = 0; }
+    if (sy < 0) { h += sy; dy -= sy; sy = 0; }
+    if (dx < 0) { w += dx; sx -= dx; dx = 0; }
+    if (dy < 0) { h += dy; sy -= dy; dy = 0; }
+    w = std::min({ w, src.width - sx, dst->width - dx });
+    h = std::min({ h, src.height - sy, dst->height - dy });
+    if (w <= 0 || h <= 0) return;
+
+    if (dst->data == src.data) {
+        // blitting an image onto itself: the regions may overlap, so read
+        // from a copy of the source region
+        Image copy = imgopsCrop(src, sx, sy, w, h);
+        if (copy.data) imgopsBlit(dst, copy, 0, 0, w, h, dx, dy, blend, out);
+        UnloadImage(copy);
+        return;
+    }
+
+    uint8_t* d = (uint8_t*)dst->data;
+    const uint8_t* s = (const uint8_t*)src.data;
+    parallelFor(h, IMGOPS_MIN_ROWS, [&](int begin, int end) {
+        for (int row = begin; row < end; row++) {
+            uint8_t* o = d + ((size_t)(dy + row) * dst->width + dx) * 4;
+            const uint8_t* in = s + ((size_t)(sy + row) * src.width + sx) * 4;
+            if (!blend) {
+                memcpy(o, in, (size_t)w * 4);
+                continue;
+            }
+            for (int x = 0; x < w; x++, o += 4, in += 4) {
+                unsigned sa = in[3];
+                if (sa == 255) { memcpy(o, in, 4); continue; }
+                if (sa == 0) continue;
+                // straight alpha "over": a = sa + da*(1-sa), c = (sc*sa + dc*da*(1-sa)) / a
+                unsigned da = o[3] * (255 - sa) / 255;
+                unsigned a = sa + da;
+                for (int c = 0; c < 3; c++) o[c] = (uint8_t)((in[c] * sa + o[c] * da + a / 2) / a);
+                o[3] = (uint8_t)a;
+            }
+        }
+    });
+    out[0] = dx;
+    out[1] = dy;
+    out[2] = w;
+    out[3] = h;
+}
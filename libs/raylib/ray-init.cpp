@@ -1,10 +1,15 @@
 #include <lua.h>
 #include <lua.hpp>
 #include "ray-color.cpp"
+#include "ray-frame.cpp"
+#include "ray-headless.cpp"
+#include "ray-font.cpp"
+#include "ray-async.cpp"
 #include "../../../libs/lua_ffi.hpp"
 #include <raylib.h>
 #include <vector>
 #include <cstring>
+#include <algorithm>
 
 static int lua_is_key_down(lua_State *L) {
   int key = lua_tonumber(L, 1);
@@ -81,10 +86,17 @@ static int lua_draw_rectangle_rect(lua_State *L) {
   return 0;
 };
 
+// MeasureText with the default font, through its layout cache (ray-font.cpp)
 static int lua_measure_text(lua_State *L) {
-  const char *text = luaL_checkstring(L, 1);
-  int fontSize = lua_tonumber(L, 2);
-  lua_pushinteger(L, MeasureText(text, fontSize));
+  size_t len;
+  const char *text = luaL_checklstring(L, 1, &len);
+  int fontSize = std::max((int)lua_tonumber(L, 2), 10); // same minimum as raylib
+  FontFace *face = defaultFontFace();
+  if (!face->font.texture.id) {
+    lua_pushinteger(L, 0);
+    return 1;
+  }
+  lua_pushinteger(L, (int)fontLayout(face, text, len, fontSize).width);
   return 1;
 }
 
@@ -96,13 +108,18 @@ static int lua_create_window(lua_State *L) {
   #ifdef no_debug
   SetTraceLogLevel(LOG_NONE);
   #endif
-  InitWindow(width, height, title);
+  if (headlessEnabled())
+    headlessInitWindow(width, height, title);
+  else
+    InitWindow(width, height, title);
   return 0; // No return values
 }
 
 // Wrapper function to close the window
 static int lua_close_window(lua_State *L) {
+  headlessCloseWindow();
   CloseWindow();
+  fontCloseWindow();
   return 0; // No return values
 }
 
@@ -117,13 +134,18 @@ static int lua_fill_bg(lua_State *L) {
 
 // Wrapper function to begin drawing
 static int lua_start_drawing(lua_State *L) {
+  frameBegin();
   BeginDrawing();
+  headlessBeginFrame();
   return 0;
 }
 
 // Wrapper function to end drawing
 static int lua_stop_drawing(lua_State *L) {
-  EndDrawing();
+  std::string asyncError = asyncTick(L); // tasks resumed here can still draw this frame
+  headlessEndFrame();
+  frameEnd(L); // calls EndDrawing, recording timings when FrameStats is enabled
+  if (!asyncError.empty()) return luaL_error(L, "%s", asyncError.c_str());
   return 0;
 }
 
@@ -134,21 +156,22 @@ static int change_title(lua_State *L){
 
 
 static int lua_should_close_window(lua_State *L) {
-  lua_pushboolean(L, WindowShouldClose());
+  lua_pushboolean(L, WindowShouldClose() || headlessShouldClose());
   return 1;
 }
 
-// Wrapper function to draw text
+// Wrapper function to draw text, same output as DrawText but the layout is cached
 static int lua_draw_text(lua_State *L) {
-  const char *text = luaL_checkstring(L, 1);
+  size_t len;
+  const char *text = luaL_checklstring(L, 1, &len);
   int posX = lua_tonumber(L, 2);
   int posY = lua_tonumber(L, 3);
-  int fontSize = lua_tonumber(L, 4);
+  int fontSize = std::max((int)lua_tonumber(L, 4), 10); // same minimum as raylib
 
   Color color;
   color = lua_getColor(L, 5);
 
-  DrawText(text, posX, posY, fontSize, color);
+  fontDrawText(defaultFontFace(), text, len, posX, posY, fontSize, color);
 
   return 0;
 }
@@ -0,0 +1,51 @@
+// ray-pack.cpp - reads raylib's files through the mounted packs (pack.hpp)
+// raylib's loaders (LoadImage, LoadSound, LoadFileData for fonts, models...)
+// all read files through LoadFileData, so one callback makes every asset
+// loadable from a pack. Paths not in any pack are read from disk as usual.
+// Music streams are the exception: LoadMusicStream opens the file itself and
+// never calls LoadFileData, so music has to stay on disk.
+#pragma once
+#include <lua.hpp>
+#include <raylib.h>
+#include "../pack/pack.hpp" // packInit, packRead, pushPackModule
+#include <cstdio>
+#include <cstring>
+
+// LoadFileData callback: the mounted packs first, then the disk. raylib frees
+// the result with UnloadFileData, so it's always a MemAlloc'd copy.
+static unsigned char* packLoadFileData(const char* fileName, int* dataSize) {
+    *dataSize = 0;
+    PackData packed;
+    if (packRead(fileName, &packed)) {
+        unsigned char* data = (unsigned char*)MemAlloc((unsigned int)packed.size);
+        if (!data) return nullptr;
+        memcpy(data, packed.data, packed.size);
+        *dataSize = (int)packed.size;
+        return data;
+    }
+
+    FILE* file = fopen(fileName, "rb");
+    if (!file) {
+        TraceLog(LOG_WARNING, "FILEIO: [%s] Failed to open file", fileName);
+        return nullptr;
+    }
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    unsigned char* data = size > 0 ? (unsigned char*)MemAlloc((unsigned int)size) : nullptr;
+    if (data && fread(data, 1, size, file) == (size_t)size) {
+        *dataSize = (int)size;
+    } else {
+        MemFree(data);
+        data = nullptr;
+        TraceLog(LOG_WARNING, "FILEIO: [%s] Failed to read file", fileName);
+    }
+    fclose(file);
+    return data;
+}
+
+extern "C" void init_raylib_pack(lua_State* L) {
+    pushPackModule(L);
+    lua_setglobal(L, "Pack");
+    SetLoadFileDataCallback(packLoadFileData);
+}
@@ -0,0 +1,28 @@
+// ray-parallel.cpp - parallelFor: splits a loop across the hardware threads
+// for the CPU kernels (image ops, particles). Threads are started per call,
+// so it only pays off for loops that run for a good fraction of a millisecond;
+// smaller loops stay on the calling thread.
+#pragma once
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+// Calls fn(begin, end) on disjoint ranges covering [0, count). Ranges hold at
+// least minPerThread items, the calling thread runs the first one.
+template <typename F>
+static void parallelFor(int count, int minPerThread, F fn) {
+    int hw = std::max(1, (int)std::thread::hardware_concurrency());
+    int threads = std::min(hw, count / std::max(minPerThread, 1));
+    if (threads <= 1) {
+        if (count > 0) fn(0, count);
+        return;
+    }
+
+    int chunk = (count + threads - 1) / threads;
+    std::vector<std::thread> workers;
+    workers.reserve(threads - 1);
+    for (int begin = chunk; begin < count; begin += chunk)
+        workers.emplace_back(fn, begin, std::min(count, begin + chunk));
+    fn(0, chunk);
+    for (std::thread& t : workers) t.join();
+}
@@ -0,0 +1,455 @@
+// ray-particles.cpp - Particles: native particle systems configured from Lua
+// Particles live in C as structure of arrays (one float array per field), so
+// the update is a straight loop over memory: four particles per step with
+// SSE, split across threads with parallelFor once a system is big enough.
+// Drawing emits one textured quad per particle into rlgl's render batch, so
+// a whole system costs one Lua call and a handful of draw calls.
+//
+//   local sparks = Particles.new({ rate = 2000, life = {0.5, 1}, speed = {50, 200},
+//                                  angle = -90, spread = 60, gravity = {0, 300},
+//                                  size = {6, 0}, colorStart = YELLOW, colorEnd = RED,
+//                                  blend = "additive" })
+//   sparks:setPosition(x, y)
+//   sparks:update(dt)
+//   sparks:draw()
+#pragma once
+#include <lua.hpp>
+#include <raylib.h>
+#include <rlgl.h>
+#include "../../../libs/lua_ffi.hpp" // pushPtr, getPtr
+#include "ray-color.cpp"             // lua_getColor
+#include "ray-parallel.cpp"          // parallelFor
+// Img (ray-img.cpp) comes from raylib.cpp
+#include <algorithm>                 // std::remove
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
+
+#define PARTICLES_CAPACITY_DEFAULT 10000
+#define PARTICLES_MIN_PER_THREAD 16384 // particles per thread before an update goes parallel
+#define PARTICLES_DOT_SIZE 32          // default texture, a soft round dot
+
+// Emitter descriptor, everything Particles.new/configure can set
+struct ParticleConfig {
+    float rate;              // particles per second while emitting
+    float lifeMin, lifeMax;  // seconds
+    float speedMin, speedMax;
+    float angle, spread;     // direction and cone width, radians
+    float radius;            // spawn inside a disc around the position
+    float gravityX, gravityY;
+    float drag;              // fraction of velocity lost per second
+    float sizeStart, sizeEnd;
+    Color colorStart, colorEnd;
+    int blend;               // BLEND_ALPHA or BLEND_ADDITIVE
+    Img* image;              // NULL for the default dot, its texture is read at draw time
+    bool threads;            // allow parallel updates
+};
+
+struct ParticleSystem {
+    ParticleConfig config;
+    float x, y;          // emitter position
+    bool emitting;
+    float emitCarry;     // fraction of a particle owed by the last update
+    uint32_t rng;
+    int count, capacity;
+    // one entry per particle, padded to a multiple of 4 for the SIMD loop
+    std::vector<float> px, py, vx, vy, age, invLife;
+};
+
+static std::vector<ParticleSystem*> particlePool;
+static Texture2D particleDot = { 0 };
+
+static float particleRandom(ParticleSystem* ps) {
+    // xorshift32, plenty for particles
+    uint32_t s = ps->rng;
+    s ^= s << 13;
+    s ^= s >> 17;
+    s ^= s << 5;
+    ps->rng = s;
+    return (s >> 8) * (1.0f / 16777216.0f);
+}
+
+static void particlesResize(ParticleSystem* ps, int capacity) {
+    ps->capacity = std::max(capacity, 1);
+    size_t padded = (ps->capacity + 3) & ~3;
+    for (std::vector<float>* v : { &ps->px, &ps->py, &ps->vx, &ps->vy, &ps->age, &ps->invLife })
+        v->resize(padded, 0.0f);
+    ps->count = std::min(ps->count, ps->capacity);
+}
+
+// Spawns up to n particles at (x, y), fewer when the system is full
+static void particlesEmit(ParticleSystem* ps, int n, float x, float y) {
+    const ParticleConfig& c = ps->config;
+    n = std::min(n, ps->capacity - ps->count);
+    for (int k = 0; k < n; k++) {
+        int i = ps->count++;
+        float r = c.radius * std::sqrt(particleRandom(ps));
+        float a = particleRandom(ps) * 2.0f * PI;
+        ps->px[i] = x + r * std::cos(a);
+        ps->py[i] = y + r * std::sin(a);
+
+        float dir = c.angle + (particleRandom(ps) - 0.5f) * c.spread;
+        float speed = c.speedMin + (c.speedMax - c.speedMin) * particleRandom(ps);
+        ps->vx[i] = std::cos(dir) * speed;
+        ps->vy[i] = std::sin(dir) * speed;
+
+        float life = c.lifeMin + (c.lifeMax - c.lifeMin) * particleRandom(ps);
+        ps->age[i] = 0.0f;
+        ps->invLife[i] = 1.0f / std::max(life, 0.001f);
+    }
+}
+
+// Integrates particles [begin, end), begin a multiple of 4
+static void particlesIntegrate(ParticleSystem* ps, int begin, int end, float dt, float damp) {
+    float gx = ps->config.gravityX * dt, gy = ps->config.gravityY * dt;
+    float* px = ps->px.data();
+    float* py = ps->py.data();
+    float* vx = ps->vx.data();
+    float* vy = ps->vy.data();
+    float* age = ps->age.data();
+    int i = begin;
+#ifdef __SSE__
+    __m128 vdt = _mm_set1_ps(dt), vdamp = _mm_set1_ps(damp);
+    __m128 vgx = _mm_set1_ps(gx), vgy = _mm_set1_ps(gy);
+    // the arrays are padded, so the last group may run past end safely
+    for (; i < end; i += 4) {
+        __m128 nvx = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(vx + i), vgx), vdamp);
+        __m128 nvy = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(vy + i), vgy), vdamp);
+        _mm_storeu_ps(vx + i, nvx);
+        _mm_storeu_ps(vy + i, nvy);
+        _mm_storeu_ps(px + i, _mm_add_ps(_mm_loadu_ps(px + i), _mm_mul_ps(nvx, vdt)));
+        _mm_storeu_ps(py + i, _mm_add_ps(_mm_loadu_ps(py + i), _mm_mul_ps(nvy, vdt)));
+        _mm_storeu_ps(age + i, _mm_add_ps(_mm_loadu_ps(age + i), vdt));
+    }
+#else
+    for (; i < end; i++) {
+        vx[i] = (vx[i] + gx) * damp;
+        vy[i] = (vy[i] + gy) * damp;
+        px[i] += vx[i] * dt;
+        py[i] += vy[i] * dt;
+        age[i] += dt;
+    }
+#endif
+}
+
+// Removes dead particles by moving the last live one into their slot
+static void particlesCompact(ParticleSystem* ps) {
+    int i = 0;
+    while (i < ps->count) {
+        if (ps->age[i] * ps->invLife[i] < 1.0f) {
+            i++;
+            continue;
+        }
+        int last = --ps->count;
+        ps->px[i] = ps->px[last];
+        ps->py[i] = ps->py[last];
+        ps->vx[i] = ps->vx[last];
+        ps->vy[i] = ps->vy[last];
+        ps->age[i] = ps->age[last];
+        ps->invLife[i] = ps->invLife[last];
+    }
+}
+
+static void particlesUpdate(ParticleSystem* ps, float dt) {
+    if (dt <= 0) return;
+    float damp = 1.0f / (1.0f + ps->config.drag * dt);
+
+    int groups = (ps->count + 3) / 4;
+    int minGroups = ps->config.threads ? PARTICLES_MIN_PER_THREAD / 4 : groups + 1;
+    parallelFor(groups, minGroups, [&](int begin, int end) {
+        particlesIntegrate(ps, begin * 4, std::min(end * 4, ps->count), dt, damp);
+    });
+    particlesCompact(ps);
+
+    if (ps->emitting && ps->config.rate > 0) {
+        ps->emitCarry += ps->config.rate * dt;
+        int n = (int)ps->emitCarry;
+        ps->emitCarry -= n;
+        particlesEmit(ps, n, ps->x, ps->y);
+    }
+}
+
+// A soft white dot, alpha falling off towards the edge
+static Texture2D particlesDefaultTexture() {
+    if (particleDot.id) return particleDot;
+    int n = PARTICLES_DOT_SIZE;
+    Image img = { MemAlloc(n * n * 4), n, n, 1, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 };
+    unsigned char* p = (unsigned char*)img.data;
+    for (int y = 0; y < n; y++) {
+        for (int x = 0; x < n; x++, p += 4) {
+            float dx = (x + 0.5f) / n * 2.0f - 1.0f, dy = (y + 0.5f) / n * 2.0f - 1.0f;
+            float a = std::max(0.0f, 1.0f - std::sqrt(dx * dx + dy * dy));
+            p[0] = p[1] = p[2] = 255;
+            p[3] = (unsigned char)(a * a * 255.0f);
+        }
+    }
+    particleDot = LoadTextureFromImage(img);
+    UnloadImage(img);
+    return particleDot;
+}
+
+static void particlesDraw(ParticleSystem* ps) {
+    if (!ps->count) return;
+    const ParticleConfig& c = ps->config;
+    const Img* image = imgAlive(c.image) ? c.image : nullptr;
+    Texture2D tex = image ? image->texture : particlesDefaultTexture();
+    float s0 = c.sizeStart, ds = c.sizeEnd - c.sizeStart;
+    Color c0 = c.colorStart, c1 = c.colorEnd;
+    int blend = imgBlendMode(image, c.blend);
+
+    if (blend != BLEND_ALPHA) BeginBlendMode(blend);
+    rlSetTexture(tex.id);
+    rlBegin(RL_QUADS);
+    for (int i = 0; i < ps->count; i++) {
+        float t = std::min(ps->age[i] * ps->invLife[i], 1.0f);
+        float h = (s0 + ds * t) * 0.5f;
+        float x = ps->px[i], y = ps->py[i];
+
+        rlCheckRenderBatchLimit(4); // flushes and restores the mode/texture if full
+        Color col = imgTint(image, Color{ (unsigned char)(c0.r + (c1.r - c0.r) * t), (unsigned char)(c0.g + (c1.g - c0.g) * t),
+                                          (unsigned char)(c0.b + (c1.b - c0.b) * t), (unsigned char)(c0.a + (c1.a - c0.a) * t) });
+        rlColor4ub(col.r, col.g, col.b, col.a);
+        rlTexCoord2f(0.0f, 0.0f); rlVertex2f(x - h, y - h);
+        rlTexCoord2f(0.0f, 1.0f); rlVertex2f(x - h, y + h);
+        rlTexCoord2f(1.0f, 1.0f); rlVertex2f(x + h, y + h);
+        rlTexCoord2f(1.0f, 0.0f); rlVertex2f(x + h, y - h);
+    }
+    rlEnd();
+    rlSetTexture(0);
+    if (blend != BLEND_ALPHA) EndBlendMode();
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Descriptor parsing
+// ─────────────────────────────────────────────────────────────────────────────
+
+static float particleField(lua_State* L, int idx, const char* name, float def) {
+    lua_getfield(L, idx, name);
+    float v = luaL_optnumber(L, -1, def);
+    lua_pop(L, 1);
+    return v;
+}
+
+// desc[name] as {min, max} or a single number for both
+static void particleRange(lua_State* L, int idx, const char* name, float* lo, float* hi) {
+    lua_getfield(L, idx, name);
+    if (lua_istable(L, -1)) {
+        lua_rawgeti(L, -1, 1);
+        lua_rawgeti(L, -2, 2);
+        *lo = luaL_optnumber(L, -2, *lo);
+        *hi = luaL_optnumber(L, -1, *lo);
+        lua_pop(L, 2);
+    } else if (lua_isnumber(L, -1)) {
+        *lo = *hi = lua_tonumber(L, -1);
+    }
+    lua_pop(L, 1);
+}
+
+static void particleColor(lua_State* L, int idx, const char* name, Color* out) {
+    lua_getfield(L, idx, name);
+    if (lua_istable(L, -1)) *out = lua_getColor(L, lua_gettop(L));
+    lua_pop(L, 1);
+}
+
+// Reads every field present in the descriptor table at idx into c, fields
+// left out keep their value. Angles are in degrees.
+static void particleReadConfig(lua_State* L, int idx, ParticleConfig* c) {
+    c->rate = particleField(L, idx, "rate", c->rate);
+    particleRange(L, idx, "life", &c->lifeMin, &c->lifeMax);
+    particleRange(L, idx, "speed", &c->speedMin, &c->speedMax);
+    c->angle = particleField(L, idx, "angle", c->angle * RAD2DEG) * DEG2RAD;
+    c->spread = particleField(L, idx, "spread", c->spread * RAD2DEG) * DEG2RAD;
+    c->radius = particleField(L, idx, "radius", c->radius);
+    lua_getfield(L, idx, "gravity");
+    if (lua_istable(L, -1)) {
+        lua_rawgeti(L, -1, 1);
+        lua_rawgeti(L, -2, 2);
+        c->gravityX = luaL_optnumber(L, -2, 0);
+        c->gravityY = luaL_optnumber(L, -1, 0);
+        lua_pop(L, 2);
+    }
+    lua_pop(L, 1);
+    c->drag = particleField(L, idx, "drag", c->drag);
+    particleRange(L, idx, "size", &c->sizeStart, &c->sizeEnd);
+    particleColor(L, idx, "colorStart", &c->colorStart);
+    particleColor(L, idx, "colorEnd", &c->colorEnd);
+
+    lua_getfield(L, idx, "blend");
+    if (lua_isstring(L, -1)) {
+        static const char* const blendNames[] = { "alpha", "additive", NULL };
+        static const int blendModes[] = { BLEND_ALPHA, BLEND_ADDITIVE };
+        c->blend = blendModes[luaL_checkoption(L, lua_gettop(L), NULL, blendNames)];
+    }
+    lua_getfield(L, idx, "texture");
+    if (!lua_isnil(L, -1)) c->image = lua_toboolean(L, -1) ? getPtr<Img>(L, lua_gettop(L)) : nullptr;
+    lua_getfield(L, idx, "threads");
+    if (!lua_isnil(L, -1)) c->threads = lua_toboolean(L, -1);
+    lua_pop(L, 3);
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Lua API
+// ─────────────────────────────────────────────────────────────────────────────
+
+// Particles.new([desc]) -> system
+// desc = { capacity = 10000, rate = 0, life = {min, max}, speed = {min, max},
+//          angle = 0, spread = 360, radius = 0, gravity = {x, y}, drag = 0,
+//          size = {start, end}, colorStart = WHITE, colorEnd = WHITE,
+//          blend = "alpha" | "additive", texture = img, threads = true }
+static int l_ParticlesNew(lua_State* L) {
+    ParticleSystem* ps = new ParticleSystem();
+    ParticleConfig& c = ps->config;
+    c.lifeMin = c.lifeMax = 1.0f;
+    c.speedMin = c.speedMax = 50.0f;
+    c.spread = 2.0f * PI;
+    c.sizeStart = c.sizeEnd = 4.0f;
+    c.colorStart = c.colorEnd = WHITE;
+    c.blend = BLEND_ALPHA;
+    c.threads = true;
+    ps->emitting = true;
+    ps->rng = (0x9E3779B9u ^ (uint32_t)(uintptr_t)ps) | 1; // xorshift must not start at 0
+
+    int capacity = PARTICLES_CAPACITY_DEFAULT;
+    if (lua_istable(L, 1)) {
+        particleReadConfig(L, 1, &c);
+        capacity = (int)particleField(L, 1, "capacity", capacity);
+    }
+    particlesResize(ps, capacity);
+    particlePool.push_back(ps);
+    pushPtr(L, ps); // Pushed as userdata, no __gc
+    return 1;
+}
+
+// system:configure(desc) - changes the given fields, capacity included
+static int l_ParticlesConfigure(lua_State* L) {
+    ParticleSystem* ps = getPtr<ParticleSystem>(L, 1);
+    luaL_checktype(L, 2, LUA_TTABLE);
+    particleReadConfig(L, 2, &ps->config);
+    lua_getfield(L, 2, "capacity");
+    if (lua_isnumber(L, -1)) particlesResize(ps, lua_tointeger(L, -1));
+    lua_pop(L, 1);
+    return 0;
+}
+
+static int l_ParticlesSetPosition(lua_State* L) {
+    ParticleSystem* ps = getPtr<ParticleSystem>(L, 1);
+    ps->x = luaL_checknumber(L, 2);
+    ps->y = luaL_checknumber(L, 3);
+    return 0;
+}
+
+// system:emit(n[, x, y]) - a burst, at the emitter position by default
+static int l_ParticlesEmit(lua_State* L) {
+    ParticleSystem* ps = getPtr<ParticleSystem>(L, 1);
+    int n = luaL_checkinteger(L, 2);
+    float x = luaL_optnumber(L, 3, ps->x);
+    float y = luaL_optnumber(L, 4, ps->y);
+    particlesEmit(ps, n, x, y);
+    return 0;
+}
+
+// system:start() / system:stop() - continuous emission at desc.rate
+static int l_ParticlesStart(lua_State* L) {
+    getPtr<ParticleSystem>(L, 1)->emitting = true;
+    return 0;
+}
+
+static int l_ParticlesStop(lua_State* L) {
+    getPtr<ParticleSystem>(L, 1)->emitting = false;
+    return 0;
+}
+
+// system:update([dt]) - dt defaults to GetFrameTime()
+static int l_ParticlesUpdate(lua_State* L) {
+    particlesUpdate(getPtr<ParticleSystem>(L, 1), luaL_optnumber(L, 2, GetFrameTime()));
+    return 0;
+}
+
+static int l_ParticlesDraw(lua_State* L) {
+    particlesDraw(getPtr<ParticleSystem>(L, 1));
+    return 0;
+}
+
+static int l_ParticlesCount(lua_State* L) {
+    lua_pushinteger(L, getPtr<ParticleSystem>(L, 1)->count);
+    return 1;
+}
+
+static int l_ParticlesClear(lua_State* L) {
+    ParticleSystem* ps = getPtr<ParticleSystem>(L, 1);
+    ps->count = 0;
+    ps->emitCarry = 0;
+    return 0;
+}
+
+static int l_ParticlesUnload(lua_State* L) {
+    ParticleSystem* ps = getPtr<ParticleSystem>(L, 1);
+    if (!ps) return 0;
+    particlePool.erase(std::remove(particlePool.begin(), particlePool.end(), ps), particlePool.end());
+    delete ps;
+    return 0;
+}
+
+// Particles.updateAll([dt]) - every live system, dt defaults to GetFrameTime()
+static int l_ParticlesUpdateAll(lua_State* L) {
+    float dt = luaL_optnumber(L, 1, GetFrameTime());
+    for (ParticleSystem* ps : particlePool) particlesUpdate(ps, dt);
+    return 0;
+}
+
+// Particles.drawAll() - every live system, in creation order
+static int l_ParticlesDrawAll(lua_State* L) {
+    for (ParticleSystem* ps : particlePool) particlesDraw(ps);
+    return 0;
+}
+
+static int l_ParticlesUnloadAll(lua_State* L) {
+    for (ParticleSystem* ps : particlePool) delete ps;
+    particlePool.clear();
+    if (particleDot.id) UnloadTexture(particleDot);
+    particleDot = Texture2D{ 0 };
+    return 0;
+}
+
+// Register ParticleSystem methods (no __gc)
+static void registerParticlesClass(lua_State* L) {
+    const char* type = typeid(ParticleSystem).name();
+    if (luaL_newmetatable(L, type)) {
+        lua_pushstring(L, "__index");
+        lua_newtable(L);
+
+        static luaL_Reg methods[] = {
+            { "configure", l_ParticlesConfigure },
+            { "setPosition", l_ParticlesSetPosition },
+            { "emit", l_ParticlesEmit },
+            { "start", l_ParticlesStart },
+            { "stop", l_ParticlesStop },
+            { "update", l_ParticlesUpdate },
+            { "draw", l_ParticlesDraw },
+            { "count", l_ParticlesCount },
+            { "clear", l_ParticlesClear },
+            { "unload", l_ParticlesUnload },
+            { NULL, NULL }
+        };
+        push_funcs(L, methods);
+
+        lua_settable(L, -3); // metatable.__index = table
+    }
+    lua_pop(L, 1);
+}
+
+static luaL_Reg particlesFuncs[] = {
+    { "new", l_ParticlesNew },
+    { "updateAll", l_ParticlesUpdateAll },
+    { "drawAll", l_ParticlesDrawAll },
+    { "unloadAll", l_ParticlesUnloadAll },
+    { NULL, NULL }
+};
+
+extern "C" void init_raylib_particles(lua_State* L) {
+    registerParticlesClass(L);
+    newModule("Particles", particlesFuncs, L);
+}
@@ -0,0 +1,489 @@
+// ray-scene.cpp - Scene: models, instance buffers and frustum culled instanced drawing
+// Instance transforms live in C (InstanceBuffer), model:drawInstanced(buffer)
+// culls them against the camera frustum and draws the survivors with one
+// DrawMeshInstanced call per mesh, so a scene costs one Lua call per model.
+#pragma once
+#include <lua.hpp>
+#include <raylib.h>
+#include <raymath.h>
+#include "../../../libs/lua_ffi.hpp" // pushPtr, getPtr, getArgByName
+#include "ray-color.cpp"             // lua_getColor
+#include "../buffer.hpp"             // Buffer, testBuffer, checkBufferType
+#include <algorithm>                 // std::remove
+#include <cmath>
+#include <cstring>
+#include <vector>
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
+
+// same clip distances raylib uses in BeginMode3D
+#define SCENE_CULL_NEAR 0.01
+#define SCENE_CULL_FAR 1000.0
+
+struct SceneModel {
+    Model model;
+    Vector3 center; // local bounding sphere, used for culling
+    float radius;
+};
+
+// Instance transforms plus their world space bounding spheres (SoA, padded to 4 for SIMD)
+struct InstanceBuffer {
+    std::vector<Matrix> transforms;
+    std::vector<float> cx, cy, cz, r;
+    Vector3 sphereCenter; // model sphere the spheres were computed for
+    float sphereRadius;
+    bool dirty;
+    std::vector<Matrix> visible; // scratch for the culled list
+};
+
+static std::vector<SceneModel*> sceneModelPool;
+static std::vector<InstanceBuffer*> instanceBufferPool;
+
+static Shader sceneInstancingShader = { 0 };
+
+static const char* sceneInstancingVS =
+    "#version 330\n"
+    "in vec3 vertexPosition;\n"
+    "in vec2 vertexTexCoord;\n"
+    "in vec4 vertexColor;\n"
+    "in mat4 instanceTransform;\n"
+    "uniform mat4 mvp;\n"
+    "out vec2 fragTexCoord;\n"
+    "out vec4 fragColor;\n"
+    "void main() {\n"
+    "    fragTexCoord = vertexTexCoord;\n"
+    "    fragColor = vertexColor;\n"
+    "    gl_Position = mvp*instanceTransform*vec4(vertexPosition, 1.0);\n"
+    "}\n";
+
+static const char* sceneInstancingFS =
+    "#version 330\n"
+    "in vec2 fragTexCoord;\n"
+    "in vec4 fragColor;\n"
+    "uniform sampler2D texture0;\n"
+    "uniform vec4 colDiffuse;\n"
+    "out vec4 finalColor;\n"
+    "void main() {\n"
+    "    finalColor = texture(texture0, fragTexCoord)*colDiffuse*fragColor;\n"
+    "}\n";
+
+// loaded on first use, needs a GL context
+static Shader sceneGetInstancingShader() {
+    if (!sceneInstancingShader.id) {
+        sceneInstancingShader = LoadShaderFromMemory(sceneInstancingVS, sceneInstancingFS);
+        sceneInstancingShader.locs[SHADER_LOC_MATRIX_MVP] = GetShaderLocation(sceneInstancingShader, "mvp");
+        sceneInstancingShader.locs[SHADER_LOC_MATRIX_MODEL] = GetShaderLocationAttrib(sceneInstancingShader, "instanceTransform");
+    }
+    return sceneInstancingShader;
+}
+
+static SceneModel* newSceneModel(Model model) {
+    BoundingBox box = GetModelBoundingBox(model);
+    Vector3 center = {
+        (box.min.x + box.max.x) * 0.5f,
+        (box.min.y + box.max.y) * 0.5f,
+        (box.min.z + box.max.z) * 0.5f
+    };
+    float dx = box.max.x - center.x, dy = box.max.y - center.y, dz = box.max.z - center.z;
+
+    SceneModel* m = new SceneModel{ model, center, std::sqrt(dx * dx + dy * dy + dz * dz) };
+    sceneModelPool.push_back(m);
+    return m;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Frustum culling
+// ─────────────────────────────────────────────────────────────────────────────
+
+struct Frustum {
+    float a[6], b[6], c[6], d[6]; // normalized planes, normals point inwards
+};
+
+static Frustum frustumFromCamera(const Camera3D& cam, float aspect) {
+    Matrix view = GetCameraMatrix(cam);
+    Matrix proj;
+    if (cam.projection == CAMERA_ORTHOGRAPHIC) {
+        double top = cam.fovy / 2.0, right = top * aspect;
+        proj = MatrixOrtho(-right, right, -top, top, SCENE_CULL_NEAR, SCENE_CULL_FAR);
+    } else {
+        proj = MatrixPerspective(cam.fovy * DEG2RAD, aspect, SCENE_CULL_NEAR, SCENE_CULL_FAR);
+    }
+    Matrix m = MatrixMultiply(view, proj); // proj * view
+
+    // Gribb/Hartmann: planes are the last row plus/minus the other rows
+    float rows[4][4] = {
+        { m.m0, m.m4, m.m8, m.m12 },
+        { m.m1, m.m5, m.m9, m.m13 },
+        { m.m2, m.m6, m.m10, m.m14 },
+        { m.m3, m.m7, m.m11, m.m15 },
+    };
+    Frustum f;
+    for (int i = 0; i < 6; i++) {
+        float sign = (i & 1) ? -1.0f : 1.0f;
+        const float* row = rows[i / 2];
+        float p[4];
+        for (int k = 0; k < 4; k++) p[k] = rows[3][k] + sign * row[k];
+        float len = std::sqrt(p[0] * p[0] + p[1] * p[1] + p[2] * p[2]);
+        f.a[i] = p[0] / len;
+        f.b[i] = p[1] / len;
+        f.c[i] = p[2] / len;
+        f.d[i] = p[3] / len;
+    }
+    return f;
+}
+
+// Recomputes the world space spheres if the transforms or the model changed
+static void updateInstanceSpheres(InstanceBuffer* buf, const SceneModel* model) {
+    if (!buf->dirty && buf->sphereRadius == model->radius &&
+        memcmp(&buf->sphereCenter, &model->center, sizeof(Vector3)) == 0)
+        return;
+
+    size_t n = buf->transforms.size();
+    size_t padded = (n + 3) & ~(size_t)3;
+    buf->cx.assign(padded, 0);
+    buf->cy.assign(padded, 0);
+    buf->cz.assign(padded, 0);
+    buf->r.assign(padded, -1); // padding never passes a plane test
+
+    for (size_t i = 0; i < n; i++) {
+        const Matrix& t = buf->transforms[i];
+        Vector3 c = Vector3Transform(model->center, t);
+        float sx = t.m0 * t.m0 + t.m1 * t.m1 + t.m2 * t.m2;
+        float sy = t.m4 * t.m4 + t.m5 * t.m5 + t.m6 * t.m6;
+        float sz = t.m8 * t.m8 + t.m9 * t.m9 + t.m10 * t.m10;
+        buf->cx[i] = c.x;
+        buf->cy[i] = c.y;
+        buf->cz[i] = c.z;
+        buf->r[i] = model->radius * std::sqrt(std::max(sx, std::max(sy, sz)));
+    }
+    buf->sphereCenter = model->center;
+    buf->sphereRadius = model->radius;
+    buf->dirty = false;
+}
+
+// Fills buf->visible with the transforms whose sphere touches the frustum
+static void cullInstances(InstanceBuffer* buf, const Frustum& f) {
+    size_t n = buf->transforms.size();
+    buf->visible.clear();
+
+#ifdef __SSE__
+    // four spheres against one plane per step
+    for (size_t i = 0; i < n; i += 4) {
+        __m128 x = _mm_loadu_ps(&buf->cx[i]);
+        __m128 y = _mm_loadu_ps(&buf->cy[i]);
+        __m128 z = _mm_loadu_ps(&buf->cz[i]);
+        __m128 negR = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(&buf->r[i]));
+        __m128 inside = _mm_cmpge_ps(_mm_loadu_ps(&buf->r[i]), _mm_setzero_ps());
+
+        for (int p = 0; p < 6; p++) {
+            __m128 dist = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(f.a[p])), _mm_mul_ps(y, _mm_set1_ps(f.b[p]))),
+                _mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(f.c[p])), _mm_set1_ps(f.d[p])));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(dist, negR));
+        }
+
+        int mask = _mm_movemask_ps(inside);
+        for (int k = 0; k < 4 && mask; k++, mask >>= 1)
+            if (mask & 1) buf->visible.push_back(buf->transforms[i + k]);
+    }
+#else
+    for (size_t i = 0; i < n; i++) {
+        bool inside = true;
+        for (int p = 0; p < 6 && inside; p++) {
+            float dist = f.a[p] * buf->cx[i] + f.b[p] * buf->cy[i] + f.c[p] * buf->cz[i] + f.d[p];
+            inside = dist >= -buf->r[i];
+        }
+        if (inside) buf->visible.push_back(buf->transforms[i]);
+    }
+#endif
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Models
+// ─────────────────────────────────────────────────────────────────────────────
+
+// Scene.loadModel(path) -> model
+static int l_SceneLoadModel(lua_State* L) {
+    const char* path = luaL_checkstring(L, 1);
+    Model model = LoadModel(path);
+    if (!model.meshCount) {
+        lua_pushnil(L);
+        lua_pushstring(L, "Failed to load model");
+        return 2;
+    }
+    pushPtr(L, newSceneModel(model)); // Pushed as userdata, no __gc
+    return 1;
+}
+
+// Scene.cube(width, height, length) -> model
+static int l_SceneCube(lua_State* L) {
+    float w = luaL_checknumber(L, 1);
+    float h = luaL_optnumber(L, 2, w);
+    float l = luaL_optnumber(L, 3, w);
+    pushPtr(L, newSceneModel(LoadModelFromMesh(GenMeshCube(w, h, l))));
+    return 1;
+}
+
+// Scene.sphere(radius[, rings, slices]) -> model
+static int l_SceneSphere(lua_State* L) {
+    float radius = luaL_checknumber(L, 1);
+    int rings = luaL_optinteger(L, 2, 16);
+    int slices = luaL_optinteger(L, 3, 16);
+    pushPtr(L, newSceneModel(LoadModelFromMesh(GenMeshSphere(radius, rings, slices))));
+    return 1;
+}
+
+// model:draw(position[, scale, tint])
+static int l_SceneModelDraw(lua_State* L) {
+    SceneModel* m = getPtr<SceneModel>(L, 1);
+    Vector3 pos = {
+        (float)getArgByName(L, "x", 2),
+        (float)getArgByName(L, "y", 2),
+        (float)getArgByName(L, "z", 2)
+    };
+    float scale = luaL_optnumber(L, 3, 1.0);
+    Color tint = lua_isnoneornil(L, 4) ? WHITE : lua_getColor(L, 4);
+    DrawModel(m->model, pos, scale, tint);
+    return 0;
+}
+
+// model:drawInstanced(buffer[, camera[, tint]]) -> number of instances drawn
+// must be called inside a 3D mode, culls against the given camera or globalCam3d
+static int l_SceneModelDrawInstanced(lua_State* L) {
+    SceneModel* m = getPtr<SceneModel>(L, 1);
+    InstanceBuffer* buf = getPtr<InstanceBuffer>(L, 2);
+    Camera3D* cam = optCamera3D(L, 3);
+    Color tint = lua_isnoneornil(L, 4) ? WHITE : lua_getColor(L, 4);
+    if (buf->transforms.empty()) {
+        lua_pushinteger(L, 0);
+        return 1;
+    }
+
+    float aspect = (float)GetRenderWidth() / (float)GetRenderHeight();
+    updateInstanceSpheres(buf, m);
+    cullInstances(buf, frustumFromCamera(*cam, aspect));
+
+    if (!buf->visible.empty()) {
+        Shader shader = sceneGetInstancingShader();
+        for (int i = 0; i < m->model.meshCount; i++) {
+            Material mat = m->model.materials[m->model.meshMaterial[i]];
+            mat.shader = shader;
+            Color diffuse = mat.maps[MATERIAL_MAP_DIFFUSE].color;
+            mat.maps[MATERIAL_MAP_DIFFUSE].color = {
+                (unsigned char)(diffuse.r * tint.r / 255), (unsigned char)(diffuse.g * tint.g / 255),
+                (unsigned char)(diffuse.b * tint.b / 255), (unsigned char)(diffuse.a * tint.a / 255)
+            };
+            DrawMeshInstanced(m->model.meshes[i], mat, buf->visible.data(), (int)buf->visible.size());
+            mat.maps[MATERIAL_MAP_DIFFUSE].color = diffuse; // maps are shared with the model
+        }
+    }
+    lua_pushinteger(L, buf->visible.size());
+    return 1;
+}
+
+// model:getBounds() -> { min = {x, y, z}, max = {x, y, z} }
+static int l_SceneModelGetBounds(lua_State* L) {
+    SceneModel* m = getPtr<SceneModel>(L, 1);
+    BoundingBox box = GetModelBoundingBox(m->model);
+    lua_newtable(L);
+    Vector3 corners[2] = { box.min, box.max };
+    const char* names[2] = { "min", "max" };
+    for (int i = 0; i < 2; i++) {
+        lua_newtable(L);
+        lua_pushnumber(L, corners[i].x);
+        lua_setfield(L, -2, "x");
+        lua_pushnumber(L, corners[i].y);
+        lua_setfield(L, -2, "y");
+        lua_pushnumber(L, corners[i].z);
+        lua_setfield(L, -2, "z");
+        lua_setfield(L, -2, names[i]);
+    }
+    return 1;
+}
+
+static int l_SceneModelUnload(lua_State* L) {
+    SceneModel* m = getPtr<SceneModel>(L, 1);
+    if (!m) return 0;
+    UnloadModel(m->model);
+    sceneModelPool.erase(std::remove(sceneModelPool.begin(), sceneModelPool.end(), m), sceneModelPool.end());
+    delete m;
+    return 0;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Instance buffers
+// ─────────────────────────────────────────────────────────────────────────────
+
+static Matrix instanceTransform(float x, float y, float z, float scale, float rotY) {
+    Matrix t = MatrixScale(scale, scale, scale);
+    if (rotY != 0) t = MatrixMultiply(t, MatrixRotateY(rotY * DEG2RAD));
+    return MatrixMultiply(t, MatrixTranslate(x, y, z));
+}
+
+// Scene.newInstances([capacity]) -> buffer
+static int l_SceneNewInstances(lua_State* L) {
+    InstanceBuffer* buf = new InstanceBuffer();
+    buf->transforms.reserve(luaL_optinteger(L, 1, 0));
+    buf->dirty = true;
+    instanceBufferPool.push_back(buf);
+    pushPtr(L, buf); // Pushed as userdata, no __gc
+    return 1;
+}
+
+// buffer:add(x, y, z[, scale, rotationY]) -> index
+static int l_InstancesAdd(lua_State* L) {
+    InstanceBuffer* buf = getPtr<InstanceBuffer>(L, 1);
+    buf->transforms.push_back(instanceTransform(
+        luaL_checknumber(L, 2), luaL_checknumber(L, 3), luaL_checknumber(L, 4),
+        luaL_optnumber(L, 5, 1.0), luaL_optnumber(L, 6, 0.0)));
+    buf->dirty = true;
+    lua_pushinteger(L, buf->transforms.size());
+    return 1;
+}
+
+// buffer:set(index, x, y, z[, scale, rotationY])
+static int l_InstancesSet(lua_State* L) {
+    InstanceBuffer* buf = getPtr<InstanceBuffer>(L, 1);
+    lua_Integer i = luaL_checkinteger(L, 2);
+    luaL_argcheck(L, i >= 1 && i <= (lua_Integer)buf->transforms.size(), 2, "index out of range");
+    buf->transforms[i - 1] = instanceTransform(
+        luaL_checknumber(L, 3), luaL_checknumber(L, 4), luaL_checknumber(L, 5),
+        luaL_optnumber(L, 6, 1.0), luaL_optnumber(L, 7, 0.0));
+    buf->dirty = true;
+    return 0;
+}
+
+// buffer:setPositions({x1, y1, z1, x2, ...}[, scale]) replaces every instance
+static int l_InstancesSetPositions(lua_State* L) {
+    InstanceBuffer* buf = getPtr<InstanceBuffer>(L, 1);
+    luaL_checktype(L, 2, LUA_TTABLE);
+    float scale = luaL_optnumber(L, 3, 1.0);
+    lua_Integer n = lua_rawlen(L, 2) / 3;
+
+    buf->transforms.resize(n);
+    for (lua_Integer i = 0; i < n; i++) {
+        float p[3];
+        for (int k = 0; k < 3; k++) {
+            lua_rawgeti(L, 2, i * 3 + k + 1);
+            p[k] = lua_tonumber(L, -1);
+            lua_pop(L, 1);
+        }
+        Matrix& t = buf->transforms[i];
+        t = MatrixScale(scale, scale, scale);
+        t.m12 = p[0];
+        t.m13 = p[1];
+        t.m14 = p[2];
+    }
+    buf->dirty = true;
+    return 0;
+}
+
+// buffer:setMatrices(data) replaces every instance with packed float32 4x4
+// matrices (column major, raylib layout), data is an f32 Buffer or a string
+// built with string.pack
+static int l_InstancesSetMatrices(lua_State* L) {
+    InstanceBuffer* buf = getPtr<InstanceBuffer>(L, 1);
+    size_t len;
+    const char* data;
+    if (testBuffer(L, 2)) {
+        Buffer* src = checkBufferType(L, 2, BUFFER_F32);
+        data = (const char*)src->bytes();
+        len = src->byteSize();
+    } else {
+        data = luaL_checklstring(L, 2, &len);
+    }
+    luaL_argcheck(L, len % sizeof(Matrix) == 0, 2, "size is not a multiple of 64 bytes");
+
+    buf->transforms.resize(len / sizeof(Matrix));
+    memcpy(buf->transforms.data(), data, len);
+    buf->dirty = true;
+    return 0;
+}
+
+static int l_InstancesCount(lua_State* L) {
+    lua_pushinteger(L, getPtr<InstanceBuffer>(L, 1)->transforms.size());
+    return 1;
+}
+
+static int l_InstancesClear(lua_State* L) {
+    InstanceBuffer* buf = getPtr<InstanceBuffer>(L, 1);
+    buf->transforms.clear();
+    buf->dirty = true;
+    return 0;
+}
+
+static int l_InstancesUnload(lua_State* L) {
+    InstanceBuffer* buf = getPtr<InstanceBuffer>(L, 1);
+    if (!buf) return 0;
+    instanceBufferPool.erase(std::remove(instanceBufferPool.begin(), instanceBufferPool.end(), buf), instanceBufferPool.end());
+    delete buf;
+    return 0;
+}
+
+static int l_SceneUnloadAll(lua_State* L) {
+    for (SceneModel* m : sceneModelPool) {
+        UnloadModel(m->model);
+        delete m;
+    }
+    sceneModelPool.clear();
+    for (InstanceBuffer* buf : instanceBufferPool) delete buf;
+    instanceBufferPool.clear();
+    if (sceneInstancingShader.id) UnloadShader(sceneInstancingShader);
+    sceneInstancingShader = { 0 };
+    return 0;
+}
+
+// Register SceneModel and InstanceBuffer methods (no __gc)
+static void registerSceneClasses(lua_State* L) {
+    if (luaL_newmetatable(L, typeid(SceneModel).name())) {
+        lua_pushstring(L, "__index");
+        lua_newtable(L);
+
+        static luaL_Reg methods[] = {
+            { "draw", l_SceneModelDraw },
+            { "drawInstanced", l_SceneModelDrawInstanced },
+            { "getBounds", l_SceneModelGetBounds },
+            { "unload", l_SceneModelUnload },
+            { NULL, NULL }
+        };
+        push_funcs(L, methods);
+
+        lua_settable(L, -3); // metatable.__index = table
+    }
+    lua_pop(L, 1);
+
+    if (luaL_newmetatable(L, typeid(InstanceBuffer).name())) {
+        lua_pushstring(L, "__index");
+        lua_newtable(L);
+
+        static luaL_Reg methods[] = {
+            { "add", l_InstancesAdd },
+            { "set", l_InstancesSet },
+            { "setPositions", l_InstancesSetPositions },
+            { "setMatrices", l_InstancesSetMatrices },
+            { "count", l_InstancesCount },
+            { "clear", l_InstancesClear },
+            { "unload", l_InstancesUnload },
+            { NULL, NULL }
+        };
+        push_funcs(L, methods);
+
+        lua_settable(L, -3); // metatable.__index = table
+    }
+    lua_pop(L, 1);
+}
+
+static luaL_Reg sceneFuncs[] = {
+    { "loadModel", l_SceneLoadModel },
+    { "cube", l_SceneCube },
+    { "sphere", l_SceneSphere },
+    { "newInstances", l_SceneNewInstances },
+    { "unloadAll", l_SceneUnloadAll },
+    { NULL, NULL }
+};
+
+extern "C" void init_raylib_scene(lua_State* L) {
+    registerSceneClasses(L);
+    newModule("Scene", sceneFuncs, L);
+}
@@ -3,6 +3,7 @@
 #include <lua.hpp>
 #include <raylib.h>
 #include "../../../libs/lua_ffi.hpp" // for pushPtr, getPtr
+#include "ray-frame.cpp" // frameAddAudio
 #include <algorithm>     // std::remove
 #include <vector>
 
@@ -170,7 +171,9 @@ static int l_ResumeMusic(lua_State *L) {
 static int l_UpdateMusic(lua_State *L) {
 	MusicWraper* mw = getPtr<MusicWraper>(L, 1);
 	if(!mw) return 0;
+	double start = frameNowMs();
 	UpdateMusicStream(mw->music);
+	frameAddAudio(frameNowMs() - start);
 	return 0;
 }
 
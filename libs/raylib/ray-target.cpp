@@ -0,0 +1,296 @@
+// ray-target.cpp - RenderTarget: render textures with a reuse pool
+// Scripts draw static layers (backgrounds, UI panels) into a target once and
+// blit it every frame, redrawing only after markDirty().
+#pragma once
+#include <lua.hpp>
+#include <raylib.h>
+#include <rlgl.h>
+#include "../../../libs/lua_ffi.hpp" // pushPtr, getPtr, getArgByName
+#include "ray-color.cpp"             // lua_getColor
+#include "ray-headless.cpp"          // headlessBeginFrame
+#include <algorithm>                 // std::remove, std::find
+#include <vector>
+
+struct RenderTarget {
+    RenderTexture2D rt;
+    int format;
+    bool inUse;
+    bool dirty;
+};
+
+// Every target ever created, released ones are handed out again by acquireRenderTarget
+static std::vector<RenderTarget*> renderTargetPool;
+
+// Run by RenderTarget.unloadAll before the targets are freed, so modules that
+// hold targets (Tilemap chunks) drop their pointers
+static std::vector<void (*)()> renderTargetUnloadHooks;
+
+static void addRenderTargetUnloadHook(void (*hook)()) {
+    if (std::find(renderTargetUnloadHooks.begin(), renderTargetUnloadHooks.end(), hook) == renderTargetUnloadHooks.end())
+        renderTargetUnloadHooks.push_back(hook);
+}
+
+static RenderTexture2D loadRenderTextureFormat(int width, int height, int format) {
+    if (format == PIXELFORMAT_UNCOMPRESSED_R8G8B8A8)
+        return LoadRenderTexture(width, height);
+
+    // same as LoadRenderTexture but with a custom color attachment format
+    RenderTexture2D target = {0};
+    target.id = rlLoadFramebuffer();
+    if (!target.id) return target;
+
+    rlEnableFramebuffer(target.id);
+    target.texture.id = rlLoadTexture(NULL, width, height, format, 1);
+    target.texture.width = width;
+    target.texture.height = height;
+    target.texture.format = format;
+    target.texture.mipmaps = 1;
+
+    target.depth.id = rlLoadTextureDepth(width, height, true);
+    target.depth.width = width;
+    target.depth.height = height;
+    target.depth.format = 19; // DEPTH_COMPONENT_24BIT, same as raylib
+    target.depth.mipmaps = 1;
+
+    rlFramebufferAttach(target.id, target.texture.id, RL_ATTACHMENT_COLOR_CHANNEL0, RL_ATTACHMENT_TEXTURE2D, 0);
+    rlFramebufferAttach(target.id, target.depth.id, RL_ATTACHMENT_DEPTH, RL_ATTACHMENT_RENDERBUFFER, 0);
+    bool complete = rlFramebufferComplete(target.id);
+    rlDisableFramebuffer();
+
+    if (!complete) {
+        UnloadRenderTexture(target);
+        target = {0};
+    }
+    return target;
+}
+
+// Returns an unused target of the same size and format, or creates one
+static RenderTarget* acquireRenderTarget(int width, int height, int format) {
+    for (RenderTarget* t : renderTargetPool) {
+        if (!t->inUse && t->format == format &&
+            t->rt.texture.width == width && t->rt.texture.height == height) {
+            t->inUse = true;
+            t->dirty = true; // contents are whatever the last user left
+            return t;
+        }
+    }
+
+    RenderTexture2D rt = loadRenderTextureFormat(width, height, format);
+    if (!rt.id) return nullptr;
+
+    RenderTarget* t = new RenderTarget{ rt, format, true, true };
+    renderTargetPool.push_back(t);
+    return t;
+}
+
+static void releaseRenderTarget(RenderTarget* t) {
+    if (t) t->inUse = false;
+}
+
+static void unloadRenderTarget(RenderTarget* t) {
+    if (t->rt.id) UnloadRenderTexture(t->rt);
+    renderTargetPool.erase(std::remove(renderTargetPool.begin(), renderTargetPool.end(), t), renderTargetPool.end());
+    delete t;
+}
+
+// Render textures are stored bottom-up, so flip the source rectangle
+static Rectangle flippedSource(RenderTarget* t, Rectangle src) {
+    src.y = t->rt.texture.height - src.y - src.height;
+    src.height = -src.height;
+    return src;
+}
+
+static Color optColor(lua_State* L, int idx) {
+    return lua_isnoneornil(L, idx) ? WHITE : lua_getColor(L, idx);
+}
+
+// RenderTarget.get(width, height[, format]) -> target
+static int l_RenderTargetGet(lua_State* L) {
+    int width = luaL_checkinteger(L, 1);
+    int height = luaL_checkinteger(L, 2);
+    int format = luaL_optinteger(L, 3, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+
+    RenderTarget* t = acquireRenderTarget(width, height, format);
+    if (!t) {
+        lua_pushnil(L);
+        lua_pushstring(L, "Failed to create render target");
+        return 2;
+    }
+    pushPtr(L, t); // Pushed as userdata, no __gc
+    return 1;
+}
+
+static int l_RenderTargetBegin(lua_State* L) {
+    RenderTarget* t = getPtr<RenderTarget>(L, 1);
+    BeginTextureMode(t->rt);
+    return 0;
+}
+
+static int l_RenderTargetStop(lua_State* L) {
+    RenderTarget* t = getPtr<RenderTarget>(L, 1);
+    EndTextureMode();
+    headlessBeginFrame(); // EndTextureMode went back to the window framebuffer
+    t->dirty = false;
+    return 0;
+}
+
+// target:draw(x, y[, tint])
+static int l_RenderTargetDraw(lua_State* L) {
+    RenderTarget* t = getPtr<RenderTarget>(L, 1);
+    Vector2 pos = { (float)luaL_checknumber(L, 2), (float)luaL_checknumber(L, 3) };
+    Rectangle src = { 0, 0, (float)t->rt.texture.width, (float)t->rt.texture.height };
+    DrawTextureRec(t->rt.texture, flippedSource(t, src), pos, optColor(L, 4));
+    return 0;
+}
+
+// target:drawRec(source, position[, tint])
+static int l_RenderTargetDrawRec(lua_State* L) {
+    RenderTarget* t = getPtr<RenderTarget>(L, 1);
+    Rectangle src = {
+        (float)getArgByName(L, "x", 2),
+        (float)getArgByName(L, "y", 2),
+        (float)getArgByName(L, "width", 2),
+        (float)getArgByName(L, "height", 2)
+    };
+    Vector2 pos = { (float)getArgByName(L, "x", 3), (float)getArgByName(L, "y", 3) };
+    DrawTextureRec(t->rt.texture, flippedSource(t, src), pos, optColor(L, 4));
+    return 0;
+}
+
+// target:drawPro(source, dest, origin, rotation[, tint])
+static int l_RenderTargetDrawPro(lua_State* L) {
+    RenderTarget* t = getPtr<RenderTarget>(L, 1);
+    Rectangle src = {
+        (float)getArgByName(L, "x", 2),
+        (float)getArgByName(L, "y", 2),
+        (float)getArgByName(L, "width", 2),
+        (float)getArgByName(L, "height", 2)
+    };
+    Rectangle dst = {
+        (float)getArgByName(L, "x", 3),
+        (float)getArgByName(L, "y", 3),
+        (float)getArgByName(L, "width", 3),
+        (float)getArgByName(L, "height", 3)
+    };
+    Vector2 origin = { (float)getArgByName(L, "x", 4), (float)getArgByName(L, "y", 4) };
+    float rotation = luaL_optnumber(L, 5, 0);
+    DrawTexturePro(t->rt.texture, flippedSource(t, src), dst, origin, rotation, optColor(L, 6));
+    return 0;
+}
+
+static int l_RenderTargetMarkDirty(lua_State* L) {
+    getPtr<RenderTarget>(L, 1)->dirty = true;
+    return 0;
+}
+
+static int l_RenderTargetIsDirty(lua_State* L) {
+    lua_pushboolean(L, getPtr<RenderTarget>(L, 1)->dirty);
+    return 1;
+}
+
+static int l_RenderTargetGetSize(lua_State* L) {
+    RenderTarget* t = getPtr<RenderTarget>(L, 1);
+    lua_newtable(L);
+    lua_pushinteger(L, t->rt.texture.width);
+    lua_setfield(L, -2, "width");
+    lua_pushinteger(L, t->rt.texture.height);
+    lua_setfield(L, -2, "height");
+    return 1;
+}
+
+// Give the target back to the pool, the userdata must not be used afterwards
+static int l_RenderTargetRelease(lua_State* L) {
+    releaseRenderTarget(getPtr<RenderTarget>(L, 1));
+    return 0;
+}
+
+static int l_RenderTargetUnload(lua_State* L) {
+    RenderTarget* t = getPtr<RenderTarget>(L, 1);
+    if (!t) return 0;
+    unloadRenderTarget(t);
+    return 0;
+}
+
+// Unload released targets that are sitting in the pool
+static int l_RenderTargetTrim(lua_State* L) {
+    std::vector<RenderTarget*> unused;
+    for (RenderTarget* t : renderTargetPool)
+        if (!t->inUse) unused.push_back(t);
+    for (RenderTarget* t : unused) unloadRenderTarget(t);
+    lua_pushinteger(L, unused.size());
+    return 1;
+}
+
+// Unload every target, including the ones still in use: targets got from
+// RenderTarget.get must not be used afterwards, Tilemaps render their chunks again
+static int l_RenderTargetUnloadAll(lua_State* L) {
+    for (auto hook : renderTargetUnloadHooks) hook();
+    for (RenderTarget* t : renderTargetPool) {
+        if (t->rt.id) UnloadRenderTexture(t->rt);
+        delete t;
+    }
+    renderTargetPool.clear();
+    return 0;
+}
+
+static int l_RenderTargetStats(lua_State* L) {
+    int inUse = 0;
+    for (RenderTarget* t : renderTargetPool) inUse += t->inUse;
+    lua_newtable(L);
+    lua_pushinteger(L, renderTargetPool.size());
+    lua_setfield(L, -2, "total");
+    lua_pushinteger(L, inUse);
+    lua_setfield(L, -2, "inUse");
+    return 1;
+}
+
+// Register RenderTarget methods (no __gc)
+static void registerRenderTargetClass(lua_State* L) {
+    const char* type = typeid(RenderTarget).name();
+    if (luaL_newmetatable(L, type)) {
+        lua_pushstring(L, "__index");
+        lua_newtable(L);
+
+        static luaL_Reg methods[] = {
+            { "begin", l_RenderTargetBegin },
+            { "stop", l_RenderTargetStop },
+            { "draw", l_RenderTargetDraw },
+            { "drawRec", l_RenderTargetDrawRec },
+            { "drawPro", l_RenderTargetDrawPro },
+            { "markDirty", l_RenderTargetMarkDirty },
+            { "isDirty", l_RenderTargetIsDirty },
+            { "getSize", l_RenderTargetGetSize },
+            { "release", l_RenderTargetRelease },
+            { "unload", l_RenderTargetUnload },
+            { NULL, NULL }
+        };
+        push_funcs(L, methods);
+
+        lua_settable(L, -3); // metatable.__index = table
+    }
+    lua_pop(L, 1);
+}
+
+static luaL_Reg renderTargetFuncs[] = {
+    { "get", l_RenderTargetGet },
+    { "trim", l_RenderTargetTrim },
+    { "unloadAll", l_RenderTargetUnloadAll },
+    { "stats", l_RenderTargetStats },
+    { NULL, NULL }
+};
+
+extern "C" void init_raylib_render_target(lua_State* L) {
+    registerRenderTargetClass(L);
+    newModule("RenderTarget", renderTargetFuncs, L);
+
+    lua_getglobal(L, "RenderTarget");
+    lua_pushinteger(L, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+    lua_setfield(L, -2, "RGBA8");
+    lua_pushinteger(L, PIXELFORMAT_UNCOMPRESSED_R16G16B16A16);
+    lua_setfield(L, -2, "RGBA16F");
+    lua_pushinteger(L, PIXELFORMAT_UNCOMPRESSED_R32G32B32A32);
+    lua_setfield(L, -2, "RGBA32F");
+    lua_pushinteger(L, PIXELFORMAT_UNCOMPRESSED_R32);
+    lua_setfield(L, -2, "R32F");
+    lua_pop(L, 1);
+}
@@ -0,0 +1,402 @@
+// ray-tilemap.cpp - Tilemap: tile ids in C, drawn as cached chunks
+// The map is split in TILEMAP_CHUNK x TILEMAP_CHUNK tile chunks. A chunk is
+// rendered once into a pooled RenderTarget (ray-target.cpp) the first time it
+// becomes visible and only re-rendered after one of its tiles changes, so a
+// frame draws one textured quad per visible chunk whatever the map size.
+#pragma once
+#include <lua.hpp>
+#include <raylib.h>
+#include <raymath.h>
+#include <rlgl.h>
+#include "../../../libs/lua_ffi.hpp" // pushPtr, getPtr
+#include "ray-color.cpp"             // lua_getColor
+#include "ray-target.cpp"            // acquireRenderTarget, releaseRenderTarget
+#include "ray-headless.cpp"          // headlessBeginFrame
+// Img (ray-img.cpp) and the camera helpers (ray-cam/init.cpp) come from raylib.cpp
+#include <algorithm>                 // std::remove
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#define TILEMAP_CHUNK 32        // tiles per chunk side
+#define TILEMAP_CACHE_DEFAULT 64 // chunks kept in render targets
+
+struct TileChunk {
+    RenderTarget* target; // null until the chunk is first drawn or after eviction
+    bool dirty;
+    uint32_t lastUsed;
+};
+
+struct Tilemap {
+    int width, height; // in tiles
+    int tileSize;
+    Img* atlas;        // its texture is read when chunks render, image ops may replace it
+    unsigned atlasVersion; // atlas Img version + 1 the cached chunks were rendered with, 0 once unloaded
+    std::vector<uint16_t> tiles; // 0 is empty, n is atlas cell n-1
+    int chunksX, chunksY;
+    std::vector<TileChunk> chunks;
+    int cached;    // chunks currently holding a target
+    int cacheSize; // LRU limit for `cached`
+    uint32_t frame;
+};
+
+static std::vector<Tilemap*> tilemapPool;
+
+static TileChunk& tilemapChunkAt(Tilemap* map, int tx, int ty) {
+    return map->chunks[(ty / TILEMAP_CHUNK) * map->chunksX + tx / TILEMAP_CHUNK];
+}
+
+static void tilemapSetTile(Tilemap* map, int tx, int ty, uint16_t id) {
+    uint16_t& tile = map->tiles[(size_t)ty * map->width + tx];
+    if (tile == id) return;
+    tile = id;
+    tilemapChunkAt(map, tx, ty).dirty = true;
+}
+
+static void tilemapMarkAllDirty(Tilemap* map) {
+    for (TileChunk& c : map->chunks) c.dirty = true;
+}
+
+static void tilemapDropChunk(Tilemap* map, TileChunk& c) {
+    if (!c.target) return;
+    releaseRenderTarget(c.target);
+    c.target = nullptr;
+    c.dirty = true;
+    map->cached--;
+}
+
+// RenderTarget.unloadAll hook: every chunk gives its target back and gets
+// rendered again on the next draw
+static void tilemapDropAllTargets() {
+    for (Tilemap* map : tilemapPool)
+        for (TileChunk& c : map->chunks) tilemapDropChunk(map, c);
+}
+
+// Frees the least recently used chunk that was not drawn this frame
+static bool tilemapEvictOne(Tilemap* map) {
+    TileChunk* oldest = nullptr;
+    for (TileChunk& c : map->chunks) {
+        if (!c.target || c.lastUsed == map->frame) continue;
+        if (!oldest || c.lastUsed < oldest->lastUsed) oldest = &c;
+    }
+    if (!oldest) return false;
+    tilemapDropChunk(map, *oldest);
+    return true;
+}
+
+static void tilemapRenderChunk(Tilemap* map, int cx, int cy, TileChunk& c) {
+    if (!c.target) {
+        if (map->cached >= map->cacheSize) tilemapEvictOne(map); // over the limit only when all are visible
+        int px = TILEMAP_CHUNK * map->tileSize;
+        c.target = acquireRenderTarget(px, px, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+        if (!c.target) return;
+        map->cached++;
+    }
+
+    int x0 = cx * TILEMAP_CHUNK, y0 = cy * TILEMAP_CHUNK;
+    int x1 = std::min(x0 + TILEMAP_CHUNK, map->width), y1 = std::min(y0 + TILEMAP_CHUNK, map->height);
+    float ts = (float)map->tileSize;
+    const Img* atlasImg = imgAlive(map->atlas) ? map->atlas : nullptr;
+    Texture2D atlas = atlasImg ? atlasImg->texture : Texture2D{ 0 }; // unloaded: empty chunks
+    int columns = std::max(1, atlas.width / map->tileSize);
+
+    // chunks hold premultiplied alpha: blending straight alpha tiles onto
+    // BLANK with BLEND_ALPHA would store alpha squared and thin every
+    // translucent pixel when the chunk is blended again. A premultiplied
+    // atlas is blended as it is (imgBlendMode).
+    BeginTextureMode(c.target->rt);
+    ClearBackground(BLANK);
+    rlSetBlendFactorsSeparate(RL_SRC_ALPHA, RL_ONE_MINUS_SRC_ALPHA, RL_ONE, RL_ONE_MINUS_SRC_ALPHA, RL_FUNC_ADD, RL_FUNC_ADD);
+    BeginBlendMode(imgBlendMode(atlasImg, BLEND_CUSTOM_SEPARATE));
+    for (int ty = y0; atlas.id && ty < y1; ty++) {
+        const uint16_t* row = &map->tiles[(size_t)ty * map->width];
+        for (int tx = x0; tx < x1; tx++) {
+            int id = row[tx];
+            if (!id) continue;
+            int cell = id - 1;
+            Rectangle src = { (cell % columns) * ts, (cell / columns) * ts, ts, ts };
+            if (src.y >= atlas.height) continue; // id past the end of the atlas
+            DrawTextureRec(atlas, src, { (tx - x0) * ts, (ty - y0) * ts }, WHITE);
+        }
+    }
+    EndBlendMode();
+    EndTextureMode();
+
+    c.target->dirty = false;
+    c.dirty = false;
+}
+
+// Chunk range covering a world space rectangle, clamped to the map
+static void tilemapVisibleChunks(Tilemap* map, Rectangle view, int* cx0, int* cy0, int* cx1, int* cy1) {
+    float chunkPx = (float)(TILEMAP_CHUNK * map->tileSize);
+    *cx0 = std::max(0, (int)std::floor(view.x / chunkPx));
+    *cy0 = std::max(0, (int)std::floor(view.y / chunkPx));
+    *cx1 = std::min(map->chunksX - 1, (int)std::floor((view.x + view.width) / chunkPx));
+    *cy1 = std::min(map->chunksY - 1, (int)std::floor((view.y + view.height) / chunkPx));
+}
+
+// Renders the visible chunks that are missing or dirty, returns how many were rendered
+static int tilemapPrepare(Tilemap* map, Rectangle view) {
+    int cx0, cy0, cx1, cy1;
+    tilemapVisibleChunks(map, view, &cx0, &cy0, &cx1, &cy1);
+    map->frame++;
+
+    // the atlas was unloaded or got a new texture (resize, crop...)
+    unsigned atlasVersion = imgAlive(map->atlas) ? map->atlas->version + 1 : 0;
+    if (atlasVersion != map->atlasVersion) {
+        map->atlasVersion = atlasVersion;
+        tilemapMarkAllDirty(map);
+    }
+
+    int rendered = 0;
+    for (int cy = cy0; cy <= cy1; cy++) {
+        for (int cx = cx0; cx <= cx1; cx++) {
+            TileChunk& c = map->chunks[cy * map->chunksX + cx];
+            c.lastUsed = map->frame;
+            if (c.target && !c.dirty) continue;
+            tilemapRenderChunk(map, cx, cy, c);
+            rendered++;
+        }
+    }
+    return rendered;
+}
+
+// Tilemap.new(width, height, atlas, tileSize) -> map
+// width/height in tiles, atlas is an Image whose cells are tileSize squares
+static int l_NewTilemap(lua_State* L) {
+    int width = luaL_checkinteger(L, 1);
+    int height = luaL_checkinteger(L, 2);
+    Img* atlas = getPtr<Img>(L, 3);
+    int tileSize = luaL_checkinteger(L, 4);
+    luaL_argcheck(L, width > 0 && height > 0, 1, "map size must be positive");
+    luaL_argcheck(L, tileSize > 0 && tileSize <= atlas->texture.width, 4, "invalid tile size");
+
+    Tilemap* map = new Tilemap();
+    map->width = width;
+    map->height = height;
+    map->tileSize = tileSize;
+    map->atlas = atlas;
+    map->atlasVersion = atlas->version + 1;
+    map->tiles.assign((size_t)width * height, 0);
+    map->chunksX = (width + TILEMAP_CHUNK - 1) / TILEMAP_CHUNK;
+    map->chunksY = (height + TILEMAP_CHUNK - 1) / TILEMAP_CHUNK;
+    map->chunks.assign((size_t)map->chunksX * map->chunksY, { nullptr, true, 0 });
+    map->cached = 0;
+    map->cacheSize = TILEMAP_CACHE_DEFAULT;
+    map->frame = 0;
+
+    tilemapPool.push_back(map);
+    pushPtr(L, map); // Pushed as userdata, no __gc
+    return 1;
+}
+
+// Tile coordinates are 0 based, like pixel coordinates
+static bool tilemapCheckCoords(lua_State* L, Tilemap* map, int arg, int* tx, int* ty) {
+    *tx = luaL_checkinteger(L, arg);
+    *ty = luaL_checkinteger(L, arg + 1);
+    return *tx >= 0 && *ty >= 0 && *tx < map->width && *ty < map->height;
+}
+
+// map:set(x, y, id)
+static int l_TilemapSet(lua_State* L) {
+    Tilemap* map = getPtr<Tilemap>(L, 1);
+    int tx, ty;
+    if (!tilemapCheckCoords(L, map, 2, &tx, &ty)) return luaL_error(L, "tile %d,%d is outside the map", tx, ty);
+    tilemapSetTile(map, tx, ty, (uint16_t)luaL_checkinteger(L, 4));
+    return 0;
+}
+
+// map:get(x, y) -> id (0 outside the map)
+static int l_TilemapGet(lua_State* L) {
+    Tilemap* map = getPtr<Tilemap>(L, 1);
+    int tx, ty;
+    bool inside = tilemapCheckCoords(L, map, 2, &tx, &ty);
+    lua_pushinteger(L, inside ? map->tiles[(size_t)ty * map->width + tx] : 0);
+    return 1;
+}
+
+// map:fill(x, y, w, h, id)
+static int l_TilemapFill(lua_State* L) {
+    Tilemap* map = getPtr<Tilemap>(L, 1);
+    int x0 = std::max(0, (int)luaL_checkinteger(L, 2));
+    int y0 = std::max(0, (int)luaL_checkinteger(L, 3));
+    int x1 = std::min(map->width, (int)(luaL_checkinteger(L, 2) + luaL_checkinteger(L, 4)));
+    int y1 = std::min(map->height, (int)(luaL_checkinteger(L, 3) + luaL_checkinteger(L, 5)));
+    uint16_t id = (uint16_t)luaL_checkinteger(L, 6);
+    for (int ty = y0; ty < y1; ty++)
+        for (int tx = x0; tx < x1; tx++) tilemapSetTile(map, tx, ty, id);
+    return 0;
+}
+
+// map:setData(ids) replaces every tile, ids is a flat row major table or a
+// string of little endian uint16 (string.pack("<I2", ...))
+static int l_TilemapSetData(lua_State* L) {
+    Tilemap* map = getPtr<Tilemap>(L, 1);
+    size_t count = map->tiles.size();
+
+    if (lua_type(L, 2) == LUA_TSTRING) {
+        size_t len;
+        const char* data = lua_tolstring(L, 2, &len);
+        luaL_argcheck(L, len == count * 2, 2, "expected width*height uint16 values");
+        for (size_t i = 0; i < count; i++)
+            map->tiles[i] = (uint8_t)data[i * 2] | ((uint8_t)data[i * 2 + 1] << 8);
+    } else {
+        luaL_checktype(L, 2, LUA_TTABLE);
+        for (size_t i = 0; i < count; i++) {
+            lua_rawgeti(L, 2, i + 1);
+            map->tiles[i] = (uint16_t)lua_tointeger(L, -1);
+            lua_pop(L, 1);
+        }
+    }
+    tilemapMarkAllDirty(map);
+    return 0;
+}
+
+// map:prepare([camera[, width, height]]) -> chunks rendered
+// Renders what the next draw needs; call it outside BeginMode2D/texture modes
+// to keep chunk rendering out of the draw pass
+static int l_TilemapPrepare(lua_State* L) {
+    Tilemap* map = getPtr<Tilemap>(L, 1);
+    Camera2D* cam = optCamera2D(L, 2);
+    int idx = cam == &globalCam2d ? 2 : 3;
+    float width = luaL_optnumber(L, idx, GetScreenWidth());
+    float height = luaL_optnumber(L, idx + 1, GetScreenHeight());
+
+    lua_pushinteger(L, tilemapPrepare(map, cameraVisibleRect(*cam, width, height)));
+    return 1;
+}
+
+// map:draw([camera[, tint]]) -> chunks drawn
+// Call inside camera:begin()/Camera2D.begin() on the screen. Chunks that still
+// need rendering are rendered first, after which the camera is re-applied.
+static int l_TilemapDraw(lua_State* L) {
+    Tilemap* map = getPtr<Tilemap>(L, 1);
+    Camera2D* cam = optCamera2D(L, 2);
+    int tintIdx = cam == &globalCam2d ? 2 : 3;
+    Color tint = lua_isnoneornil(L, tintIdx) ? WHITE : lua_getColor(L, tintIdx);
+
+    Rectangle view = cameraVisibleRect(*cam, GetScreenWidth(), GetScreenHeight());
+    if (tilemapPrepare(map, view) > 0) {
+        // BeginTextureMode/EndTextureMode reset the framebuffer and the camera
+        headlessBeginFrame();
+        rlLoadIdentity();
+        rlMultMatrixf(MatrixToFloat(GetCameraMatrix2D(*cam)));
+    }
+
+    int cx0, cy0, cx1, cy1;
+    tilemapVisibleChunks(map, view, &cx0, &cy0, &cx1, &cy1);
+    float chunkPx = (float)(TILEMAP_CHUNK * map->tileSize);
+    int drawn = 0;
+    tint = colorPremultiply(tint);
+    BeginBlendMode(BLEND_ALPHA_PREMULTIPLY); // chunks are premultiplied, see tilemapRenderChunk
+    for (int cy = cy0; cy <= cy1; cy++) {
+        for (int cx = cx0; cx <= cx1; cx++) {
+            TileChunk& c = map->chunks[cy * map->chunksX + cx];
+            if (!c.target) continue;
+            Rectangle src = { 0, 0, chunkPx, chunkPx };
+            DrawTextureRec(c.target->rt.texture, flippedSource(c.target, src), { cx * chunkPx, cy * chunkPx }, tint);
+            drawn++;
+        }
+    }
+    EndBlendMode();
+    lua_pushinteger(L, drawn);
+    return 1;
+}
+
+// map:worldToTile(x, y) -> tx, ty
+static int l_TilemapWorldToTile(lua_State* L) {
+    Tilemap* map = getPtr<Tilemap>(L, 1);
+    lua_pushinteger(L, (lua_Integer)std::floor(luaL_checknumber(L, 2) / map->tileSize));
+    lua_pushinteger(L, (lua_Integer)std::floor(luaL_checknumber(L, 3) / map->tileSize));
+    return 2;
+}
+
+static int l_TilemapGetSize(lua_State* L) {
+    Tilemap* map = getPtr<Tilemap>(L, 1);
+    lua_newtable(L);
+    lua_pushinteger(L, map->width);
+    lua_setfield(L, -2, "width");
+    lua_pushinteger(L, map->height);
+    lua_setfield(L, -2, "height");
+    lua_pushinteger(L, map->tileSize);
+    lua_setfield(L, -2, "tileSize");
+    return 1;
+}
+
+// map:setCacheSize(chunks) - how many chunk textures are kept around
+static int l_TilemapSetCacheSize(lua_State* L) {
+    Tilemap* map = getPtr<Tilemap>(L, 1);
+    map->cacheSize = std::max(1, (int)luaL_checkinteger(L, 2));
+    while (map->cached > map->cacheSize && tilemapEvictOne(map)) {}
+    return 0;
+}
+
+// map:setAtlas(image) - swaps the atlas and re-renders every chunk
+static int l_TilemapSetAtlas(lua_State* L) {
+    Tilemap* map = getPtr<Tilemap>(L, 1);
+    Img* atlas = getPtr<Img>(L, 2);
+    map->atlas = atlas;
+    map->atlasVersion = atlas->version + 1;
+    tilemapMarkAllDirty(map);
+    return 0;
+}
+
+static void freeTilemap(Tilemap* map) {
+    for (TileChunk& c : map->chunks) tilemapDropChunk(map, c);
+    delete map;
+}
+
+static int l_TilemapUnload(lua_State* L) {
+    Tilemap* map = getPtr<Tilemap>(L, 1);
+    if (!map) return 0;
+    tilemapPool.erase(std::remove(tilemapPool.begin(), tilemapPool.end(), map), tilemapPool.end());
+    freeTilemap(map);
+    return 0;
+}
+
+static int l_TilemapUnloadAll(lua_State* L) {
+    for (Tilemap* map : tilemapPool) freeTilemap(map);
+    tilemapPool.clear();
+    return 0;
+}
+
+// Register Tilemap methods (no __gc)
+static void registerTilemapClass(lua_State* L) {
+    const char* type = typeid(Tilemap).name();
+    if (luaL_newmetatable(L, type)) {
+        lua_pushstring(L, "__index");
+        lua_newtable(L);
+
+        static luaL_Reg methods[] = {
+            { "set", l_TilemapSet },
+            { "get", l_TilemapGet },
+            { "fill", l_TilemapFill },
+            { "setData", l_TilemapSetData },
+            { "prepare", l_TilemapPrepare },
+            { "draw", l_TilemapDraw },
+            { "worldToTile", l_TilemapWorldToTile },
+            { "getSize", l_TilemapGetSize },
+            { "setCacheSize", l_TilemapSetCacheSize },
+            { "setAtlas", l_TilemapSetAtlas },
+            { "unload", l_TilemapUnload },
+            { NULL, NULL }
+        };
+        push_funcs(L, methods);
+
+        lua_settable(L, -3); // metatable.__index = table
+    }
+    lua_pop(L, 1);
+}
+
+static luaL_Reg tilemapFuncs[] = {
+    { "new", l_NewTilemap },
+    { "unloadAll", l_TilemapUnloadAll },
+    { NULL, NULL }
+};
+
+extern "C" void init_raylib_tilemap(lua_State* L) {
+    registerTilemapClass(L);
+    newModule("Tilemap", tilemapFuncs, L);
+    addRenderTargetUnloadHook(tilemapDropAllTargets);
+}
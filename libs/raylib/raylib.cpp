@@ -3,9 +3,14 @@
 #include <lua.hpp>
 #include "../../../libs/lua_ffi.hpp"
 #include "ray-init.cpp"
+#include "ray-pack.cpp"
 #include "ray-img.cpp"
 #include "ray-sound.cpp"
+#include "ray-target.cpp"
 #include "ray-cam/init.cpp"
+#include "ray-scene.cpp"
+#include "ray-tilemap.cpp"
+#include "ray-particles.cpp"
 
 #include <iostream>
 
@@ -43,6 +48,7 @@ static luaL_Reg funcs[] = {
 	{ NULL,NULL}
 };
 #include "../raygui/raygui.cpp"
+#include "../raygui/microui.cc"
 
 extern "C" int luaopen_raylib(lua_State *L) {
     // Iterate over the functions and add them to the table
@@ -52,11 +58,23 @@ extern "C" int luaopen_raylib(lua_State *L) {
 	}
     lua_init_colors(L);
 
+    init_raylib_pack(L);
     init_raylib_keys(L);
     init_raylib_img(L);
     init_raylib_sound(L);
 	initRaylibCamera(L);
+	init_raylib_frame_stats(L);
+	init_raylib_headless(L);
+	init_raylib_render_target(L);
+	init_raylib_scene(L);
+	init_raylib_tilemap(L);
+	init_raylib_particles(L);
+	init_raylib_font(L);
+	init_raylib_async(L);
+	pushBufferModule(L);
+	lua_setglobal(L, "Buffer");
 	init_raygui(L);
+	setup_microui(L);
 
 	return 1;
 }
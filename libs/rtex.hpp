@@ -0,0 +1,158 @@
+// rtex.hpp - .rtex, the preprocessed texture container
+// Written offline by tools/texconv.cpp, read by Image.load (ray-img.cpp).
+// Holds pixels exactly as the GPU takes them: any raylib PixelFormat, all mip
+// levels, optionally premultiplied, optionally LZ4 compressed. Loading maps
+// the file and hands the pixels to the GPU without decoding anything.
+//
+// Layout (little endian): RtexHeader, then dataSize bytes of pixels, mip
+// levels one after the other, largest first.
+#pragma once
+#include <raylib.h>
+#include "lz4.hpp"
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+#define RTEX_MAGIC "RTEX"
+#define RTEX_VERSION 1
+#define RTEX_MAX_SIZE 16384 // width and height
+
+enum RtexFlags {
+    RTEX_PREMULTIPLIED = 1 << 0,
+    RTEX_LZ4 = 1 << 1,
+};
+
+struct RtexHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t width, height;
+    uint32_t mipmaps;
+    uint32_t format; // raylib PixelFormat
+    uint32_t flags;  // RtexFlags
+    uint32_t reserved;
+    uint64_t rawSize;  // pixel bytes, all mip levels
+    uint64_t dataSize; // bytes after the header, rawSize unless RTEX_LZ4
+};
+
+// An open .rtex container, memory mapped or inside a mounted pack
+struct RtexFile {
+    RtexHeader header;
+    const uint8_t* data; // header.dataSize bytes inside the mapping
+    void* map;           // NULL when parsed from memory the caller owns
+    size_t mapSize;
+};
+
+// Bytes of every mip level, the layout raylib uses for Image.data. 0 for
+// sizes and formats raylib can't make a texture of.
+inline uint64_t rtexMipChainSize(int width, int height, int mipmaps, int format) {
+    if (width <= 0 || height <= 0 || width > RTEX_MAX_SIZE || height > RTEX_MAX_SIZE) return 0;
+    uint64_t size = 0;
+    for (int i = 0; i < mipmaps; i++) {
+        int64_t level = format < PIXELFORMAT_COMPRESSED_DXT1_RGB
+            ? (int64_t)GetPixelDataSize(width, 1, format) * height // a whole level can overflow an int
+            : GetPixelDataSize(width, height, format);
+        if (level <= 0) return 0;
+        size += level;
+        width = width > 1 ? width / 2 : 1;
+        height = height > 1 ? height / 2 : 1;
+    }
+    return size;
+}
+
+// Validates the container in bytes (a file mapping or a packed entry) and
+// points f at it. Returns NULL on success, or an error message.
+inline const char* rtexParse(const uint8_t* bytes, size_t size, RtexFile* f) {
+    *f = RtexFile{};
+    if (size < sizeof(RtexHeader)) return "Not an rtex file";
+    memcpy(&f->header, bytes, sizeof(RtexHeader));
+    f->data = bytes + sizeof(RtexHeader);
+
+    const RtexHeader& h = f->header;
+    if (memcmp(h.magic, RTEX_MAGIC, 4) != 0) return "Not an rtex file";
+    if (h.version != RTEX_VERSION) return "Unsupported rtex version";
+    if (h.mipmaps < 1 || h.mipmaps > 32 || h.format > 0xFFFF
+        || h.rawSize != rtexMipChainSize((int)h.width, (int)h.height, (int)h.mipmaps, (int)h.format)) return "Corrupt rtex header";
+    if (h.dataSize > size - sizeof(RtexHeader)) return "Truncated rtex file";
+    if (!(h.flags & RTEX_LZ4) && h.dataSize != h.rawSize) return "Corrupt rtex header";
+    return nullptr;
+}
+
+// Maps path and validates its header. Returns NULL on success, or an error
+// message (the file is closed again).
+inline const char* rtexOpen(const char* path, RtexFile* f) {
+    *f = RtexFile{};
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return "Cannot open file";
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        return "Not an rtex file";
+    }
+    void* map = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // the mapping stays valid
+    if (map == MAP_FAILED) return "Cannot map file";
+
+    if (const char* err = rtexParse((const uint8_t*)map, st.st_size, f)) {
+        munmap(map, st.st_size);
+        *f = RtexFile{};
+        return err;
+    }
+    f->map = map;
+    f->mapSize = st.st_size;
+    return nullptr;
+}
+
+inline void rtexClose(RtexFile* f) {
+    if (f->map) munmap(f->map, f->mapSize);
+    *f = RtexFile{};
+}
+
+// The pixels of f when they are stored uncompressed, straight from the
+// mapping (valid until rtexClose), NULL when they need rtexDecode
+inline const void* rtexRawPixels(const RtexFile& f) {
+    return (f.header.flags & RTEX_LZ4) ? nullptr : f.data;
+}
+
+// Writes header.rawSize bytes of pixels to dst, false on corrupt data
+inline bool rtexDecode(const RtexFile& f, void* dst) {
+    if (!(f.header.flags & RTEX_LZ4)) {
+        memcpy(dst, f.data, f.header.rawSize);
+        return true;
+    }
+    long long n = lz4Decompress(f.data, f.header.dataSize, (uint8_t*)dst, f.header.rawSize);
+    return n == (long long)f.header.rawSize;
+}
+
+// Writes a container. header.rawSize must be set, magic, version and dataSize
+// are filled in; pixels are LZ4 compressed when header.flags has RTEX_LZ4
+// (dropped again when compression does not help). Returns NULL on success.
+inline const char* rtexSave(const char* path, RtexHeader header, const void* pixels) {
+    memcpy(header.magic, RTEX_MAGIC, 4);
+    header.version = RTEX_VERSION;
+
+    std::vector<uint8_t> packed;
+    const void* data = pixels;
+    header.dataSize = header.rawSize;
+    if (header.flags & RTEX_LZ4) {
+        packed.resize(lz4Bound(header.rawSize));
+        size_t n = lz4Compress((const uint8_t*)pixels, header.rawSize, packed.data());
+        if (n < header.rawSize) {
+            data = packed.data();
+            header.dataSize = n;
+        } else {
+            header.flags &= ~RTEX_LZ4;
+        }
+    }
+
+    FILE* file = fopen(path, "wb");
+    if (!file) return "Cannot open file for writing";
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1
+        && fwrite(data, 1, header.dataSize, file) == header.dataSize;
+    ok = fclose(file) == 0 && ok;
+    return ok ? nullptr : "Error writing file";
+}
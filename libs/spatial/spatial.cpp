@@ -0,0 +1,752 @@
+// spatial.cpp - spatial indexes for culling and collision
+// Spatial.newTree([margin]) - dynamic AABB tree, good for mixed sizes and static worlds
+// Spatial.newGrid(cellSize) - loose uniform grid, cheap moves for many similar sized objects
+//
+// Both hand out integer handles and answer rectangle, circle and ray queries
+// with arrays of handles, plus a batched overlapping pair search. Queries can
+// write into an i32 Buffer instead of a table, and moveBatch reads handles
+// and rects from buffers.
+#include <lua.hpp>
+#include "../../../libs/lua_ffi.hpp" // pushPtr, getPtr, getArgByName
+#include "../buffer.hpp"             // Buffer, testBuffer, checkBufferType
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+struct AABB {
+    float minX, minY, maxX, maxY;
+
+    bool overlaps(const AABB& o) const {
+        return minX <= o.maxX && o.minX <= maxX && minY <= o.maxY && o.minY <= maxY;
+    }
+    bool contains(const AABB& o) const {
+        return minX <= o.minX && minY <= o.minY && o.maxX <= maxX && o.maxY <= maxY;
+    }
+    float perimeter() const { return 2.0f * ((maxX - minX) + (maxY - minY)); }
+
+    static AABB merge(const AABB& a, const AABB& b) {
+        return { std::min(a.minX, b.minX), std::min(a.minY, b.minY),
+                 std::max(a.maxX, b.maxX), std::max(a.maxY, b.maxY) };
+    }
+};
+
+static bool circleOverlaps(const AABB& box, float cx, float cy, float r) {
+    float dx = cx - std::max(box.minX, std::min(cx, box.maxX));
+    float dy = cy - std::max(box.minY, std::min(cy, box.maxY));
+    return dx * dx + dy * dy <= r * r;
+}
+
+// Slab test of the segment p + t*d, t in [0, 1]. Writes the entry t on a hit.
+static bool segmentOverlaps(const AABB& box, float px, float py, float dx, float dy, float* tHit) {
+    float tMin = 0.0f, tMax = 1.0f;
+    float p[2] = { px, py }, d[2] = { dx, dy };
+    float lo[2] = { box.minX, box.minY }, hi[2] = { box.maxX, box.maxY };
+    for (int axis = 0; axis < 2; axis++) {
+        if (std::fabs(d[axis]) < 1e-12f) {
+            if (p[axis] < lo[axis] || p[axis] > hi[axis]) return false;
+            continue;
+        }
+        float inv = 1.0f / d[axis];
+        float t1 = (lo[axis] - p[axis]) * inv;
+        float t2 = (hi[axis] - p[axis]) * inv;
+        if (t1 > t2) std::swap(t1, t2);
+        tMin = std::max(tMin, t1);
+        tMax = std::min(tMax, t2);
+        if (tMin > tMax) return false;
+    }
+    if (tHit) *tHit = tMin;
+    return true;
+}
+
+// Common interface so the Lua side does not care which index it talks to
+struct SpatialIndex {
+    virtual ~SpatialIndex() {}
+    virtual int insert(const AABB& box) = 0;
+    virtual void move(int handle, const AABB& box) = 0;
+    virtual void remove(int handle) = 0;
+    virtual void clear() = 0;
+    virtual int count() const = 0;
+    virtual bool valid(int handle) const = 0;
+    virtual void queryRect(const AABB& box, std::vector<int>& out) const = 0;
+    virtual void queryCircle(float cx, float cy, float r, std::vector<int>& out) const = 0;
+    // hits sorted by distance along the segment
+    virtual void raycast(float x1, float y1, float x2, float y2, std::vector<int>& out) const = 0;
+    // every overlapping pair once, flattened as a1, b1, a2, b2...
+    virtual void pairs(std::vector<int>& out) const = 0;
+};
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Dynamic AABB tree
+// Leaves store fattened boxes so small moves don't touch the tree, inserts
+// pick the sibling with the least perimeter growth and the tree is kept
+// balanced with rotations (same scheme as Box2D's b2DynamicTree).
+// ─────────────────────────────────────────────────────────────────────────────
+
+class AABBTree : public SpatialIndex {
+    struct Node {
+        AABB box;
+        int parent;
+        int child1, child2;
+        int height; // -1 when free
+        int handle; // leaves only
+        bool isLeaf() const { return child1 == -1; }
+    };
+
+    std::vector<Node> nodes;
+    int root = -1;
+    int freeList = -1;
+    float margin;
+
+    // per handle: leaf node (-1 when removed) and the exact box
+    std::vector<int> leafOf;
+    std::vector<AABB> tight;
+    std::vector<int> freeHandles;
+    int live = 0;
+
+    int allocNode() {
+        if (freeList == -1) {
+            nodes.push_back({});
+            freeList = (int)nodes.size() - 1;
+            nodes.back().parent = -1;
+        }
+        int id = freeList;
+        freeList = nodes[id].parent; // free nodes chain through parent
+        nodes[id] = { {}, -1, -1, -1, 0, -1 };
+        return id;
+    }
+
+    void freeNode(int id) {
+        nodes[id].parent = freeList;
+        nodes[id].height = -1;
+        freeList = id;
+    }
+
+    AABB fatten(const AABB& b) const {
+        return { b.minX - margin, b.minY - margin, b.maxX + margin, b.maxY + margin };
+    }
+
+    void insertLeaf(int leaf) {
+        if (root == -1) {
+            root = leaf;
+            nodes[root].parent = -1;
+            return;
+        }
+
+        // find the best sibling
+        AABB leafBox = nodes[leaf].box;
+        int index = root;
+        while (!nodes[index].isLeaf()) {
+            int c1 = nodes[index].child1, c2 = nodes[index].child2;
+            float area = nodes[index].box.perimeter();
+            float combined = AABB::merge(nodes[index].box, leafBox).perimeter();
+
+            float cost = 2.0f * combined;
+            float inheritance = 2.0f * (combined - area);
+
+            auto childCost = [&](int c) {
+                float merged = AABB::merge(leafBox, nodes[c].box).perimeter();
+                if (nodes[c].isLeaf()) return merged + inheritance;
+                return merged - nodes[c].box.perimeter() + inheritance;
+            };
+            float cost1 = childCost(c1), cost2 = childCost(c2);
+
+            if (cost < cost1 && cost < cost2) break;
+            index = cost1 < cost2 ? c1 : c2;
+        }
+
+        int sibling = index;
+        int oldParent = nodes[sibling].parent;
+        int newParent = allocNode();
+        nodes[newParent].parent = oldParent;
+        nodes[newParent].box = AABB::merge(leafBox, nodes[sibling].box);
+        nodes[newParent].height = nodes[sibling].height + 1;
+        nodes[newParent].child1 = sibling;
+        nodes[newParent].child2 = leaf;
+        nodes[sibling].parent = newParent;
+        nodes[leaf].parent = newParent;
+
+        if (oldParent == -1) {
+            root = newParent;
+        } else if (nodes[oldParent].child1 == sibling) {
+            nodes[oldParent].child1 = newParent;
+        } else {
+            nodes[oldParent].child2 = newParent;
+        }
+
+        refit(nodes[leaf].parent);
+    }
+
+    void removeLeaf(int leaf) {
+        if (leaf == root) {
+            root = -1;
+            return;
+        }
+        int parent = nodes[leaf].parent;
+        int grandParent = nodes[parent].parent;
+        int sibling = nodes[parent].child1 == leaf ? nodes[parent].child2 : nodes[parent].child1;
+
+        if (grandParent == -1) {
+            root = sibling;
+            nodes[sibling].parent = -1;
+            freeNode(parent);
+            return;
+        }
+        if (nodes[grandParent].child1 == parent) nodes[grandParent].child1 = sibling;
+        else nodes[grandParent].child2 = sibling;
+        nodes[sibling].parent = grandParent;
+        freeNode(parent);
+        refit(grandParent);
+    }
+
+    // walk up fixing heights and boxes, balancing on the way
+    void refit(int index) {
+        while (index != -1) {
+            index = balance(index);
+            Node& n = nodes[index];
+            n.height = 1 + std::max(nodes[n.child1].height, nodes[n.child2].height);
+            n.box = AABB::merge(nodes[n.child1].box, nodes[n.child2].box);
+            index = n.parent;
+        }
+    }
+
+    // rotate the taller grandchild up if A is unbalanced, returns the new subtree root
+    int balance(int iA) {
+        Node& A = nodes[iA];
+        if (A.isLeaf() || A.height < 2) return iA;
+
+        int iB = A.child1, iC = A.child2;
+        int diff = nodes[iC].height - nodes[iB].height;
+        if (diff > 1) return rotate(iA, iC, iB, true);
+        if (diff < -1) return rotate(iA, iB, iC, false);
+        return iA;
+    }
+
+    // promote `up` (a child of iA) above iA, `other` is iA's other child
+    int rotate(int iA, int up, int other, bool upIsChild2) {
+        int iF = nodes[up].child1, iG = nodes[up].child2;
+
+        nodes[up].child1 = iA;
+        nodes[up].parent = nodes[iA].parent;
+        nodes[iA].parent = up;
+
+        int p = nodes[up].parent;
+        if (p == -1) root = up;
+        else if (nodes[p].child1 == iA) nodes[p].child1 = up;
+        else nodes[p].child2 = up;
+
+        // keep the taller grandchild under `up`, give the other one to iA
+        int keep = nodes[iF].height > nodes[iG].height ? iF : iG;
+        int give = keep == iF ? iG : iF;
+        nodes[up].child2 = keep;
+        if (upIsChild2) nodes[iA].child2 = give;
+        else nodes[iA].child1 = give;
+        nodes[give].parent = iA;
+
+        nodes[iA].box = AABB::merge(nodes[other].box, nodes[give].box);
+        nodes[iA].height = 1 + std::max(nodes[other].height, nodes[give].height);
+        nodes[up].box = AABB::merge(nodes[iA].box, nodes[keep].box);
+        nodes[up].height = 1 + std::max(nodes[iA].height, nodes[keep].height);
+        return up;
+    }
+
+    template <typename Overlap, typename Visit>
+    void traverse(Overlap overlap, Visit visit) const {
+        if (root == -1) return;
+        int stack[256];
+        std::vector<int> spill; // only used by pathological trees
+        int top = 0;
+        stack[top++] = root;
+        while (top > 0 || !spill.empty()) {
+            int id;
+            if (!spill.empty()) { id = spill.back(); spill.pop_back(); }
+            else id = stack[--top];
+
+            const Node& n = nodes[id];
+            if (!overlap(n.box)) continue;
+            if (n.isLeaf()) {
+                visit(n.handle);
+                continue;
+            }
+            if (top + 2 <= 256) {
+                stack[top++] = n.child1;
+                stack[top++] = n.child2;
+            } else {
+                spill.push_back(n.child1);
+                spill.push_back(n.child2);
+            }
+        }
+    }
+
+public:
+    explicit AABBTree(float margin) : margin(margin) {}
+
+    int insert(const AABB& box) override {
+        int handle;
+        if (!freeHandles.empty()) {
+            handle = freeHandles.back();
+            freeHandles.pop_back();
+        } else {
+            handle = (int)leafOf.size();
+            leafOf.push_back(-1);
+            tight.push_back(box);
+        }
+        int leaf = allocNode();
+        nodes[leaf].box = fatten(box);
+        nodes[leaf].handle = handle;
+        nodes[leaf].height = 0;
+        insertLeaf(leaf);
+
+        leafOf[handle] = leaf;
+        tight[handle] = box;
+        live++;
+        return handle;
+    }
+
+    void move(int handle, const AABB& box) override {
+        tight[handle] = box;
+        int leaf = leafOf[handle];
+        if (nodes[leaf].box.contains(box)) return; // still inside the fat box
+        removeLeaf(leaf);
+        nodes[leaf].box = fatten(box);
+        insertLeaf(leaf);
+    }
+
+    void remove(int handle) override {
+        int leaf = leafOf[handle];
+        removeLeaf(leaf);
+        freeNode(leaf);
+        leafOf[handle] = -1;
+        freeHandles.push_back(handle);
+        live--;
+    }
+
+    void clear() override {
+        nodes.clear();
+        leafOf.clear();
+        tight.clear();
+        freeHandles.clear();
+        root = freeList = -1;
+        live = 0;
+    }
+
+    int count() const override { return live; }
+
+    bool valid(int handle) const override {
+        return handle >= 0 && handle < (int)leafOf.size() && leafOf[handle] != -1;
+    }
+
+    void queryRect(const AABB& box, std::vector<int>& out) const override {
+        traverse([&](const AABB& b) { return b.overlaps(box); },
+                 [&](int h) { if (tight[h].overlaps(box)) out.push_back(h); });
+    }
+
+    void queryCircle(float cx, float cy, float r, std::vector<int>& out) const override {
+        traverse([&](const AABB& b) { return circleOverlaps(b, cx, cy, r); },
+                 [&](int h) { if (circleOverlaps(tight[h], cx, cy, r)) out.push_back(h); });
+    }
+
+    void raycast(float x1, float y1, float x2, float y2, std::vector<int>& out) const override {
+        float dx = x2 - x1, dy = y2 - y1;
+        std::vector<std::pair<float, int>> hits;
+        traverse([&](const AABB& b) { return segmentOverlaps(b, x1, y1, dx, dy, nullptr); },
+                 [&](int h) {
+                     float t;
+                     if (segmentOverlaps(tight[h], x1, y1, dx, dy, &t)) hits.push_back({ t, h });
+                 });
+        std::sort(hits.begin(), hits.end());
+        for (auto& hit : hits) out.push_back(hit.second);
+    }
+
+    void pairs(std::vector<int>& out) const override {
+        for (int h = 0; h < (int)leafOf.size(); h++) {
+            if (leafOf[h] == -1) continue;
+            const AABB& box = tight[h];
+            traverse([&](const AABB& b) { return b.overlaps(box); },
+                     [&](int other) {
+                         if (other > h && tight[other].overlaps(box)) {
+                             out.push_back(h);
+                             out.push_back(other);
+                         }
+                     });
+        }
+    }
+};
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Loose uniform grid
+// Each object lives in the one cell containing its center; queries widen the
+// searched cells by the largest half extent seen so objects spilling over
+// cell borders are still found. Moving inside a cell is O(1).
+// ─────────────────────────────────────────────────────────────────────────────
+
+class LooseGrid : public SpatialIndex {
+    struct Entry {
+        AABB box;
+        int64_t cell; // INT64_MIN when removed
+        int slot;     // index inside the cell vector
+    };
+
+    float cellSize, invCell;
+    float maxHalfX = 0, maxHalfY = 0;
+    std::vector<Entry> entries;
+    std::vector<int> freeHandles;
+    std::unordered_map<int64_t, std::vector<int>> cells;
+    int live = 0;
+
+    static int64_t key(int cx, int cy) {
+        return ((int64_t)cx << 32) ^ (uint32_t)cy;
+    }
+
+    int cellCoord(float v) const { return (int)std::floor(v * invCell); }
+
+    int64_t cellOf(const AABB& b) const {
+        return key(cellCoord((b.minX + b.maxX) * 0.5f), cellCoord((b.minY + b.maxY) * 0.5f));
+    }
+
+    void link(int handle) {
+        Entry& e = entries[handle];
+        std::vector<int>& cell = cells[e.cell];
+        e.slot = (int)cell.size();
+        cell.push_back(handle);
+
+        maxHalfX = std::max(maxHalfX, (e.box.maxX - e.box.minX) * 0.5f);
+        maxHalfY = std::max(maxHalfY, (e.box.maxY - e.box.minY) * 0.5f);
+    }
+
+    void unlink(int handle) {
+        Entry& e = entries[handle];
+        auto it = cells.find(e.cell);
+        std::vector<int>& cell = it->second;
+        int last = cell.back();
+        cell[e.slot] = last;
+        entries[last].slot = e.slot;
+        cell.pop_back();
+        if (cell.empty()) cells.erase(it);
+    }
+
+    // visits every handle whose center cell can hold something overlapping `area`
+    template <typename Visit>
+    void visitCells(const AABB& area, Visit visit) const {
+        int x0 = cellCoord(area.minX - maxHalfX), x1 = cellCoord(area.maxX + maxHalfX);
+        int y0 = cellCoord(area.minY - maxHalfY), y1 = cellCoord(area.maxY + maxHalfY);
+
+        // huge queries over a sparse grid: walk the cells instead
+        if ((int64_t)(x1 - x0 + 1) * (y1 - y0 + 1) > (int64_t)cells.size()) {
+            for (const auto& c : cells)
+                for (int h : c.second) visit(h);
+            return;
+        }
+        for (int cy = y0; cy <= y1; cy++) {
+            for (int cx = x0; cx <= x1; cx++) {
+                auto it = cells.find(key(cx, cy));
+                if (it == cells.end()) continue;
+                for (int h : it->second) visit(h);
+            }
+        }
+    }
+
+public:
+    explicit LooseGrid(float cellSize) : cellSize(cellSize), invCell(1.0f / cellSize) {}
+
+    int insert(const AABB& box) override {
+        int handle;
+        if (!freeHandles.empty()) {
+            handle = freeHandles.back();
+            freeHandles.pop_back();
+        } else {
+            handle = (int)entries.size();
+            entries.push_back({});
+        }
+        entries[handle] = { box, cellOf(box), 0 };
+        link(handle);
+        live++;
+        return handle;
+    }
+
+    void move(int handle, const AABB& box) override {
+        Entry& e = entries[handle];
+        int64_t cell = cellOf(box);
+        if (cell == e.cell) {
+            e.box = box;
+            maxHalfX = std::max(maxHalfX, (box.maxX - box.minX) * 0.5f);
+            maxHalfY = std::max(maxHalfY, (box.maxY - box.minY) * 0.5f);
+            return;
+        }
+        unlink(handle);
+        e.box = box;
+        e.cell = cell;
+        link(handle);
+    }
+
+    void remove(int handle) override {
+        unlink(handle);
+        entries[handle].cell = INT64_MIN;
+        freeHandles.push_back(handle);
+        live--;
+    }
+
+    void clear() override {
+        entries.clear();
+        freeHandles.clear();
+        cells.clear();
+        maxHalfX = maxHalfY = 0;
+        live = 0;
+    }
+
+    int count() const override { return live; }
+
+    bool valid(int handle) const override {
+        return handle >= 0 && handle < (int)entries.size() && entries[handle].cell != INT64_MIN;
+    }
+
+    void queryRect(const AABB& box, std::vector<int>& out) const override {
+        visitCells(box, [&](int h) { if (entries[h].box.overlaps(box)) out.push_back(h); });
+    }
+
+    void queryCircle(float cx, float cy, float r, std::vector<int>& out) const override {
+        AABB area = { cx - r, cy - r, cx + r, cy + r };
+        visitCells(area, [&](int h) { if (circleOverlaps(entries[h].box, cx, cy, r)) out.push_back(h); });
+    }
+
+    void raycast(float x1, float y1, float x2, float y2, std::vector<int>& out) const override {
+        float dx = x2 - x1, dy = y2 - y1;
+        AABB area = { std::min(x1, x2), std::min(y1, y2), std::max(x1, x2), std::max(y1, y2) };
+        std::vector<std::pair<float, int>> hits;
+        visitCells(area, [&](int h) {
+            float t;
+            if (segmentOverlaps(entries[h].box, x1, y1, dx, dy, &t)) hits.push_back({ t, h });
+        });
+        std::sort(hits.begin(), hits.end());
+        for (auto& hit : hits) out.push_back(hit.second);
+    }
+
+    void pairs(std::vector<int>& out) const override {
+        for (const auto& c : cells) {
+            for (int h : c.second) {
+                const AABB& box = entries[h].box;
+                visitCells(box, [&](int other) {
+                    if (other > h && entries[other].box.overlaps(box)) {
+                        out.push_back(h);
+                        out.push_back(other);
+                    }
+                });
+            }
+        }
+    }
+};
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Lua bindings
+// Handles are 0-based internally and 1-based in Lua.
+// ─────────────────────────────────────────────────────────────────────────────
+
+// scratch vector reused by every query
+static std::vector<int> spatialResults;
+
+static int checkHandle(lua_State* L, SpatialIndex* index, int arg) {
+    int handle = (int)luaL_checkinteger(L, arg) - 1;
+    if (!index->valid(handle)) luaL_argerror(L, arg, "invalid handle");
+    return handle;
+}
+
+// rect as (x, y, w, h) numbers or as a {x, y, width, height} table
+static AABB checkRect(lua_State* L, int arg) {
+    float x, y, w, h;
+    if (lua_istable(L, arg)) {
+        x = getArgByName(L, "x", arg);
+        y = getArgByName(L, "y", arg);
+        w = getArgByName(L, "width", arg);
+        h = getArgByName(L, "height", arg);
+    } else {
+        x = luaL_checknumber(L, arg);
+        y = luaL_checknumber(L, arg + 1);
+        w = luaL_checknumber(L, arg + 2);
+        h = luaL_checknumber(L, arg + 3);
+    }
+    return { x, y, x + w, y + h };
+}
+
+// Writes results into the table or i32 Buffer at `outArg` (reused when given)
+// and returns it plus the count. A buffer gets as many handles as fit, the
+// count is always the full number of results.
+static int pushResults(lua_State* L, int outArg) {
+    int n = (int)spatialResults.size();
+    if (Buffer* buf = testBuffer(L, outArg)) {
+        checkBufferType(L, outArg, BUFFER_I32);
+        int32_t* out = buf->as<int32_t>();
+        int fit = std::min(n, (int)buf->count);
+        for (int i = 0; i < fit; i++) out[i] = spatialResults[i] + 1;
+        lua_pushvalue(L, outArg);
+        lua_pushinteger(L, n);
+        return 2;
+    }
+    if (lua_istable(L, outArg)) {
+        lua_pushvalue(L, outArg);
+        int old = (int)lua_rawlen(L, -1);
+        for (int i = n; i < old; i++) {
+            lua_pushnil(L);
+            lua_rawseti(L, -2, i + 1);
+        }
+    } else {
+        lua_createtable(L, n, 0);
+    }
+    for (int i = 0; i < n; i++) {
+        lua_pushinteger(L, spatialResults[i] + 1);
+        lua_rawseti(L, -2, i + 1);
+    }
+    lua_pushinteger(L, n);
+    return 2;
+}
+
+// index:insert(x, y, w, h) or index:insert(rect) -> handle
+static int l_SpatialInsert(lua_State* L) {
+    SpatialIndex* index = getPtr<SpatialIndex>(L, 1);
+    lua_pushinteger(L, index->insert(checkRect(L, 2)) + 1);
+    return 1;
+}
+
+// index:move(handle, x, y, w, h) or index:move(handle, rect)
+static int l_SpatialMove(lua_State* L) {
+    SpatialIndex* index = getPtr<SpatialIndex>(L, 1);
+    int handle = checkHandle(L, index, 2);
+    index->move(handle, checkRect(L, 3));
+    return 0;
+}
+
+// index:moveBatch(handles, rects) - handles is an i32 buffer, rects an f32
+// buffer of x, y, w, h per handle
+static int l_SpatialMoveBatch(lua_State* L) {
+    SpatialIndex* index = getPtr<SpatialIndex>(L, 1);
+    Buffer* handles = checkBufferType(L, 2, BUFFER_I32);
+    Buffer* rects = checkBufferType(L, 3, BUFFER_F32);
+    luaL_argcheck(L, rects->count == handles->count * 4, 3, "expected 4 numbers per handle");
+
+    const int32_t* h = handles->as<int32_t>();
+    const float* r = rects->as<float>();
+    for (size_t i = 0; i < handles->count; i++) {
+        int handle = h[i] - 1;
+        if (!index->valid(handle)) return luaL_error(L, "invalid handle %d at index %d", (int)h[i], (int)i + 1);
+        const float* rect = r + i * 4;
+        index->move(handle, { rect[0], rect[1], rect[0] + rect[2], rect[1] + rect[3] });
+    }
+    return 0;
+}
+
+static int l_SpatialRemove(lua_State* L) {
+    SpatialIndex* index = getPtr<SpatialIndex>(L, 1);
+    index->remove(checkHandle(L, index, 2));
+    return 0;
+}
+
+static int l_SpatialClear(lua_State* L) {
+    getPtr<SpatialIndex>(L, 1)->clear();
+    return 0;
+}
+
+static int l_SpatialCount(lua_State* L) {
+    lua_pushinteger(L, getPtr<SpatialIndex>(L, 1)->count());
+    return 1;
+}
+
+// index:queryRect(x, y, w, h[, out]) or index:queryRect(rect[, out]) -> handles, count
+static int l_SpatialQueryRect(lua_State* L) {
+    SpatialIndex* index = getPtr<SpatialIndex>(L, 1);
+    int outArg = lua_istable(L, 2) ? 3 : 6;
+    spatialResults.clear();
+    index->queryRect(checkRect(L, 2), spatialResults);
+    return pushResults(L, outArg);
+}
+
+// index:queryCircle(x, y, radius[, out]) -> handles, count
+static int l_SpatialQueryCircle(lua_State* L) {
+    SpatialIndex* index = getPtr<SpatialIndex>(L, 1);
+    float x = luaL_checknumber(L, 2), y = luaL_checknumber(L, 3), r = luaL_checknumber(L, 4);
+    spatialResults.clear();
+    index->queryCircle(x, y, r, spatialResults);
+    return pushResults(L, 5);
+}
+
+// index:raycast(x1, y1, x2, y2[, out]) -> handles sorted by distance, count
+static int l_SpatialRaycast(lua_State* L) {
+    SpatialIndex* index = getPtr<SpatialIndex>(L, 1);
+    float x1 = luaL_checknumber(L, 2), y1 = luaL_checknumber(L, 3);
+    float x2 = luaL_checknumber(L, 4), y2 = luaL_checknumber(L, 5);
+    spatialResults.clear();
+    index->raycast(x1, y1, x2, y2, spatialResults);
+    return pushResults(L, 6);
+}
+
+// index:pairs([out]) -> {a1, b1, a2, b2, ...}, number of entries
+static int l_SpatialPairs(lua_State* L) {
+    SpatialIndex* index = getPtr<SpatialIndex>(L, 1);
+    spatialResults.clear();
+    index->pairs(spatialResults);
+    return pushResults(L, 2);
+}
+
+static int l_SpatialGC(lua_State* L) {
+    delete getPtr<SpatialIndex>(L, 1);
+    return 0;
+}
+
+static void registerSpatialClass(lua_State* L) {
+    const char* type = typeid(SpatialIndex).name();
+    if (luaL_newmetatable(L, type)) {
+        lua_pushstring(L, "__index");
+        lua_newtable(L);
+
+        static luaL_Reg methods[] = {
+            { "insert", l_SpatialInsert },
+            { "move", l_SpatialMove },
+            { "moveBatch", l_SpatialMoveBatch },
+            { "remove", l_SpatialRemove },
+            { "clear", l_SpatialClear },
+            { "count", l_SpatialCount },
+            { "queryRect", l_SpatialQueryRect },
+            { "queryCircle", l_SpatialQueryCircle },
+            { "raycast", l_SpatialRaycast },
+            { "pairs", l_SpatialPairs },
+            { NULL, NULL }
+        };
+        push_funcs(L, methods);
+        lua_settable(L, -3); // metatable.__index = table
+
+        // plain CPU memory, safe to free whenever Lua is done with it
+        lua_pushcfunction(L, l_SpatialGC);
+        lua_setfield(L, -2, "__gc");
+    }
+    lua_pop(L, 1);
+}
+
+// Spatial.newTree([margin])
+static int l_NewTree(lua_State* L) {
+    float margin = luaL_optnumber(L, 1, 4.0);
+    pushPtr<SpatialIndex>(L, new AABBTree(margin));
+    return 1;
+}
+
+// Spatial.newGrid(cellSize)
+static int l_NewGrid(lua_State* L) {
+    float cellSize = luaL_checknumber(L, 1);
+    luaL_argcheck(L, cellSize > 0, 1, "cell size must be positive");
+    pushPtr<SpatialIndex>(L, new LooseGrid(cellSize));
+    return 1;
+}
+
+extern "C" int luaopen_spatial(lua_State* L) {
+    registerSpatialClass(L);
+    registerBufferClass(L);
+
+    lua_newtable(L);
+
+    lua_pushcfunction(L, l_NewTree);
+    lua_setfield(L, -2, "newTree");
+
+    lua_pushcfunction(L, l_NewGrid);
+    lua_setfield(L, -2, "newGrid");
+
+    return 1;
+}
@@ -1,10 +1,13 @@
 #include "../libs/lua_ffi.hpp"
 #include "funcs.cpp"
 #include "libs/raylib/raylib.cpp"
+#include "libs/profiler/profiler.cpp"
 #include <dlfcn.h>
 #include <lua.h>
 #include <lua.hpp>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 
 static int loadLib(lua_State *L) {
@@ -66,9 +69,41 @@ void pushArgvToLuaTable(lua_State *L, int argc, const char *argv[]) {
   lua_settable(L, -3);        // Set the table at index 0
 }
 
+static void usage(const char *prog) {
+  printf("Usage: %s [options] <lua file> [args...]\n", prog);
+  printf("Options:\n");
+  printf("  --profile <out.folded>  sample the script and write folded stacks\n");
+  printf("  --headless              render offscreen, see the Headless module\n");
+  printf("  --frames <n>            make WindowShouldClose return true after n frames\n");
+}
+
 int main(int argc, char const *argv[]) {
+  const char *prog = argv[0];
+  const char *profilePath = nullptr;
+
+  // rocket options come before the script, everything after it goes to arg
+  int first = 1;
+  while (first < argc && strncmp(argv[first], "--", 2) == 0) {
+    if (strcmp(argv[first], "--profile") == 0 && first + 1 < argc) {
+      profilePath = argv[first + 1];
+      first += 2;
+    } else if (strcmp(argv[first], "--headless") == 0) {
+      rocketHeadless = true;
+      first += 1;
+    } else if (strcmp(argv[first], "--frames") == 0 && first + 1 < argc) {
+      headlessFrameLimit = atoi(argv[first + 1]);
+      first += 2;
+    } else {
+      printf("Unknown option: %s\n", argv[first]);
+      usage(prog);
+      return 1;
+    }
+  }
+  argc -= first - 1;
+  argv += first - 1;
+
   if (argc < 2) {
-    printf("Usage: %s <lua file>\n", argv[0]);
+    usage(prog);
     return 1;
   }
 
@@ -78,15 +113,22 @@ int main(int argc, char const *argv[]) {
   lua_setglobal(L, "arg"); // Set the table as a global variable named "args"
   lua_pushboolean(L, true);
   lua_setglobal(L, "isRocket");
+  if (profilePath)
+    profiler::start(L);
+
   int res = luaL_dofile(L, argv[1]); // Load Lua script
   if (res != LUA_OK) {
     printf("Error loading Lua script: %s\n", lua_tostring(L, -1));
+    if (profilePath)
+      profiler::stop(L, profilePath);
     lua_close(L);
     return 1;
   }
 
   lua_getglobal(L, "main");
   res = lua_pcall(L, 0, 0, 0);
+  if (profilePath)
+    profiler::stop(L, profilePath);
   if (res != LUA_OK) {
     printf("%s\n", lua_tostring(L, -1));
     lua_close(L);
@@ -0,0 +1,172 @@
+// pack.cpp - builds .pak asset archives (libs/pack/pack.hpp)
+// built and run by `rocket build.lua pack`
+//
+// usage: bin/pack output.pak directory [--align n] [--no-lz4]
+//
+// Every file under directory goes in, named by its path relative to it
+// ("sprites/player.png"). Files are LZ4 compressed when that saves at least
+// an eighth of their size (already compressed formats like PNG or OGG
+// usually stay stored, so they are read straight from the mapping), data
+// offsets are aligned to --align bytes (16 by default) and files with the
+// same contents are stored once.
+#include "../libs/pack/pack.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct InputFile {
+    std::string name;
+    std::vector<uint8_t> stored;
+    PackEntry entry;
+};
+
+static void usage() {
+    fprintf(stderr, "usage: pack output.pak directory [--align n] [--no-lz4]\n");
+}
+
+static bool readWholeFile(const std::filesystem::path& path, std::vector<uint8_t>& out) {
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file) return false;
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    out.resize(size > 0 ? size : 0);
+    bool ok = size >= 0 && fread(out.data(), 1, out.size(), file) == out.size();
+    fclose(file);
+    return ok;
+}
+
+int main(int argc, char** argv) {
+    const char* output = nullptr;
+    const char* dir = nullptr;
+    uint32_t alignment = 16;
+    bool lz4 = true;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--align") == 0 && i + 1 < argc) {
+            alignment = (uint32_t)atoi(argv[++i]);
+            if (alignment == 0 || alignment > 4096 || (alignment & (alignment - 1)) != 0) {
+                fprintf(stderr, "pack: alignment must be a power of two up to 4096\n");
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--no-lz4") == 0) {
+            lz4 = false;
+        } else if (!output) {
+            output = argv[i];
+        } else if (!dir) {
+            dir = argv[i];
+        } else {
+            usage();
+            return 1;
+        }
+    }
+    if (!output || !dir) {
+        usage();
+        return 1;
+    }
+
+    std::vector<InputFile> files;
+    std::error_code ec;
+    for (auto it = std::filesystem::recursive_directory_iterator(dir, ec); !ec && it != std::filesystem::recursive_directory_iterator(); it.increment(ec)) {
+        if (!it->is_regular_file()) continue;
+        InputFile f;
+        f.name = it->path().lexically_relative(dir).generic_string();
+        f.entry = PackEntry{};
+        std::vector<uint8_t> raw;
+        if (!readWholeFile(it->path(), raw)) {
+            fprintf(stderr, "pack: cannot read '%s'\n", it->path().c_str());
+            return 1;
+        }
+        f.entry.rawSize = raw.size();
+        f.entry.hash = packHash(raw.data(), raw.size());
+
+        if (lz4 && !raw.empty()) {
+            f.stored.resize(lz4Bound(raw.size()));
+            size_t n = lz4Compress(raw.data(), raw.size(), f.stored.data());
+            if (n <= raw.size() - raw.size() / 8) {
+                f.stored.resize(n);
+                f.entry.flags |= PACK_LZ4;
+            }
+        }
+        if (!(f.entry.flags & PACK_LZ4)) f.stored.swap(raw);
+        f.entry.size = f.stored.size();
+        files.push_back(std::move(f));
+    }
+    if (ec) {
+        fprintf(stderr, "pack: cannot read directory '%s': %s\n", dir, ec.message().c_str());
+        return 1;
+    }
+
+    // the index is binary searched by name
+    std::sort(files.begin(), files.end(), [](const InputFile& a, const InputFile& b) { return a.name < b.name; });
+
+    PackHeader header = {};
+    memcpy(header.magic, PACK_MAGIC, 4);
+    header.version = PACK_VERSION;
+    header.count = (uint32_t)files.size();
+    header.alignment = alignment;
+    header.namesOffset = sizeof(PackHeader) + files.size() * sizeof(PackEntry);
+
+    std::string names;
+    for (InputFile& f : files) {
+        f.entry.nameOffset = (uint32_t)names.size();
+        f.entry.nameLength = (uint32_t)f.name.size();
+        names += f.name;
+    }
+    header.namesSize = names.size();
+
+    // lay out the data, sharing it between files with the same contents
+    uint64_t offset = header.namesOffset + header.namesSize;
+    std::vector<size_t> order; // files whose data gets written, in file order
+    std::unordered_map<uint64_t, std::vector<size_t>> byHash;
+    for (size_t i = 0; i < files.size(); i++) {
+        InputFile& f = files[i];
+        const InputFile* same = nullptr;
+        for (size_t j : byHash[f.entry.hash]) {
+            const InputFile& o = files[j];
+            if (o.entry.rawSize == f.entry.rawSize && o.entry.flags == f.entry.flags && o.stored == f.stored) {
+                same = &o;
+                break;
+            }
+        }
+        if (same) {
+            f.entry.offset = same->entry.offset;
+            continue;
+        }
+        offset = (offset + alignment - 1) & ~(uint64_t)(alignment - 1);
+        f.entry.offset = offset;
+        offset += f.entry.size;
+        order.push_back(i);
+        byHash[f.entry.hash].push_back(i);
+    }
+
+    FILE* file = fopen(output, "wb");
+    if (!file) {
+        fprintf(stderr, "pack: cannot open '%s' for writing\n", output);
+        return 1;
+    }
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    for (const InputFile& f : files) ok = ok && fwrite(&f.entry, sizeof(PackEntry), 1, file) == 1;
+    ok = ok && fwrite(names.data(), 1, names.size(), file) == names.size();
+    uint64_t written = header.namesOffset + header.namesSize;
+    static const uint8_t zeros[4096] = {};
+    for (size_t i : order) {
+        const InputFile& f = files[i];
+        uint64_t pad = f.entry.offset - written;
+        ok = ok && fwrite(zeros, 1, pad, file) == pad;
+        ok = ok && fwrite(f.stored.data(), 1, f.stored.size(), file) == f.stored.size();
+        written = f.entry.offset + f.entry.size;
+    }
+    ok = fclose(file) == 0 && ok;
+    if (!ok) {
+        fprintf(stderr, "pack: error writing '%s'\n", output);
+        return 1;
+    }
+    printf("pack: %zu files, %zu stored, %llu bytes\n", files.size(), order.size(), (unsigned long long)written);
+    return 0;
+}
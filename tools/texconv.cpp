@@ -0,0 +1,107 @@
+// texconv.cpp - converts images to .rtex containers (libs/rtex.hpp)
+// built by `rocket build.lua texconv`
+//
+// usage: bin/texconv input output.rtex [--format name] [--no-mipmaps]
+//                    [--no-premultiply] [--no-lz4]
+//
+// By default the pixels are premultiplied, get a full mip chain and are LZ4
+// compressed on disk. --format converts them to a smaller GPU format:
+// rgba8 (default), rgb8, rgb565, rgba5551, rgba4444, gray, grayalpha.
+// Block compressed inputs (DXT/ETC in .dds, .ktx or .pkm files) are stored
+// as they are: raylib loads them but cannot re-encode or mipmap them.
+#include "../libs/rtex.hpp"
+#include <raylib.h>
+#include <cstdio>
+#include <cstring>
+
+struct FormatName {
+    const char* name;
+    int format;
+};
+
+static const FormatName formatNames[] = {
+    { "rgba8", PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 },
+    { "rgb8", PIXELFORMAT_UNCOMPRESSED_R8G8B8 },
+    { "rgb565", PIXELFORMAT_UNCOMPRESSED_R5G6B5 },
+    { "rgba5551", PIXELFORMAT_UNCOMPRESSED_R5G5B5A1 },
+    { "rgba4444", PIXELFORMAT_UNCOMPRESSED_R4G4B4A4 },
+    { "gray", PIXELFORMAT_UNCOMPRESSED_GRAYSCALE },
+    { "grayalpha", PIXELFORMAT_UNCOMPRESSED_GRAY_ALPHA },
+};
+
+static void usage() {
+    fprintf(stderr, "usage: texconv input output.rtex [--format name] [--no-mipmaps] [--no-premultiply] [--no-lz4]\n");
+}
+
+int main(int argc, char** argv) {
+    const char* input = nullptr;
+    const char* output = nullptr;
+    int format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8;
+    bool mipmaps = true, premultiply = true, lz4 = true;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--format") == 0 && i + 1 < argc) {
+            const char* name = argv[++i];
+            format = 0;
+            for (const FormatName& f : formatNames)
+                if (strcmp(f.name, name) == 0) format = f.format;
+            if (!format) {
+                fprintf(stderr, "texconv: unknown format '%s'\n", name);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--no-mipmaps") == 0) {
+            mipmaps = false;
+        } else if (strcmp(argv[i], "--no-premultiply") == 0) {
+            premultiply = false;
+        } else if (strcmp(argv[i], "--no-lz4") == 0) {
+            lz4 = false;
+        } else if (!input) {
+            input = argv[i];
+        } else if (!output) {
+            output = argv[i];
+        } else {
+            usage();
+            return 1;
+        }
+    }
+    if (!input || !output) {
+        usage();
+        return 1;
+    }
+
+    SetTraceLogLevel(LOG_WARNING);
+    Image image = LoadImage(input);
+    if (!image.data) {
+        fprintf(stderr, "texconv: cannot load '%s'\n", input);
+        return 1;
+    }
+
+    RtexHeader header = {};
+    if (image.format >= PIXELFORMAT_COMPRESSED_DXT1_RGB) {
+        fprintf(stderr, "texconv: '%s' is block compressed, stored as is\n", input);
+        premultiply = false;
+    } else {
+        if (premultiply) ImageAlphaPremultiply(&image);
+        if (mipmaps) ImageMipmaps(&image);
+        if (image.format != format) ImageFormat(&image, format);
+    }
+    header.width = image.width;
+    header.height = image.height;
+    header.mipmaps = image.mipmaps;
+    header.format = image.format;
+    header.flags = (premultiply ? RTEX_PREMULTIPLIED : 0) | (lz4 ? RTEX_LZ4 : 0);
+    header.rawSize = rtexMipChainSize(image.width, image.height, image.mipmaps, image.format);
+    if (header.rawSize == 0) {
+        fprintf(stderr, "texconv: %s: images are limited to %dx%d\n", input, RTEX_MAX_SIZE, RTEX_MAX_SIZE);
+        UnloadImage(image);
+        return 1;
+    }
+
+    const char* err = rtexSave(output, header, image.data);
+    UnloadImage(image);
+    if (err) {
+        fprintf(stderr, "texconv: %s: %s\n", output, err);
+        return 1;
+    }
+    return 0;
+}